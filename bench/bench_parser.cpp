@@ -0,0 +1,239 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "incremental.h"
+#include "input.h"
+#include "key_shapes.h"
+#include "lexer.h"
+#include "parser.h"
+#include "snapshot.h"
+#include "token_buffer.h"
+#include "validator.h"
+
+// Throughput and memory comparison of the Validator and the Lexer/Parser
+// pipeline. Usage: bench_parser [file.json]. Without a file a synthetic
+// document of ~8 MB of small records is generated.
+
+static std::string generateDocument(size_t records) {
+    std::string json = "[";
+    for (size_t i = 0; i < records; i++) {
+        if (i > 0) json += ",\n";
+        std::string id = std::to_string(i);
+        json += "{\"id\": " + id + ", \"name\": \"user " + id +
+                "\", \"active\": " + (i % 3 ? "true" : "false") +
+                ", \"score\": " + id + ".25, \"tags\": [\"alpha\", \"beta\"]" +
+                ", \"address\": {\"city\": \"Springfield\", \"zip\": null}" +
+                (i % 10 ? "" : ", \"note\": \"line\\none \\u00e9\"") + "}";
+    }
+    json += "]";
+    return json;
+}
+
+// Best wall time in seconds of `runs` calls to `fn`
+template <typename Fn>
+static double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+static void report(const char* name, size_t bytes, double seconds) {
+    std::printf("%-28s %9.2f ms %9.1f MB/s\n", name, seconds * 1e3,
+                bytes / seconds / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+    std::string json;
+    if (argc > 1) {
+        if (!readFile(argv[1], json)) {
+            std::cerr << "Cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        json = generateDocument(60000);
+    }
+    const int runs = 5;
+    bool ok = true;
+
+    std::printf("Input: %zu bytes\n\n", json.size());
+
+    double validate = bestOf(runs, [&]() {
+        ok = Validator::validate(json).ok() && ok;
+    });
+
+    size_t tokenCount = 0;
+    size_t vectorBytes = 0;
+    double vectorPipeline = bestOf(runs, [&]() {
+        Lexer lexer(json.data(), json.size());
+        std::vector<Token> tokens;
+        ok = lexer.tryTokenize(tokens).ok() && ok;
+
+        tokenCount = tokens.size();
+        vectorBytes = tokens.capacity() * sizeof(Token);
+        for (const Token& token : tokens) {
+            // Lexemes that don't fit the small-string buffer own heap memory
+            if (token.lexeme.capacity() > sizeof(std::string) - 1) {
+                vectorBytes += token.lexeme.capacity() + 1;
+            }
+        }
+
+        Parser parser(std::move(tokens));
+        ok = parser.tryParse().ok() && ok;
+    });
+
+    double strictPipeline = bestOf(runs, [&]() {
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        ok = lexer.tryTokenize(tokens).ok() && ok;
+
+        Parser parser(std::move(tokens));
+        parser.checkDuplicateKeys(&lexer);
+        ok = parser.tryParse().ok() && ok;
+    });
+
+    std::vector<uint64_t> hashes;
+    double hashedPipeline = bestOf(runs, [&]() {
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        ok = lexer.tryTokenize(tokens).ok() && ok;
+
+        Parser parser(std::move(tokens));
+        ok = parser.tryParseHashed(lexer, hashes).ok() && ok;
+    });
+
+    size_t compactBytes = 0;
+    double compactPipeline = bestOf(runs, [&]() {
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        ok = lexer.tryTokenize(tokens).ok() && ok;
+        compactBytes = tokens.memoryUsage();
+
+        Parser parser(std::move(tokens));
+        ok = parser.tryParse().ok() && ok;
+    });
+
+    KeyShapes shapes;
+    double predictedPipeline = bestOf(runs, [&]() {
+        Lexer lexer(json.data(), json.size());
+        lexer.predictKeys(&shapes);
+        TokenBuffer tokens;
+        ok = lexer.tryTokenize(tokens).ok() && ok;
+
+        Parser parser(std::move(tokens));
+        ok = parser.tryParse().ok() && ok;
+    });
+
+    // Reading every string value: eager copies versus lazy views
+    Lexer lexer(json.data(), json.size());
+    TokenBuffer tokens;
+    ok = lexer.tryTokenize(tokens).ok() && ok;
+    size_t checksum = 0;
+    double copyStrings = bestOf(runs, [&]() {
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens.type(i) == TokenType::STRING) {
+                checksum += lexer.lexeme(tokens, i).size();
+            }
+        }
+    });
+    double viewStrings = bestOf(runs, [&]() {
+        std::string scratch;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens.type(i) == TokenType::STRING) {
+                checksum += lexer.string(tokens, i, scratch).size;
+            }
+        }
+    });
+
+    // Building a Document versus mapping its snapshot back
+    double parseDocument = bestOf(runs, [&]() {
+        Document document;
+        ok = document.parse(json).ok() && ok;
+    });
+    Document document;
+    ok = document.parse(json).ok() && ok;
+    const std::string snapshotPath = "build/bench_snapshot.snap";
+    ok = Snapshot::write(document.view(), snapshotPath).ok() && ok;
+    double openSnapshot = bestOf(runs, [&]() {
+        Snapshot snapshot;
+        ok = snapshot.open(snapshotPath).ok() && ok;
+        checksum += snapshot.root().size();
+    });
+    std::remove(snapshotPath.c_str());
+
+    // Key lookups in an object of 10000 members, scanned or indexed
+    std::string wide = "{";
+    for (int i = 0; i < 10000; i++) {
+        wide += (i > 0 ? ", \"key" : "\"key") + std::to_string(i) +
+                "\": " + std::to_string(i);
+    }
+    wide += "}";
+    Document wideDocument;
+    ok = wideDocument.parse(wide).ok() && ok;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 10000; i += 7) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    DocumentView unindexed = wideDocument.view();
+    unindexed.objectIndex = nullptr;
+    double scanLookups = bestOf(runs, [&]() {
+        for (const std::string& key : keys) {
+            checksum += Value(&unindexed, 0)[key].asInt64();
+        }
+    });
+    double indexedLookups = bestOf(runs, [&]() {
+        for (const std::string& key : keys) {
+            checksum += wideDocument.root()[key].asInt64();
+        }
+    });
+
+    // Re-checking after a small edit versus parsing everything again
+    IncrementalParser incremental;
+    ok = incremental.parse(json).ok() && ok;
+    size_t editAt = json.find("\"active\": ", json.size() / 2) + 10;
+    double editDocument = bestOf(runs, [&]() {
+        bool isTrue = incremental.text()[editAt] == 't';
+        ParseResult result = isTrue ? incremental.edit(editAt, 4, "false")
+                                    : incremental.edit(editAt, 5, "true");
+        ok = result.ok() && ok;
+    });
+
+    report("Validator", json.size(), validate);
+    report("Lexer+Parser (Token vector)", json.size(), vectorPipeline);
+    report("Lexer+Parser (TokenBuffer)", json.size(), compactPipeline);
+    report("Lexer+Parser (predicted keys)", json.size(), predictedPipeline);
+    report("Lexer+Parser (strict keys)", json.size(), strictPipeline);
+    report("Lexer+Parser (hashed)", json.size(), hashedPipeline);
+    report("Read strings (copies)", json.size(), copyStrings);
+    report("Read strings (views)", json.size(), viewStrings);
+    report("Document::parse", json.size(), parseDocument);
+    std::printf("%-28s %9.3f ms\n", "Snapshot::open", openSnapshot * 1e3);
+    std::printf("%-28s %9.3f ms\n", "IncrementalParser::edit",
+                editDocument * 1e3);
+    std::printf("%-28s %9.3f us/lookup\n", "Key lookup (scan)",
+                scanLookups * 1e6 / keys.size());
+    std::printf("%-28s %9.3f us/lookup\n", "Key lookup (index)",
+                indexedLookups * 1e6 / keys.size());
+
+    std::printf("\nTokens: %zu\n", tokenCount);
+    std::printf("Token vector: %9.2f bytes/token\n",
+                static_cast<double>(vectorBytes) / tokenCount);
+    std::printf("TokenBuffer:  %9.2f bytes/token\n",
+                static_cast<double>(compactBytes) / tokenCount);
+
+    if (!ok || checksum == 0) {
+        std::cerr << "Benchmark input failed to parse" << std::endl;
+        return 1;
+    }
+    return 0;
+}
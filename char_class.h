@@ -0,0 +1,321 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "error.h"
+
+// Locale-independent character classification tables and the number DFA
+// shared by the Lexer and the Validator. Every byte maps to exactly one class,
+// so the hot loops do a single table load instead of a chain of comparisons.
+
+enum CharClass : uint8_t {
+    CC_OTHER,
+    CC_WHITESPACE,     // space, \t, \n, \r
+    CC_LEFT_BRACE,     // {
+    CC_RIGHT_BRACE,    // }
+    CC_LEFT_BRACKET,   // [
+    CC_RIGHT_BRACKET,  // ]
+    CC_COLON,          // :
+    CC_COMMA,          // ,
+    CC_QUOTE,          // "
+    CC_NUMBER,         // - and 0-9
+    CC_TRUE,           // t
+    CC_FALSE,          // f
+    CC_NULL,           // n
+    CC_COUNT,
+};
+
+enum StringCharClass : uint8_t {
+    SC_PLAIN,
+    SC_QUOTE,      // "
+    SC_BACKSLASH,  // backslash
+    SC_CONTROL,    // 0x00-0x1F, not allowed unescaped
+};
+
+#define OT CC_OTHER
+#define WS CC_WHITESPACE
+#define LO CC_LEFT_BRACE
+#define RO CC_RIGHT_BRACE
+#define LA CC_LEFT_BRACKET
+#define RA CC_RIGHT_BRACKET
+#define CO CC_COLON
+#define CM CC_COMMA
+#define QT CC_QUOTE
+#define NM CC_NUMBER
+#define LT CC_TRUE
+#define LF CC_FALSE
+#define LN CC_NULL
+
+constexpr uint8_t kCharClass[256] = {
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, WS, WS, OT, OT, WS, OT, OT,  // 00
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 10
+    WS, OT, QT, OT, OT, OT, OT, OT, OT, OT, OT, OT, CM, NM, OT, OT,  // 20
+    NM, NM, NM, NM, NM, NM, NM, NM, NM, NM, CO, OT, OT, OT, OT, OT,  // 30
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 40
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, LA, OT, RA, OT, OT,  // 50
+    OT, OT, OT, OT, OT, OT, LF, OT, OT, OT, OT, OT, OT, OT, LN, OT,  // 60
+    OT, OT, OT, OT, LT, OT, OT, OT, OT, OT, OT, LO, OT, RO, OT, OT,  // 70
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 80
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 90
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // A0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // B0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // C0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // D0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // E0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // F0
+};
+
+#undef OT
+#undef WS
+#undef LO
+#undef RO
+#undef LA
+#undef RA
+#undef CO
+#undef CM
+#undef QT
+#undef NM
+#undef LT
+#undef LF
+#undef LN
+
+#define PL SC_PLAIN
+#define QT SC_QUOTE
+#define BS SC_BACKSLASH
+#define CT SC_CONTROL
+
+constexpr uint8_t kStringCharClass[256] = {
+    CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT,  // 00
+    CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT, CT,  // 10
+    PL, PL, QT, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 20
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 30
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 40
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, BS, PL, PL, PL,  // 50
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 60
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 70
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 80
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // 90
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // A0
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // B0
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // C0
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // D0
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // E0
+    PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL, PL,  // F0
+};
+
+#undef PL
+#undef QT
+#undef BS
+#undef CT
+
+constexpr CharClass charClass(char c) {
+    return static_cast<CharClass>(kCharClass[static_cast<uint8_t>(c)]);
+}
+
+constexpr StringCharClass stringCharClass(char c) {
+    return static_cast<StringCharClass>(
+        kStringCharClass[static_cast<uint8_t>(c)]);
+}
+
+constexpr bool isHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+           (c >= 'A' && c <= 'F');
+}
+
+// Number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+// kNumberCharClass feeds a DFA whose transitions live in kNumberTransitions.
+// Any byte outside the grammar is a terminator; reaching NS_DONE means the
+// bytes consumed so far form a complete number.
+
+enum NumberCharClass : uint8_t {
+    NC_OTHER,  // Terminator (also used for end of input)
+    NC_ZERO,
+    NC_DIGIT,  // 1-9
+    NC_MINUS,
+    NC_PLUS,
+    NC_DOT,
+    NC_EXPONENT,  // e and E
+    NC_COUNT,
+};
+
+enum NumberState : uint8_t {
+    NS_START,
+    NS_MINUS,
+    NS_ZERO,
+    NS_INTEGER,
+    NS_DOT,
+    NS_FRACTION,
+    NS_EXPONENT_MARK,
+    NS_EXPONENT_SIGN,
+    NS_EXPONENT,
+    NS_ACTIVE_COUNT,
+
+    // Terminal states, reached without consuming the current byte
+    NS_DONE = NS_ACTIVE_COUNT,
+    NS_ERROR_DIGIT,
+    NS_ERROR_FRACTION,
+    NS_ERROR_EXPONENT,
+    NS_ERROR_DECIMAL_POINTS,
+};
+
+#define OT NC_OTHER
+#define ZR NC_ZERO
+#define DG NC_DIGIT
+#define MI NC_MINUS
+#define PL NC_PLUS
+#define DT NC_DOT
+#define EX NC_EXPONENT
+
+constexpr uint8_t kNumberCharClass[256] = {
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 00
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 10
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, PL, OT, MI, DT, OT,  // 20
+    ZR, DG, DG, DG, DG, DG, DG, DG, DG, DG, OT, OT, OT, OT, OT, OT,  // 30
+    OT, OT, OT, OT, OT, EX, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 40
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 50
+    OT, OT, OT, OT, OT, EX, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 60
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 70
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 80
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 90
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // A0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // B0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // C0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // D0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // E0
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // F0
+};
+
+#undef OT
+#undef ZR
+#undef DG
+#undef MI
+#undef PL
+#undef DT
+#undef EX
+
+// Columns follow NumberCharClass: other, 0, 1-9, -, +, ., e/E
+constexpr uint8_t kNumberTransitions[NS_ACTIVE_COUNT][NC_COUNT] = {
+    // NS_START
+    {NS_ERROR_DIGIT, NS_ZERO, NS_INTEGER, NS_MINUS, NS_ERROR_DIGIT,
+     NS_ERROR_DIGIT, NS_ERROR_DIGIT},
+    // NS_MINUS
+    {NS_ERROR_DIGIT, NS_ZERO, NS_INTEGER, NS_ERROR_DIGIT, NS_ERROR_DIGIT,
+     NS_ERROR_DIGIT, NS_ERROR_DIGIT},
+    // NS_ZERO (no leading zeros)
+    {NS_DONE, NS_ERROR_DIGIT, NS_ERROR_DIGIT, NS_DONE, NS_DONE, NS_DOT,
+     NS_EXPONENT_MARK},
+    // NS_INTEGER
+    {NS_DONE, NS_INTEGER, NS_INTEGER, NS_DONE, NS_DONE, NS_DOT,
+     NS_EXPONENT_MARK},
+    // NS_DOT
+    {NS_ERROR_FRACTION, NS_FRACTION, NS_FRACTION, NS_ERROR_FRACTION,
+     NS_ERROR_FRACTION, NS_ERROR_FRACTION, NS_ERROR_FRACTION},
+    // NS_FRACTION
+    {NS_DONE, NS_FRACTION, NS_FRACTION, NS_DONE, NS_DONE,
+     NS_ERROR_DECIMAL_POINTS, NS_EXPONENT_MARK},
+    // NS_EXPONENT_MARK
+    {NS_ERROR_EXPONENT, NS_EXPONENT, NS_EXPONENT, NS_EXPONENT_SIGN,
+     NS_EXPONENT_SIGN, NS_ERROR_EXPONENT, NS_ERROR_EXPONENT},
+    // NS_EXPONENT_SIGN
+    {NS_ERROR_EXPONENT, NS_EXPONENT, NS_EXPONENT, NS_ERROR_EXPONENT,
+     NS_ERROR_EXPONENT, NS_ERROR_EXPONENT, NS_ERROR_EXPONENT},
+    // NS_EXPONENT
+    {NS_DONE, NS_EXPONENT, NS_EXPONENT, NS_DONE, NS_DONE, NS_DONE, NS_DONE},
+};
+
+// Runs the number DFA from `p`, leaving `p` on the first byte that is not
+// part of the number (or on the offending byte). Returns NS_DONE on success
+// or one of the NS_ERROR_* states.
+constexpr NumberState matchNumber(const char*& p, const char* end) {
+    uint8_t state = NS_START;
+    while (true) {
+        uint8_t cls =
+            p < end ? kNumberCharClass[static_cast<uint8_t>(*p)] : NC_OTHER;
+        uint8_t next = kNumberTransitions[state][cls];
+        if (next >= NS_DONE) {
+            return static_cast<NumberState>(next);
+        }
+        state = next;
+        p++;
+    }
+}
+
+constexpr ErrorCode numberError(NumberState state) {
+    switch (state) {
+        case NS_ERROR_FRACTION:
+            return ErrorCode::EXPECTED_FRACTION_DIGIT;
+        case NS_ERROR_EXPONENT:
+            return ErrorCode::EXPECTED_EXPONENT_DIGIT;
+        case NS_ERROR_DECIMAL_POINTS:
+            return ErrorCode::MULTIPLE_DECIMAL_POINTS;
+        default:
+            return ErrorCode::INVALID_NUMBER;
+    }
+}
+
+// Bytes that may directly follow a true/false/null literal
+constexpr uint32_t kLiteralDelimiters =
+    (1u << CC_WHITESPACE) | (1u << CC_COMMA) | (1u << CC_RIGHT_BRACE) |
+    (1u << CC_RIGHT_BRACKET);
+
+constexpr bool isLiteralDelimiter(char c) {
+    return (kLiteralDelimiters >> kCharClass[static_cast<uint8_t>(c)]) & 1u;
+}
+
+// Checks that `literal` starts at `p` and is followed by the end of input or a
+// delimiter. Returns the error to report, or ErrorCode::NONE.
+inline ErrorCode matchLiteral(const char* p, const char* end,
+                              const char* literal, size_t length) {
+    size_t remaining = end - p;
+    if (remaining < length) {
+        // Either the input ends inside the literal or it doesn't match
+        return memcmp(p, literal, remaining) == 0
+                   ? ErrorCode::UNEXPECTED_EOF_IN_LITERAL
+                   : ErrorCode::INVALID_LITERAL;
+    }
+    if (memcmp(p, literal, length) != 0) {
+        return ErrorCode::INVALID_LITERAL;
+    }
+    if (remaining > length && !isLiteralDelimiter(p[length])) {
+        return ErrorCode::INVALID_CHARACTER_AFTER_LITERAL;
+    }
+    return ErrorCode::NONE;
+}
+
+// Length of the UTF-8 sequence starting at `p`, or 0 if it is malformed
+// (overlong, surrogate, above U+10FFFF or truncated)
+constexpr size_t utf8SequenceLength(const char* p, size_t remaining) {
+    uint8_t lead = static_cast<uint8_t>(p[0]);
+    if (lead < 0x80) {
+        return 1;
+    }
+
+    size_t length = 0;
+    uint8_t min = 0x80;
+    uint8_t max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) min = 0xA0;
+        if (lead == 0xED) max = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) min = 0x90;
+        if (lead == 0xF4) max = 0x8F;
+    } else {
+        return 0;
+    }
+
+    if (remaining < length || static_cast<uint8_t>(p[1]) < min ||
+        static_cast<uint8_t>(p[1]) > max) {
+        return 0;
+    }
+    for (size_t k = 2; k < length; k++) {
+        if ((static_cast<uint8_t>(p[k]) & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
@@ -0,0 +1,54 @@
+#include "dedup.h"
+
+#include <string>
+#include <utility>
+
+#include "input.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+ParseResult Deduplicator::addRecord(const char* data, size_t size,
+                                    bool& duplicate) {
+    duplicate = false;
+    Lexer lexer(data, size);
+    lexer.predictKeys(&shapes);
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    if (!result.ok()) {
+        return result;
+    }
+
+    Parser parser(std::move(tokens));
+    result = parser.tryParseHashed(lexer, hashes);
+    if (!result.ok()) {
+        return result;
+    }
+
+    hash = hashes[0];
+    records++;
+    duplicate = !seen.insert(hash).second;
+    duplicates += duplicate;
+    return result;
+}
+
+ParseResult Deduplicator::addLines(const char* data, size_t size,
+                                   std::string& output) {
+    return forEachRecord(data, size, [&](const char* line, size_t length) {
+        bool duplicate;
+        ParseResult result = addRecord(line, length, duplicate);
+        if (result.ok() && !duplicate) {
+            output.append(line, length);
+            output += '\n';
+        }
+        return result;
+    });
+}
+
+void Deduplicator::clear() {
+    seen.clear();
+    hash = 0;
+    records = 0;
+    duplicates = 0;
+    shapes.clear();
+}
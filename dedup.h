@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "error.h"
+#include "key_shapes.h"
+
+// Drops NDJSON records equal to an earlier one, comparing structural hashes
+// (structural_hash.h) so that key order, whitespace, escapes and number
+// spelling don't matter. Only the 8-byte hash of each distinct record is
+// kept, never the record itself. The Lexer predicts each record's keys from
+// the records before it (KeyShapes), which pays off when every line has the
+// same layout.
+class Deduplicator {
+   public:
+    Deduplicator() : hash(0), records(0), duplicates(0) {}
+
+    // Checks one record. Returns whether it was seen before through
+    // `duplicate`; an invalid record is neither counted nor remembered.
+    ParseResult addRecord(const char* data, size_t size, bool& duplicate);
+
+    // Appends each non-blank line of `data` that is not a duplicate to
+    // `output`, followed by a newline. Stops at the first invalid record;
+    // error offsets are relative to `data`.
+    ParseResult addLines(const char* data, size_t size, std::string& output);
+
+    // Canonical hash of the last record passed to addRecord()
+    uint64_t lastHash() const { return hash; }
+
+    size_t recordCount() const { return records; }
+    size_t duplicateCount() const { return duplicates; }
+    size_t uniqueCount() const { return seen.size(); }
+
+    // Layouts learned so far; hits() counts the keys they predicted
+    const KeyShapes& keyShapes() const { return shapes; }
+
+    void clear();
+
+   private:
+    std::unordered_set<uint64_t> seen;
+    std::vector<uint64_t> hashes;  // Per-token scratch
+    uint64_t hash;
+    size_t records;
+    size_t duplicates;
+    KeyShapes shapes;
+};
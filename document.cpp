@@ -0,0 +1,324 @@
+#include "document.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "char_class.h"
+#include "input.h"
+#include "lexer.h"
+#include "memory.h"
+#include "number.h"
+#include "parser.h"
+#include "tape.h"
+#include "token_buffer.h"
+
+namespace {
+
+// Writes the tape for a token stream the Parser has already accepted, so no
+// grammar checks are needed here
+struct TapeBuilder {
+    const Lexer& lexer;
+    const TokenBuffer& tokens;
+    std::pmr::vector<uint64_t>& tape;
+    std::pmr::vector<char>& strings;
+
+    // Tape index of each open container's start word and its comma count
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> open{
+        tape.get_allocator()};
+    std::pmr::string scratch{tape.get_allocator().resource()};
+    size_t token = 0;  // Being written, for errors
+
+    void build() {
+        tape.reserve(tokens.size() + tokens.size() / 4);
+        for (; token < tokens.size(); token++) {
+            switch (tokens.type(token)) {
+                case TokenType::LEFT_BRACE:
+                case TokenType::LEFT_BRACKET:
+                    open.push_back(std::make_pair(tape.size(), 0));
+                    tape.push_back(0);  // Patched when the container closes
+                    break;
+                case TokenType::RIGHT_BRACE:
+                    close(TAPE_OBJECT_START, TAPE_OBJECT_END);
+                    break;
+                case TokenType::RIGHT_BRACKET:
+                    close(TAPE_ARRAY_START, TAPE_ARRAY_END);
+                    break;
+                case TokenType::COMMA:
+                    open.back().second++;
+                    break;
+                case TokenType::COLON:
+                    break;
+                case TokenType::STRING:
+                    appendString(lexer.string(tokens, token, scratch));
+                    break;
+                case TokenType::NUMBER:
+                    appendNumber(lexer.data() + tokens.offset(token));
+                    break;
+                case TokenType::TRUE:
+                    tape.push_back(tapeWord(TAPE_TRUE, 0));
+                    break;
+                case TokenType::FALSE:
+                    tape.push_back(tapeWord(TAPE_FALSE, 0));
+                    break;
+                case TokenType::NULL_TOKEN:
+                    tape.push_back(tapeWord(TAPE_NULL, 0));
+                    break;
+            }
+        }
+    }
+
+    void close(TapeTag startTag, TapeTag endTag) {
+        uint32_t start = open.back().first;
+        uint32_t commas = open.back().second;
+        open.pop_back();
+
+        uint32_t end = tape.size();
+        uint32_t count = end > start + 1 ? commas + 1 : 0;
+        tape[start] = tapeWord(startTag, tapeContainerPayload(end, count));
+        tape.push_back(tapeWord(endTag, start));
+    }
+
+    void appendString(StringRef value) {
+        tape.push_back(tapeWord(TAPE_STRING, strings.size()));
+        uint32_t length = value.size;
+        const char* lengthBytes = reinterpret_cast<const char*>(&length);
+        strings.insert(strings.end(), lengthBytes,
+                       lengthBytes + sizeof(length));
+        strings.insert(strings.end(), value.data, value.data + value.size);
+        strings.push_back('\0');
+    }
+
+    void appendNumber(const char* start) {
+        const char* end = start;
+        matchNumber(end, lexer.data() + lexer.size());
+
+        // Integers that fit in 64 bits are kept exact
+        int64_t integer;
+        uint64_t bits;
+        if (parseInteger(start, end, integer)) {
+            tape.push_back(tapeWord(TAPE_INT64, 0));
+            bits = static_cast<uint64_t>(integer);
+        } else {
+            double value = parseDouble(start, end);
+            tape.push_back(tapeWord(TAPE_DOUBLE, 0));
+            memcpy(&bits, &value, sizeof(bits));
+        }
+        tape.push_back(bits);
+    }
+};
+
+}  // namespace
+
+ValueType Value::type() const {
+    if (!exists()) {
+        return ValueType::NULL_VALUE;
+    }
+    switch (tapeTag(word())) {
+        case TAPE_TRUE:
+        case TAPE_FALSE:
+            return ValueType::BOOLEAN;
+        case TAPE_INT64:
+            return ValueType::INT64;
+        case TAPE_DOUBLE:
+            return ValueType::DOUBLE;
+        case TAPE_STRING:
+            return ValueType::STRING;
+        case TAPE_ARRAY_START:
+            return ValueType::ARRAY;
+        case TAPE_OBJECT_START:
+            return ValueType::OBJECT;
+        default:
+            return ValueType::NULL_VALUE;
+    }
+}
+
+bool Value::asBool() const {
+    return exists() && tapeTag(word()) == TAPE_TRUE;
+}
+
+int64_t Value::asInt64() const {
+    if (!exists() || tapeTag(word()) != TAPE_INT64) {
+        return 0;
+    }
+    return static_cast<int64_t>(doc->tape[index + 1]);
+}
+
+double Value::asDouble() const {
+    if (!exists()) {
+        return 0;
+    }
+    switch (tapeTag(word())) {
+        case TAPE_INT64:
+            return static_cast<double>(asInt64());
+        case TAPE_DOUBLE: {
+            double value;
+            memcpy(&value, &doc->tape[index + 1], sizeof(value));
+            return value;
+        }
+        default:
+            return 0;
+    }
+}
+
+StringRef Value::asString() const {
+    if (!exists() || tapeTag(word()) != TAPE_STRING) {
+        return StringRef();
+    }
+    const char* entry = doc->strings + tapePayload(word());
+    uint32_t length;
+    memcpy(&length, entry, sizeof(length));
+    return StringRef(entry + sizeof(length), length);
+}
+
+size_t Value::size() const {
+    if (!isObject() && !isArray()) {
+        return 0;
+    }
+    uint32_t count = tapeContainerCount(word());
+    if (count < kTapeCountSaturated) {
+        return count;
+    }
+
+    size_t total = 0;
+    for (Iterator it = begin(); it != end(); ++it) {
+        total++;
+    }
+    return total;
+}
+
+Value Value::operator[](size_t i) const {
+    if (!isArray()) {
+        return Value();
+    }
+    for (Iterator it = begin(); it != end(); ++it) {
+        if (i-- == 0) {
+            return *it;
+        }
+    }
+    return Value();
+}
+
+Value Value::operator[](StringRef key) const {
+    if (!isObject()) {
+        return Value();
+    }
+    if (doc->objectIndex != nullptr &&
+        tapeContainerCount(word()) >= ObjectIndex::kMinMembers) {
+        size_t found = doc->objectIndex->find(*doc, index, key);
+        if (found != ObjectIndex::kNotIndexed) {
+            return found != 0 ? Value(doc, found) : Value();
+        }
+    }
+    for (Iterator it = begin(); it != end(); ++it) {
+        if (it.key() == key) {
+            return it.value();
+        }
+    }
+    return Value();
+}
+
+Value::Iterator Value::begin() const {
+    if (!isObject() && !isArray()) {
+        return end();
+    }
+    return Iterator(doc, index + 1, isObject());
+}
+
+Value::Iterator Value::end() const {
+    if (!isObject() && !isArray()) {
+        return Iterator(doc, index, false);
+    }
+    return Iterator(doc, tapeContainerEnd(word()), isObject());
+}
+
+StringRef Value::Iterator::key() const {
+    return isObject ? Value(doc, index).asString() : StringRef();
+}
+
+Value Value::Iterator::value() const {
+    return Value(doc, isObject ? index + 1 : index);
+}
+
+Value::Iterator& Value::Iterator::operator++() {
+    // Object members are a key word followed by the value
+    index = tapeNext(doc->tape, isObject ? index + 1 : index);
+    return *this;
+}
+
+ParseResult Document::parse(const char* data, size_t size) {
+    tape.clear();
+    strings.clear();
+    keyIndex.clear();
+    updateView();
+    memory.resetStats();
+
+    Lexer lexer(data, size);
+    if (keyPrediction) {
+        lexer.predictKeys(&shapes);
+    }
+    TokenBuffer tokens(&memory);
+    ParseResult result = lexer.tryTokenize(tokens);
+    if (!result.ok()) {
+        return result;
+    }
+
+    Parser parser(std::move(tokens));
+    if (strictKeys) {
+        parser.checkDuplicateKeys(&lexer);
+    }
+    parser.checkSchema(schema, &lexer);
+    result = parser.tryParse();
+    if (!result.ok()) {
+        return result;
+    }
+
+    const TokenBuffer& accepted = parser.tokenBuffer();
+    TapeBuilder builder = {lexer, accepted, tape, strings};
+    try {
+        builder.build();
+    } catch (const MemoryLimitExceeded&) {
+        tape.clear();
+        strings.clear();
+        return ParseResult(ErrorCode::MEMORY_LIMIT_EXCEEDED,
+                           builder.token < accepted.size()
+                               ? accepted.offset(builder.token)
+                               : accepted.endOffset());
+    }
+    updateView();
+    return result;
+}
+
+ParseResult Document::parse(const std::string& json) {
+    return parse(json.data(), json.size());
+}
+
+ParseResult Document::parseFile(const std::string& filePath) {
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        tape.clear();
+        strings.clear();
+        updateView();
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    return parse(contents);
+}
+
+Value Document::root() const {
+    return empty() ? Value() : Value(&tapeView, 0);
+}
+
+size_t Document::memoryUsage() const {
+    return tape.capacity() * sizeof(uint64_t) + strings.capacity() +
+           keyIndex.memoryUsage();
+}
+
+void Document::updateView() {
+    tapeView.tape = tape.data();
+    tapeView.tapeSize = tape.size();
+    tapeView.strings = strings.data();
+    tapeView.stringsSize = strings.size();
+    tapeView.objectIndex = &keyIndex;
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "error.h"
+#include "key_shapes.h"
+#include "memory.h"
+#include "object_index.h"
+#include "string_ref.h"
+
+class Schema;
+
+enum class ValueType : uint8_t {
+    NULL_VALUE,
+    BOOLEAN,
+    INT64,
+    DOUBLE,
+    STRING,
+    ARRAY,
+    OBJECT,
+};
+
+// Read-only tape and string area of a parsed document (see tape.h). Owned by
+// a Document or a Snapshot; Values point at it. `objectIndex` holds the key
+// tables of large objects; without one every lookup is a linear scan.
+struct DocumentView {
+    const uint64_t* tape;
+    size_t tapeSize;
+    const char* strings;
+    size_t stringsSize;
+    ObjectIndex* objectIndex;
+
+    constexpr DocumentView()
+        : tape(nullptr), tapeSize(0), strings(nullptr), stringsSize(0),
+          objectIndex(nullptr) {}
+};
+
+// Handle to one value of a document. Cheap to copy; valid as long as the
+// Document or Snapshot it came from. Lookups that find nothing return a Value
+// whose exists() is false, and the as*() accessors of a value of another type
+// return 0, false or an empty string.
+class Value {
+   public:
+    // Walks the elements of an array or the members of an object
+    class Iterator {
+       public:
+        Iterator(const DocumentView* doc, size_t index, bool isObject)
+            : doc(doc), index(index), isObject(isObject) {}
+
+        // Key of the current member; empty for arrays
+        StringRef key() const;
+        Value value() const;
+        Value operator*() const { return value(); }
+
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const {
+            return index == other.index;
+        }
+        bool operator!=(const Iterator& other) const {
+            return index != other.index;
+        }
+
+       private:
+        const DocumentView* doc;
+        size_t index;
+        bool isObject;
+    };
+
+    Value() : doc(nullptr), index(0) {}
+    Value(const DocumentView* doc, size_t index) : doc(doc), index(index) {}
+
+    bool exists() const { return doc != nullptr; }
+    ValueType type() const;
+
+    bool isNull() const { return exists() && type() == ValueType::NULL_VALUE; }
+    bool isObject() const { return exists() && type() == ValueType::OBJECT; }
+    bool isArray() const { return exists() && type() == ValueType::ARRAY; }
+
+    bool asBool() const;
+    int64_t asInt64() const;
+    double asDouble() const;  // Integers are converted
+    StringRef asString() const;
+
+    // Number of elements or members; 0 for scalars
+    size_t size() const;
+
+    // Array element by position (linear in `i`)
+    Value operator[](size_t i) const;
+
+    // Object member by key. Linear in the member count for small objects;
+    // large ones are indexed on first lookup (see ObjectIndex).
+    Value operator[](StringRef key) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Position of this value on the tape
+    size_t tapeIndex() const { return index; }
+
+   private:
+    const DocumentView* doc;
+    size_t index;
+
+    uint64_t word() const { return doc->tape[index]; }
+};
+
+// A parsed JSON document, stored as a tape. Numbers are parsed to int64 when
+// they are integers that fit and to double otherwise; strings are unescaped
+// once, up front.
+//
+// Everything the document allocates goes through its own MemoryAccount on
+// top of `upstream`: the tape, strings and object indexes, the tokens and
+// key sets the Lexer and Parser need while parsing, and learned KeyShapes.
+class Document {
+   public:
+    Document() : Document(std::pmr::get_default_resource()) {}
+    explicit Document(std::pmr::memory_resource* upstream)
+        : memory(upstream),
+          tape(&memory),
+          strings(&memory),
+          keyIndex(&memory),
+          shapes(&memory),
+          strictKeys(false),
+          keyPrediction(false),
+          schema(nullptr) {}
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    // Parses `data` into this document, replacing what it held. On failure
+    // the document is left empty.
+    ParseResult parse(const char* data, size_t size);
+    ParseResult parse(const std::string& json);
+    ParseResult parseFile(const std::string& filePath);
+
+    // Makes later parses reject objects with a repeated key (DUPLICATE_KEY)
+    void checkDuplicateKeys(bool check) { strictKeys = check; }
+
+    // Makes later parses check the input against `schema` in the same pass
+    // as the syntax (Parser::checkSchema()); a document that breaks it is
+    // rejected at the first offending value and left empty. `schema` must
+    // outlive the parses; nullptr turns the check off.
+    void checkSchema(const Schema* schema) { this->schema = schema; }
+
+    // Makes later parses predict object keys (Lexer::predictKeys()) from
+    // shapes learned over every parse since, which pays off for arrays of
+    // records and for a document reused on inputs of the same shape. The
+    // shapes are kept, and counted in memoryStats(), until clearKeyShapes().
+    void predictKeys(bool predict) { keyPrediction = predict; }
+    const KeyShapes& keyShapes() const { return shapes; }
+    void clearKeyShapes() { shapes.clear(); }
+
+    bool empty() const { return tape.empty(); }
+    Value root() const;
+    const DocumentView& view() const { return tapeView; }
+
+    // Heap bytes reserved for the tape, strings and object indexes
+    size_t memoryUsage() const;
+
+    // Allocations since the last parse began, including the parse's working
+    // memory, the scratch strings that escapes are decoded into included.
+    // Only the input is not counted. Not synchronised with lookups on other
+    // threads.
+    const MemoryStats& memoryStats() const { return memory.stats(); }
+
+    // Parses that would hold more than `bytes` at once fail with
+    // MEMORY_LIMIT_EXCEEDED, and large objects that can't be indexed within
+    // it are scanned. 0 removes the limit.
+    void setMemoryLimit(size_t bytes) { memory.setLimit(bytes); }
+
+   private:
+    MemoryAccount memory;  // Declared first to outlive what it allocated
+    std::pmr::vector<uint64_t> tape;
+    std::pmr::vector<char> strings;
+    ObjectIndex keyIndex;
+    KeyShapes shapes;
+    DocumentView tapeView;
+    bool strictKeys;
+    bool keyPrediction;
+    const Schema* schema;
+
+    void updateView();
+};
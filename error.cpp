@@ -0,0 +1,109 @@
+#include "error.h"
+
+#include <string>
+
+static std::string literalName(char initial) {
+    switch (initial) {
+        case 't':
+            return "true";
+        case 'f':
+            return "false";
+        default:
+            return "null";
+    }
+}
+
+static std::string describe(ErrorCode code, char detail) {
+    switch (code) {
+        case ErrorCode::NONE:
+            return "No error";
+        case ErrorCode::EMPTY_INPUT:
+            return "Invalid JSON: empty input";
+        case ErrorCode::INVALID_CHARACTER:
+            return "Invalid character: " + std::string(1, detail);
+        case ErrorCode::UNTERMINATED_STRING:
+            return "Unterminated string - missing closing quote";
+        case ErrorCode::INVALID_ESCAPE:
+            return "Invalid escape sequence: \\" + std::string(1, detail);
+        case ErrorCode::EXPECTED_FRACTION_DIGIT:
+            return "invalid number - expected digit after decimal point";
+        case ErrorCode::MULTIPLE_DECIMAL_POINTS:
+            return "invalid number - multiple decimal points";
+        case ErrorCode::EXPECTED_EXPONENT_DIGIT:
+            return "invalid number - expected digit in exponent";
+        case ErrorCode::UNEXPECTED_EOF_IN_LITERAL:
+            return "Unexpected EOF while parsing '" + literalName(detail) + "'";
+        case ErrorCode::INVALID_LITERAL:
+            return "Invalid literal: expected '" + literalName(detail) + "'";
+        case ErrorCode::INVALID_CHARACTER_AFTER_LITERAL:
+            return "Invalid character after '" + literalName(detail) +
+                   "' literal";
+        case ErrorCode::INVALID_NUMBER:
+            return "invalid number - expected digit";
+        case ErrorCode::CONTROL_CHARACTER_IN_STRING:
+            return "Unescaped control character in string";
+        case ErrorCode::INVALID_UTF8:
+            return "Invalid UTF-8 sequence";
+        case ErrorCode::CANNOT_OPEN_FILE:
+            return "Cannot open file";
+        case ErrorCode::INPUT_TOO_LARGE:
+            return "Input larger than 4 GiB";
+        case ErrorCode::UNEXPECTED_END_OF_INPUT:
+            return "Unexpected end of input";
+        case ErrorCode::EXPECTED_END_OF_INPUT:
+            return "Expected end of input";
+        case ErrorCode::UNEXPECTED_TOKEN:
+            return "Unexpected token";
+        case ErrorCode::EXPECTED_STRING_KEY:
+            return "Expected string key in object";
+        case ErrorCode::TRAILING_COMMA_IN_OBJECT:
+            return "Trailing comma in object";
+        case ErrorCode::TRAILING_COMMA_IN_ARRAY:
+            return "Trailing comma in array";
+        case ErrorCode::EXPECTED_DIFFERENT_TOKEN:
+            return "Expected different token type";
+        case ErrorCode::DUPLICATE_KEY:
+            return "Duplicate object key";
+        case ErrorCode::CANNOT_WRITE_FILE:
+            return "Cannot write file";
+        case ErrorCode::INVALID_SNAPSHOT:
+            return "Not a valid snapshot file";
+        case ErrorCode::SNAPSHOT_VERSION_MISMATCH:
+            return "Unsupported snapshot version";
+        case ErrorCode::INVALID_JSON_POINTER:
+            return "Invalid JSON Pointer";
+        case ErrorCode::INVALID_COLUMN_FILE:
+            return "Not a valid columnar file";
+        case ErrorCode::EDIT_OUT_OF_RANGE:
+            return "Edit range outside the document";
+        case ErrorCode::PATH_NOT_FOUND:
+            return "No value at JSON Pointer";
+        case ErrorCode::TOO_MANY_DIGITS:
+            return "Too many digits to convert at compile time";
+        case ErrorCode::MEMORY_LIMIT_EXCEEDED:
+            return "Memory limit exceeded";
+        case ErrorCode::INVALID_SCHEMA:
+            return "Unsupported or invalid schema keyword";
+        case ErrorCode::SCHEMA_TYPE_MISMATCH:
+            return "Value has a type the schema doesn't allow";
+        case ErrorCode::SCHEMA_ENUM_MISMATCH:
+            return "Value is not one of the schema's enum values";
+        case ErrorCode::SCHEMA_OUT_OF_RANGE:
+            return "Number outside the schema's bounds";
+        case ErrorCode::SCHEMA_LENGTH_OUT_OF_RANGE:
+            return "String length outside the schema's bounds";
+        case ErrorCode::SCHEMA_MISSING_PROPERTY:
+            return "Object lacks a property the schema requires";
+        case ErrorCode::SCHEMA_ADDITIONAL_PROPERTY:
+            return "Property not allowed by the schema";
+    }
+    return "Unknown error";
+}
+
+std::string ParseResult::message() const {
+    if (ok()) {
+        return describe(code, detail);
+    }
+    return "Error at offset " + std::to_string(offset) + ": " +
+           describe(code, detail);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+enum class ErrorCode {
+    NONE,
+
+    // Lexer errors
+    EMPTY_INPUT,
+    INVALID_CHARACTER,
+    UNTERMINATED_STRING,
+    INVALID_ESCAPE,
+    EXPECTED_FRACTION_DIGIT,
+    MULTIPLE_DECIMAL_POINTS,
+    EXPECTED_EXPONENT_DIGIT,
+    UNEXPECTED_EOF_IN_LITERAL,
+    INVALID_LITERAL,
+    INVALID_CHARACTER_AFTER_LITERAL,
+    INVALID_NUMBER,
+    CONTROL_CHARACTER_IN_STRING,
+    INVALID_UTF8,
+    CANNOT_OPEN_FILE,
+    INPUT_TOO_LARGE,
+
+    // Grammar errors
+    UNEXPECTED_END_OF_INPUT,
+    EXPECTED_END_OF_INPUT,
+    UNEXPECTED_TOKEN,
+    EXPECTED_STRING_KEY,
+    TRAILING_COMMA_IN_OBJECT,
+    TRAILING_COMMA_IN_ARRAY,
+    EXPECTED_DIFFERENT_TOKEN,
+    DUPLICATE_KEY,
+
+    // Snapshot errors
+    CANNOT_WRITE_FILE,
+    INVALID_SNAPSHOT,
+    SNAPSHOT_VERSION_MISMATCH,
+
+    // Projection errors
+    INVALID_JSON_POINTER,
+
+    // Columnar file errors
+    INVALID_COLUMN_FILE,
+
+    // Incremental parsing errors
+    EDIT_OUT_OF_RANGE,
+
+    // Shared document errors
+    PATH_NOT_FOUND,
+
+    // Static document errors
+    TOO_MANY_DIGITS,
+
+    // Memory errors
+    MEMORY_LIMIT_EXCEEDED,
+
+    // Schema errors
+    INVALID_SCHEMA,
+    SCHEMA_TYPE_MISMATCH,
+    SCHEMA_ENUM_MISMATCH,
+    SCHEMA_OUT_OF_RANGE,
+    SCHEMA_LENGTH_OUT_OF_RANGE,
+    SCHEMA_MISSING_PROPERTY,
+    SCHEMA_ADDITIONAL_PROPERTY,
+};
+
+// Outcome of a no-throw Lexer/Parser call. Only the code, byte offset and the
+// offending character are recorded when a failure happens; the human readable
+// message is built on demand so rejecting malformed input stays cheap.
+// Failures read "Error at offset N: <description>", with N a byte offset into
+// the input; this replaced the line and column of the throwing Lexer.
+struct ParseResult {
+    ErrorCode code;
+    size_t offset;
+    char detail;  // Offending character, or the first letter of a literal
+
+    constexpr ParseResult() : code(ErrorCode::NONE), offset(0), detail('\0') {}
+    constexpr ParseResult(ErrorCode c, size_t o, char d = '\0')
+        : code(c), offset(o), detail(d) {}
+
+    constexpr bool ok() const { return code == ErrorCode::NONE; }
+    std::string message() const;
+};
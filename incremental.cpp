@@ -0,0 +1,237 @@
+#include "incremental.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "input.h"
+#include "kernels.h"
+#include "lexer.h"
+
+namespace {
+
+bool isOpen(TokenType type) {
+    return type == TokenType::LEFT_BRACE || type == TokenType::LEFT_BRACKET;
+}
+
+bool isClose(TokenType type) {
+    return type == TokenType::RIGHT_BRACE || type == TokenType::RIGHT_BRACKET;
+}
+
+// Opens minus closes in tokens [first, last)
+long depthChange(const TokenBuffer& tokens, size_t first, size_t last) {
+    long depth = 0;
+    for (size_t i = first; i < last; i++) {
+        TokenType type = tokens.type(i);
+        if (isOpen(type)) {
+            depth++;
+        } else if (isClose(type)) {
+            depth--;
+        }
+    }
+    return depth;
+}
+
+}  // namespace
+
+ParseResult IncrementalParser::parse(const std::string& text) {
+    buffer = text;
+    return fullParse();
+}
+
+ParseResult IncrementalParser::parseFile(const std::string& filePath) {
+    if (!readFile(filePath, buffer)) {
+        buffer.clear();
+        lexed = false;
+        status = ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+        return status;
+    }
+    return fullParse();
+}
+
+ParseResult IncrementalParser::fullParse() {
+    TokenBuffer& tokens = parser.tokenBuffer();
+    tokens.clear();
+    Lexer lexer(buffer.data(), buffer.size());
+    status = lexer.tryTokenize(tokens);
+    lexed = status.ok();
+
+    stats = Stats();
+    stats.lexedBytes = buffer.size();
+    stats.fullParse = true;
+    if (lexed) {
+        return reparse();
+    }
+    return status;
+}
+
+ParseResult IncrementalParser::reparse() {
+    stats.parsedTokens = parser.tokenBuffer().size();
+    status = parser.tryParse();
+    return status;
+}
+
+ParseResult IncrementalParser::edit(size_t offset, size_t length,
+                                    const std::string& replacement) {
+    if (offset > buffer.size() || length > buffer.size() - offset) {
+        return ParseResult(ErrorCode::EDIT_OUT_OF_RANGE, offset);
+    }
+    buffer.replace(offset, length, replacement);
+    if (!lexed || buffer.empty() || buffer.size() > UINT32_MAX) {
+        return fullParse();
+    }
+    stats = Stats();
+
+    TokenBuffer& tokens = parser.tokenBuffer();
+    size_t count = tokens.size();
+    const uint32_t* offsets = tokens.offsetData();
+    int64_t shift = static_cast<int64_t>(replacement.size()) -
+                    static_cast<int64_t>(length);
+    size_t editEnd = offset + replacement.size();
+
+    // The token before the edit may run into it, so re-lexing starts there.
+    // Only whitespace precedes the first token.
+    size_t first = std::lower_bound(offsets, offsets + count, offset) - offsets;
+    size_t start = offset;
+    if (first > 0) {
+        first--;
+        start = offsets[first];
+    }
+    // Old tokens at or after the end of the replaced bytes can be reused
+    size_t reuse =
+        std::lower_bound(offsets, offsets + count, offset + length) - offsets;
+
+    // The bytes around the edit are unchecked; sequences outside them were
+    // valid and still are. Extend to the end of a sequence cut by the edit.
+    size_t checkEnd = editEnd;
+    while (checkEnd < buffer.size() &&
+           (static_cast<uint8_t>(buffer[checkEnd]) & 0xC0) == 0x80) {
+        checkEnd++;
+    }
+    size_t invalid =
+        kernels().validateUtf8(buffer.data() + start, checkEnd - start);
+    if (invalid != checkEnd - start) {
+        lexed = false;
+        status = ParseResult(ErrorCode::INVALID_UTF8, start + invalid);
+        return status;
+    }
+
+    // Re-lex until a new token past the edit starts where a shifted old one
+    // does and has the same type; from there the old stream is unchanged.
+    Lexer lexer(buffer.data(), buffer.size());
+    lexer.seek(start);
+    TokenBuffer fresh;
+    size_t last = count;
+    size_t lexedEnd = buffer.size();
+    while (lexer.next(fresh)) {
+        size_t i = fresh.size() - 1;
+        int64_t at = fresh.offset(i);
+        if (at < static_cast<int64_t>(editEnd)) {
+            continue;
+        }
+        while (reuse < count && offsets[reuse] + shift < at) {
+            reuse++;
+        }
+        if (reuse < count && offsets[reuse] + shift == at &&
+            tokens.type(reuse) == fresh.type(i)) {
+            fresh.pop();
+            last = reuse;
+            lexedEnd = at;
+            break;
+        }
+    }
+    if (!lexer.lastError().ok()) {
+        lexed = false;
+        status = lexer.lastError();
+        stats.lexedBytes = lexer.position() - start;
+        return status;
+    }
+    stats.lexedBytes = lexedEnd - start;
+
+    // The parser only looks at token types, so if they are the same the
+    // document is exactly as valid as before
+    bool sameTypes = fresh.size() == last - first;
+    for (size_t i = 0; sameTypes && i < fresh.size(); i++) {
+        sameTypes = fresh.type(i) == tokens.type(first + i);
+    }
+    bool balanced = depthChange(tokens, first, last) ==
+                    depthChange(fresh, 0, fresh.size());
+
+    tokens.splice(first, last, fresh, shift);
+    tokens.setEndOffset(static_cast<uint32_t>(buffer.size()));
+
+    if (!status.ok()) {
+        // The old error may have been anywhere
+        stats.fullParse = true;
+        return reparse();
+    }
+    if (sameTypes) {
+        return status;
+    }
+
+    // Outside the enclosing container nothing changed, and with the same
+    // bracket balance it is still one value in the same place, so checking
+    // the container checks the document
+    size_t open = 0;
+    size_t close = 0;
+    if (!balanced || !findContainer(first, first + fresh.size(), open, close)) {
+        stats.fullParse = true;
+        return reparse();
+    }
+    stats.parsedTokens = close + 1 - open;
+    status = parser.tryParse(open, close + 1);
+    return status;
+}
+
+// Finds the innermost container that holds all of tokens [first, last):
+// the open bracket before `first` that is left unmatched by the tokens in
+// between and by the range itself, and its matching close.
+bool IncrementalParser::findContainer(size_t first, size_t last, size_t& open,
+                                      size_t& close) const {
+    const TokenBuffer& tokens = parser.tokenBuffer();
+
+    // Closes in the range with no open in the range
+    long depth = 0;
+    long lowest = 0;
+    for (size_t i = first; i < last; i++) {
+        TokenType type = tokens.type(i);
+        if (isOpen(type)) {
+            depth++;
+        } else if (isClose(type)) {
+            depth--;
+            lowest = std::min(lowest, depth);
+        }
+    }
+
+    size_t needed = static_cast<size_t>(-lowest) + 1;
+    size_t nested = 0;
+    size_t i = first;
+    while (needed > 0) {
+        if (i == 0) {
+            return false;
+        }
+        TokenType type = tokens.type(--i);
+        if (isClose(type)) {
+            nested++;
+        } else if (isOpen(type)) {
+            if (nested > 0) {
+                nested--;
+            } else {
+                needed--;
+            }
+        }
+    }
+    open = i;
+
+    depth = 0;
+    for (i = open; i < tokens.size(); i++) {
+        TokenType type = tokens.type(i);
+        if (isOpen(type)) {
+            depth++;
+        } else if (isClose(type) && --depth == 0) {
+            close = i;
+            return true;
+        }
+    }
+    return false;
+}
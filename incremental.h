@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "error.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+// Keeps a document's text and token stream between edits so that an edit is
+// re-lexed and re-parsed locally rather than from the start. Splicing the
+// edit into the text and the token stream is still a linear memmove, and
+// every later token's offset is shifted, so an edit costs one pass of memory
+// bandwidth over the rest of the document. An edit re-lexes from the token
+// before it only until the new tokens line up with the old ones again, and
+// the rest of the old stream is reused with shifted offsets. If the token
+// types did not change (an edit inside a string or number, or to
+// whitespace), nothing is re-parsed. Otherwise only the smallest container
+// enclosing the changed tokens is re-parsed. The whole document is re-parsed
+// when the edit changes bracket balance or the document was already invalid,
+// and re-lexed after a lexical error.
+class IncrementalParser {
+   public:
+    // What the last parse() or edit() had to redo
+    struct Stats {
+        size_t lexedBytes;
+        size_t parsedTokens;
+        bool fullParse;
+
+        Stats() : lexedBytes(0), parsedTokens(0), fullParse(false) {}
+    };
+
+    IncrementalParser() : parser(TokenBuffer()), lexed(false) {}
+
+    ParseResult parse(const std::string& text);
+    ParseResult parseFile(const std::string& filePath);
+
+    // Replaces `length` bytes at `offset` with `replacement` and returns the
+    // state of the whole edited document
+    ParseResult edit(size_t offset, size_t length,
+                     const std::string& replacement);
+
+    const std::string& text() const { return buffer; }
+    const TokenBuffer& tokens() const { return parser.tokenBuffer(); }
+    const ParseResult& result() const { return status; }
+    const Stats& lastStats() const { return stats; }
+
+   private:
+    std::string buffer;
+    Parser parser;      // Owns the token stream
+    bool lexed;         // Whether the tokens cover all of `buffer`
+    ParseResult status;
+    Stats stats;
+
+    ParseResult fullParse();
+    ParseResult reparse();
+    bool findContainer(size_t first, size_t last, size_t& open,
+                       size_t& close) const;
+};
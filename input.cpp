@@ -0,0 +1,21 @@
+#include "input.h"
+
+#include <fstream>
+#include <string>
+
+bool readFile(const std::string &filePath, std::string &contents) {
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    contents.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    if (!contents.empty()) {
+        file.read(&contents[0], contents.size());
+    }
+    return static_cast<bool>(file) || file.eof();
+}
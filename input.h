@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "error.h"
+#include "kernels.h"
+
+// Reads the whole file into `contents`. Returns false if it can't be opened.
+bool readFile(const std::string& filePath, std::string& contents);
+
+// Calls `record(line, size)`, which returns a ParseResult, for each line of
+// NDJSON text that isn't blank. Stops at the first failure and returns it
+// with its offset moved from the start of the line to the start of `data`.
+template <typename Record>
+ParseResult forEachRecord(const char* data, size_t size, Record record) {
+    const Kernels& scan = kernels();
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        const char* newline =
+            static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* lineEnd = newline != nullptr ? newline : end;
+
+        // Blank lines are not records
+        if (scan.skipWhitespace(p, lineEnd - p) != size_t(lineEnd - p)) {
+            ParseResult result = record(p, size_t(lineEnd - p));
+            if (!result.ok()) {
+                result.offset += p - data;
+                return result;
+            }
+        }
+        p = newline != nullptr ? newline + 1 : end;
+    }
+    return ParseResult();
+}
@@ -0,0 +1,759 @@
+#include "kernels.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "char_class.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define KERNELS_NEON 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar kernels, also used for the tails the vector kernels leave behind
+
+static size_t skipWhitespaceScalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && charClass(data[i]) == CC_WHITESPACE) i++;
+    return i;
+}
+
+static size_t scanStringScalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && stringCharClass(data[i]) == SC_PLAIN) i++;
+    return i;
+}
+
+static size_t findStructuralScalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        CharClass cls = charClass(data[i]);
+        if (cls >= CC_LEFT_BRACE && cls <= CC_QUOTE) {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+// Validates whole sequences from `i` until at least `stop`. Returns false and
+// leaves `i` on the offending byte if a sequence is malformed.
+static bool consumeUtf8(const uint8_t* p, size_t size, size_t& i,
+                        size_t stop) {
+    while (i < stop) {
+        size_t length = utf8SequenceLength(
+            reinterpret_cast<const char*>(p + i), size - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+static size_t validateUtf8Scalar(const char* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    consumeUtf8(p, size, i, size);
+    return i;
+}
+
+#if KERNELS_X86 || KERNELS_NEON
+
+// Vector UTF-8 check (Keiser and Lemire, "Validating UTF-8 in less than one
+// instruction per byte"). Each byte is looked up by the high nibble of the
+// byte before it, the low nibble of the byte before it and its own high
+// nibble; a bit set in all three tables names an error the pair makes.
+// Bytes that must be the second or third continuation of a 3- or 4-byte
+// sequence are found from the two and three bytes before them.
+static const uint8_t kTooShort = 1 << 0;      // Lead, then no continuation
+static const uint8_t kTooLong = 1 << 1;       // ASCII, then a continuation
+static const uint8_t kOverlong3 = 1 << 2;     // E0 80..9F
+static const uint8_t kTooLarge = 1 << 3;      // F4 90..BF, F5..FF 90..BF
+static const uint8_t kSurrogate = 1 << 4;     // ED A0..BF
+static const uint8_t kOverlong2 = 1 << 5;     // C0, C1
+static const uint8_t kTooLarge1000 = 1 << 6;  // F5..FF 80..8F
+static const uint8_t kOverlong4 = 1 << 6;     // F0 80..8F
+static const uint8_t kTwoConts = 1 << 7;      // Two continuations in a row
+static const uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) static const uint8_t kUtf8Byte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong,  // 0___
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,  // 10__
+    kTooShort | kOverlong2,                      // 1100
+    kTooShort,                                   // 1101
+    kTooShort | kOverlong3 | kSurrogate,         // 1110
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,  // 1111
+};
+
+alignas(16) static const uint8_t kUtf8Byte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,  // ___0000
+    kCarry | kOverlong2,                            // ___0001
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,                  // ___0100
+    kCarry | kTooLarge | kTooLarge1000,  // ___0101 and above
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,  // ___1101
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) static const uint8_t kUtf8Byte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort,  // 0___
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    // 1000
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+        kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,  // 1001
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,  // 101_
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort,  // 11__
+};
+
+// Subtracted with saturation from the last bytes of a block: non-zero where
+// a sequence starts too late to end in it. Blocks narrower than 64 bytes
+// load the end of this table.
+alignas(64) static const uint8_t kUtf8IncompleteMax[64] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+// The vector kernels stop at the block where they find an error, or at the
+// tail. Everything before `i` is valid except for a sequence that may run
+// into it, so the scalar check restarts at that sequence's lead byte and
+// finds the exact offset.
+static size_t finishUtf8(const uint8_t* p, size_t size, size_t i) {
+    size_t start = i;
+    while (start > 0 && i - start < 4) {
+        start--;
+        if ((p[start] & 0xC0) != 0x80) {
+            break;
+        }
+    }
+    consumeUtf8(p, size, start, size);
+    return start;
+}
+
+#endif  // KERNELS_X86 || KERNELS_NEON
+
+static const Kernels kScalarKernels = {
+    "scalar",
+    skipWhitespaceScalar,
+    scanStringScalar,
+    findStructuralScalar,
+    validateUtf8Scalar,
+};
+
+#if KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// SSE4.2: the string-compare instructions test 16 bytes against a small set
+// of characters or ranges in one instruction
+
+#define SSE42 __attribute__((target("sse4.2")))
+
+SSE42 static size_t skipWhitespaceSse42(const char* data, size_t size) {
+    const __m128i set = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int index = _mm_cmpestri(
+            set, 4, chunk, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY);
+        if (index < 16) {
+            return i + index;
+        }
+    }
+    return i + skipWhitespaceScalar(data + i, size - i);
+}
+
+SSE42 static size_t scanStringSse42(const char* data, size_t size) {
+    // Ranges: control characters, '"' and backslash
+    const __m128i ranges = _mm_setr_epi8(0x00, 0x1F, '"', '"', '\\', '\\', 0,
+                                         0, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int index = _mm_cmpestri(ranges, 6, chunk, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES);
+        if (index < 16) {
+            return i + index;
+        }
+    }
+    return i + scanStringScalar(data + i, size - i);
+}
+
+SSE42 static size_t findStructuralSse42(const char* data, size_t size) {
+    const __m128i set = _mm_setr_epi8('{', '}', '[', ']', ':', ',', '"', 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int index = _mm_cmpestri(set, 7, chunk, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY);
+        if (index < 16) {
+            return i + index;
+        }
+    }
+    return i + findStructuralScalar(data + i, size - i);
+}
+
+// Error bits for the 16 bytes of `input`, given the block before it
+SSE42 static __m128i utf8ErrorsSse42(__m128i input, __m128i prev) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i byte1High = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kUtf8Byte1High)),
+        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte1Low = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kUtf8Byte1Low)),
+        _mm_and_si128(prev1, nibble));
+    __m128i byte2High = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kUtf8Byte2High)),
+        _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special =
+        _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    // 0x80 where the byte follows a 3- or 4-byte lead by two or three
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14),
+                                  _mm_set1_epi8(char(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13),
+                                   _mm_set1_epi8(char(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth),
+                                   _mm_set1_epi8(char(0x80)));
+    return _mm_xor_si128(must23, special);
+}
+
+SSE42 static size_t validateUtf8Sse42(const char* data, size_t size) {
+    const __m128i incompleteMax = _mm_load_si128(
+        reinterpret_cast<const __m128i*>(kUtf8IncompleteMax + 48));
+    __m128i prev = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(chunk) == 0) {
+            // All ASCII: only a sequence left open before it can fail
+            if (!_mm_testz_si128(incomplete, incomplete)) {
+                break;
+            }
+        } else {
+            __m128i errors = utf8ErrorsSse42(chunk, prev);
+            if (!_mm_testz_si128(errors, errors)) {
+                break;
+            }
+            incomplete = _mm_subs_epu8(chunk, incompleteMax);
+        }
+        prev = chunk;
+    }
+    return finishUtf8(reinterpret_cast<const uint8_t*>(data), size, i);
+}
+
+static const Kernels kSse42Kernels = {
+    "sse4.2",
+    skipWhitespaceSse42,
+    scanStringSse42,
+    findStructuralSse42,
+    validateUtf8Sse42,
+};
+
+// ---------------------------------------------------------------------------
+// AVX2: 32 bytes per iteration with byte compares and a movemask
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static size_t skipWhitespaceAvx2(const char* data, size_t size) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i c =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, space),
+                            _mm256_cmpeq_epi8(c, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, newline),
+                            _mm256_cmpeq_epi8(c, carriage)));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + skipWhitespaceScalar(data + i, size - i);
+}
+
+AVX2 static size_t scanStringAvx2(const char* data, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i c =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        // c <= 0x1F (unsigned) exactly when min(c, 0x1F) == c
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, quote),
+                            _mm256_cmpeq_epi8(c, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(c, control), c));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + scanStringScalar(data + i, size - i);
+}
+
+AVX2 static size_t findStructuralAvx2(const char* data, size_t size) {
+    const char structural[] = {'{', '}', '[', ']', ':', ',', '"'};
+    __m256i needles[7];
+    for (int k = 0; k < 7; k++) {
+        needles[k] = _mm256_set1_epi8(structural[k]);
+    }
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i c =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hit = _mm256_cmpeq_epi8(c, needles[0]);
+        for (int k = 1; k < 7; k++) {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, needles[k]));
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + findStructuralScalar(data + i, size - i);
+}
+
+// Bytes of `input` shifted along by `n`, with the end of `prev` shifted in
+#define AVX2_PREV(input, prev, n)                                         \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), \
+                       16 - (n))
+
+// Error bits for the 32 bytes of `input`, given the block before it
+AVX2 static __m256i utf8ErrorsAvx2(__m256i input, __m256i prev) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i prev1 = AVX2_PREV(input, prev, 1);
+    __m256i byte1High = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_load_si128(
+            reinterpret_cast<const __m128i*>(kUtf8Byte1High))),
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte1Low = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(kUtf8Byte1Low))),
+        _mm256_and_si256(prev1, nibble));
+    __m256i byte2High = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_load_si128(
+            reinterpret_cast<const __m128i*>(kUtf8Byte2High))),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low),
+                                       byte2High);
+
+    __m256i third = _mm256_subs_epu8(AVX2_PREV(input, prev, 2),
+                                     _mm256_set1_epi8(char(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(AVX2_PREV(input, prev, 3),
+                                      _mm256_set1_epi8(char(0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                      _mm256_set1_epi8(char(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+#undef AVX2_PREV
+
+AVX2 static size_t validateUtf8Avx2(const char* data, size_t size) {
+    const __m256i incompleteMax = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(kUtf8IncompleteMax + 32));
+    __m256i prev = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(chunk) == 0) {
+            if (!_mm256_testz_si256(incomplete, incomplete)) {
+                break;
+            }
+        } else {
+            __m256i errors = utf8ErrorsAvx2(chunk, prev);
+            if (!_mm256_testz_si256(errors, errors)) {
+                break;
+            }
+            incomplete = _mm256_subs_epu8(chunk, incompleteMax);
+        }
+        prev = chunk;
+    }
+    return finishUtf8(reinterpret_cast<const uint8_t*>(data), size, i);
+}
+
+static const Kernels kAvx2Kernels = {
+    "avx2",
+    skipWhitespaceAvx2,
+    scanStringAvx2,
+    findStructuralAvx2,
+    validateUtf8Avx2,
+};
+
+// ---------------------------------------------------------------------------
+// AVX-512BW: 64 bytes per iteration, compares produce masks directly
+
+#define AVX512 __attribute__((target("avx512f,avx512bw")))
+
+AVX512 static size_t skipWhitespaceAvx512(const char* data, size_t size) {
+    const __m512i space = _mm512_set1_epi8(' ');
+    const __m512i tab = _mm512_set1_epi8('\t');
+    const __m512i newline = _mm512_set1_epi8('\n');
+    const __m512i carriage = _mm512_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i c = _mm512_loadu_si512(data + i);
+        uint64_t ws = _mm512_cmpeq_epi8_mask(c, space) |
+                      _mm512_cmpeq_epi8_mask(c, tab) |
+                      _mm512_cmpeq_epi8_mask(c, newline) |
+                      _mm512_cmpeq_epi8_mask(c, carriage);
+        if (~ws != 0) {
+            return i + __builtin_ctzll(~ws);
+        }
+    }
+    return i + skipWhitespaceScalar(data + i, size - i);
+}
+
+AVX512 static size_t scanStringAvx512(const char* data, size_t size) {
+    const __m512i quote = _mm512_set1_epi8('"');
+    const __m512i backslash = _mm512_set1_epi8('\\');
+    const __m512i control = _mm512_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i c = _mm512_loadu_si512(data + i);
+        uint64_t hit = _mm512_cmpeq_epi8_mask(c, quote) |
+                       _mm512_cmpeq_epi8_mask(c, backslash) |
+                       _mm512_cmple_epu8_mask(c, control);
+        if (hit != 0) {
+            return i + __builtin_ctzll(hit);
+        }
+    }
+    return i + scanStringScalar(data + i, size - i);
+}
+
+AVX512 static size_t findStructuralAvx512(const char* data, size_t size) {
+    const char structural[] = {'{', '}', '[', ']', ':', ',', '"'};
+    __m512i needles[7];
+    for (int k = 0; k < 7; k++) {
+        needles[k] = _mm512_set1_epi8(structural[k]);
+    }
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i c = _mm512_loadu_si512(data + i);
+        uint64_t hit = 0;
+        for (int k = 0; k < 7; k++) {
+            hit |= _mm512_cmpeq_epi8_mask(c, needles[k]);
+        }
+        if (hit != 0) {
+            return i + __builtin_ctzll(hit);
+        }
+    }
+    return i + findStructuralScalar(data + i, size - i);
+}
+
+// Bytes of `input` shifted along by `n`, with the end of `prev` shifted in.
+// The permute lines up each 128-bit lane with the lane before it.
+#define AVX512_PREV(input, prev, n)                                        \
+    _mm512_alignr_epi8(                                                    \
+        input,                                                             \
+        _mm512_permutex2var_epi64(                                         \
+            prev, _mm512_set_epi64(13, 12, 11, 10, 9, 8, 7, 6), input), \
+        16 - (n))
+
+// A 16-byte table in every lane. The zero-masked broadcast, because the
+// plain one starts from an undefined vector that GCC warns about at -O2.
+AVX512 static __m512i broadcastTable(const uint8_t* table) {
+    return _mm512_maskz_broadcast_i32x4(
+        __mmask16(0xFFFF),
+        _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+// Error bits for the 64 bytes of `input`, given the block before it
+AVX512 static __m512i utf8ErrorsAvx512(__m512i input, __m512i prev) {
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    __m512i prev1 = AVX512_PREV(input, prev, 1);
+    __m512i byte1High = _mm512_shuffle_epi8(
+        broadcastTable(kUtf8Byte1High),
+        _mm512_and_si512(_mm512_srli_epi16(prev1, 4), nibble));
+    __m512i byte1Low = _mm512_shuffle_epi8(broadcastTable(kUtf8Byte1Low),
+                                           _mm512_and_si512(prev1, nibble));
+    __m512i byte2High = _mm512_shuffle_epi8(
+        broadcastTable(kUtf8Byte2High),
+        _mm512_and_si512(_mm512_srli_epi16(input, 4), nibble));
+    __m512i special = _mm512_and_si512(_mm512_and_si512(byte1High, byte1Low),
+                                       byte2High);
+
+    __m512i third = _mm512_subs_epu8(AVX512_PREV(input, prev, 2),
+                                     _mm512_set1_epi8(char(0xE0 - 0x80)));
+    __m512i fourth = _mm512_subs_epu8(AVX512_PREV(input, prev, 3),
+                                      _mm512_set1_epi8(char(0xF0 - 0x80)));
+    __m512i must23 = _mm512_and_si512(_mm512_or_si512(third, fourth),
+                                      _mm512_set1_epi8(char(0x80)));
+    return _mm512_xor_si512(must23, special);
+}
+
+#undef AVX512_PREV
+
+AVX512 static size_t validateUtf8Avx512(const char* data, size_t size) {
+    const __m512i incompleteMax = _mm512_load_si512(kUtf8IncompleteMax);
+    __m512i prev = _mm512_setzero_si512();
+    __m512i incomplete = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i chunk = _mm512_loadu_si512(data + i);
+        if (_mm512_movepi8_mask(chunk) == 0) {
+            if (_mm512_test_epi8_mask(incomplete, incomplete) != 0) {
+                break;
+            }
+        } else {
+            __m512i errors = utf8ErrorsAvx512(chunk, prev);
+            if (_mm512_test_epi8_mask(errors, errors) != 0) {
+                break;
+            }
+            incomplete = _mm512_subs_epu8(chunk, incompleteMax);
+        }
+        prev = chunk;
+    }
+    return finishUtf8(reinterpret_cast<const uint8_t*>(data), size, i);
+}
+
+static const Kernels kAvx512Kernels = {
+    "avx512",
+    skipWhitespaceAvx512,
+    scanStringAvx512,
+    findStructuralAvx512,
+    validateUtf8Avx512,
+};
+
+#endif  // KERNELS_X86
+
+#if KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// NEON: 16 bytes per iteration. There is no movemask, so a block with a hit
+// is handed to the scalar kernel, which finds the exact index.
+
+static size_t skipWhitespaceNeon(const char* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t c = vld1q_u8(p + i);
+        uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(c, vdupq_n_u8(' ')),
+                                          vceqq_u8(c, vdupq_n_u8('\t'))),
+                                 vorrq_u8(vceqq_u8(c, vdupq_n_u8('\n')),
+                                          vceqq_u8(c, vdupq_n_u8('\r'))));
+        if (vminvq_u8(ws) != 0xFF) {
+            break;
+        }
+    }
+    return i + skipWhitespaceScalar(data + i, size - i);
+}
+
+static size_t scanStringNeon(const char* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t c = vld1q_u8(p + i);
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(c, vdupq_n_u8('"')),
+                                           vceqq_u8(c, vdupq_n_u8('\\'))),
+                                  vcltq_u8(c, vdupq_n_u8(0x20)));
+        if (vmaxvq_u8(hit) != 0) {
+            break;
+        }
+    }
+    return i + scanStringScalar(data + i, size - i);
+}
+
+static size_t findStructuralNeon(const char* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t c = vld1q_u8(p + i);
+        uint8x16_t hit = vorrq_u8(vceqq_u8(c, vdupq_n_u8('{')),
+                                  vceqq_u8(c, vdupq_n_u8('}')));
+        hit = vorrq_u8(hit, vceqq_u8(c, vdupq_n_u8('[')));
+        hit = vorrq_u8(hit, vceqq_u8(c, vdupq_n_u8(']')));
+        hit = vorrq_u8(hit, vceqq_u8(c, vdupq_n_u8(':')));
+        hit = vorrq_u8(hit, vceqq_u8(c, vdupq_n_u8(',')));
+        hit = vorrq_u8(hit, vceqq_u8(c, vdupq_n_u8('"')));
+        if (vmaxvq_u8(hit) != 0) {
+            break;
+        }
+    }
+    return i + findStructuralScalar(data + i, size - i);
+}
+
+// Error bits for the 16 bytes of `input`, given the block before it
+static uint8x16_t utf8ErrorsNeon(uint8x16_t input, uint8x16_t prev) {
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    uint8x16_t prev1 = vextq_u8(prev, input, 15);
+    uint8x16_t byte1High =
+        vqtbl1q_u8(vld1q_u8(kUtf8Byte1High), vshrq_n_u8(prev1, 4));
+    uint8x16_t byte1Low =
+        vqtbl1q_u8(vld1q_u8(kUtf8Byte1Low), vandq_u8(prev1, nibble));
+    uint8x16_t byte2High =
+        vqtbl1q_u8(vld1q_u8(kUtf8Byte2High), vshrq_n_u8(input, 4));
+    uint8x16_t special = vandq_u8(vandq_u8(byte1High, byte1Low), byte2High);
+
+    uint8x16_t third =
+        vqsubq_u8(vextq_u8(prev, input, 14), vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t fourth =
+        vqsubq_u8(vextq_u8(prev, input, 13), vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+    return veorq_u8(must23, special);
+}
+
+static size_t validateUtf8Neon(const char* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8x16_t incompleteMax = vld1q_u8(kUtf8IncompleteMax + 48);
+    uint8x16_t prev = vdupq_n_u8(0);
+    uint8x16_t incomplete = vdupq_n_u8(0);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(p + i);
+        if (vmaxvq_u8(chunk) < 0x80) {
+            if (vmaxvq_u8(incomplete) != 0) {
+                break;
+            }
+        } else {
+            if (vmaxvq_u8(utf8ErrorsNeon(chunk, prev)) != 0) {
+                break;
+            }
+            incomplete = vqsubq_u8(chunk, incompleteMax);
+        }
+        prev = chunk;
+    }
+    return finishUtf8(p, size, i);
+}
+
+static const Kernels kNeonKernels = {
+    "neon",
+    skipWhitespaceNeon,
+    scanStringNeon,
+    findStructuralNeon,
+    validateUtf8Neon,
+};
+
+#endif  // KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+
+struct KernelEntry {
+    const Kernels* kernels;
+    bool (*supported)();
+};
+
+static bool alwaysSupported() { return true; }
+
+#if KERNELS_X86
+static bool sse42Supported() { return __builtin_cpu_supports("sse4.2"); }
+
+static bool avx2Supported() { return __builtin_cpu_supports("avx2"); }
+
+static bool avx512Supported() {
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+}
+#endif
+
+#if KERNELS_NEON
+static bool neonSupported() {
+#if defined(__linux__) && defined(HWCAP_ASIMD)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+    return true;  // Advanced SIMD is mandatory on AArch64
+#endif
+}
+#endif
+
+// Fastest first
+static const KernelEntry kKernelEntries[] = {
+#if KERNELS_X86
+    {&kAvx512Kernels, avx512Supported},
+    {&kAvx2Kernels, avx2Supported},
+    {&kSse42Kernels, sse42Supported},
+#endif
+#if KERNELS_NEON
+    {&kNeonKernels, neonSupported},
+#endif
+    {&kScalarKernels, alwaysSupported},
+};
+
+const Kernels* kernelsFor(const std::string& name) {
+    for (const KernelEntry& entry : kKernelEntries) {
+        if (name == entry.kernels->name) {
+            return entry.supported() ? entry.kernels : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> availableKernels() {
+    std::vector<std::string> names;
+    for (const KernelEntry& entry : kKernelEntries) {
+        if (entry.supported()) {
+            names.push_back(entry.kernels->name);
+        }
+    }
+    return names;
+}
+
+static const Kernels& selectKernels() {
+    const char* forced = std::getenv("JSON_PARSER_KERNEL");
+    if (forced != nullptr && *forced != '\0') {
+        const Kernels* chosen = kernelsFor(forced);
+        if (chosen != nullptr) {
+            return *chosen;
+        }
+        std::cerr << "JSON_PARSER_KERNEL=" << forced
+                  << " is not available on this CPU, ignoring it" << std::endl;
+    }
+
+    for (const KernelEntry& entry : kKernelEntries) {
+        if (entry.supported()) {
+            return *entry.kernels;
+        }
+    }
+    return kScalarKernels;
+}
+
+const Kernels& kernels() {
+    static const Kernels& selected = selectKernels();
+    return selected;
+}
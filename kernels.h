@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Byte-scanning kernels used on the Lexer/Validator hot paths. Every kernel
+// returns the index of the first byte it stops at, or `size` if it ran off
+// the end of the buffer.
+struct Kernels {
+    const char* name;
+
+    // First byte that is not JSON whitespace (space, \t, \n, \r)
+    size_t (*skipWhitespace)(const char* data, size_t size);
+
+    // First '"', backslash or control character inside a string body
+    size_t (*scanString)(const char* data, size_t size);
+
+    // First structural byte or quote: { } [ ] : , "
+    size_t (*findStructural)(const char* data, size_t size);
+
+    // First byte of a malformed UTF-8 sequence. The vector versions check
+    // whole blocks with nibble lookups and only rescan the block holding an
+    // error to find its exact offset.
+    size_t (*validateUtf8)(const char* data, size_t size);
+};
+
+// The implementation picked for this CPU, chosen once on first use. Setting
+// JSON_PARSER_KERNEL to one of the names from availableKernels() forces a
+// specific implementation, e.g. for benchmarking or testing each path.
+const Kernels& kernels();
+
+// A specific implementation by name ("scalar", "sse4.2", "avx2", "avx512",
+// "neon"), or nullptr if it isn't compiled in or this CPU can't run it.
+const Kernels* kernelsFor(const std::string& name);
+
+// Names of the implementations this CPU can run, fastest first.
+std::vector<std::string> availableKernels();
@@ -0,0 +1,102 @@
+#include "key_shapes.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+KeyShapes::KeyShapes(std::pmr::memory_resource* memory)
+    : nodes(memory),
+      keyBytes(memory),
+      stack(memory),
+      full(false),
+      tried(0),
+      matched(0) {}
+
+void KeyShapes::clear() {
+    forget();
+    tried = 0;
+    matched = 0;
+}
+
+void KeyShapes::begin() {
+    stack.clear();
+    if (full) {
+        forget();
+    }
+    if (nodes.empty()) {
+        addNode();  // kNone
+        addNode();  // The root
+    }
+}
+
+void KeyShapes::open(bool object) {
+    uint32_t node = kNone;
+    if (stack.empty()) {
+        node = 1;
+    } else if (stack.back().object) {
+        Member* member = currentMember();
+        if (member != nullptr) {
+            if (member->child == kNone) {
+                uint32_t child = addNode();
+                member->child = child;  // Members don't move with nodes
+            }
+            node = member->child;
+        }
+    } else if (stack.back().node != kNone) {
+        uint32_t parent = stack.back().node;
+        if (nodes[parent].elements == kNone) {
+            uint32_t child = addNode();
+            nodes[parent].elements = child;
+        }
+        node = nodes[parent].elements;
+    }
+    stack.push_back(Frame{node, 0, object});
+}
+
+void KeyShapes::learn(StringRef raw, bool hasEscapes) {
+    if (stack.empty()) {
+        return;
+    }
+    const Frame& top = stack.back();
+    if (!top.object || top.node == kNone || top.member >= kMaxMembers) {
+        return;
+    }
+    std::pmr::vector<Member>& members = nodes[top.node].members;
+    if (top.member > members.size()) {
+        return;  // An earlier member had no string key
+    }
+    if (top.member == members.size()) {
+        members.push_back(Member{0, 0, false, kNone});
+    }
+
+    // Shorter keys overwrite the old bytes; longer ones go at the end
+    Member& member = members[top.member];
+    if (raw.size > member.keyLength) {
+        if (keyBytes.size() + raw.size > kMaxKeyBytes) {
+            member.keyLength = 0;  // No prediction until forget()
+            full = true;
+            return;
+        }
+        // Grow first: if the memory limit stops the resize, the member keeps
+        // its old, still valid key
+        size_t offset = keyBytes.size();
+        keyBytes.resize(offset + raw.size);
+        member.keyOffset = static_cast<uint32_t>(offset);
+    }
+    memcpy(keyBytes.data() + member.keyOffset, raw.data, raw.size);
+    member.keyLength = static_cast<uint32_t>(raw.size);
+    member.hasEscapes = hasEscapes;
+}
+
+void KeyShapes::forget() {
+    nodes.clear();
+    keyBytes.clear();
+    stack.clear();
+    full = false;
+}
+
+uint32_t KeyShapes::addNode() {
+    nodes.emplace_back(nodes.get_allocator().resource());
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
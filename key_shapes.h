@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "string_ref.h"
+
+// Object keys learned from earlier input, for the Lexer to predict the keys
+// of the next record (see Lexer::predictKeys()). Records of an NDJSON stream,
+// or the elements of a large array, nearly always repeat the same keys in
+// the same order, so the key at each position of each nesting path is
+// remembered: member 2 of the object under member 5 of the root, say. When
+// the Lexer reaches a key it compares the remembered bytes with the input in
+// one memcmp instead of scanning the string, and learns the new key when
+// they differ. Arrays share one shape between their elements.
+//
+// Keys are kept raw, quotes and escapes included, so a match lexes exactly
+// as the scan would. Shapes cover the first kMaxMembers members of an
+// object. Once the key bytes of all shapes reach kMaxKeyBytes, as keys that
+// are really data (ids, timestamps) keep changing, everything learned is
+// dropped at the start of the next input and learned again.
+class KeyShapes {
+   public:
+    static const size_t kMaxMembers = 256;
+    static const size_t kMaxKeyBytes = 1 << 20;
+
+    explicit KeyShapes(std::pmr::memory_resource* memory =
+                           std::pmr::get_default_resource());
+
+    // Keys the Lexer met, and how many of them were predicted
+    size_t lookups() const { return tried; }
+    size_t hits() const { return matched; }
+    double hitRate() const {
+        return tried == 0 ? 0 : static_cast<double>(matched) / tried;
+    }
+
+    // Forgets every shape and resets the counts
+    void clear();
+
+    // Called by the Lexer as it goes
+
+    // Starts a new input at the root shape
+    void begin();
+    // At '{' or '['
+    void open(bool object);
+    // At '}' or ']'
+    void close() {
+        if (!stack.empty()) {
+            stack.pop_back();
+        }
+    }
+    // At ','. Returns whether a key comes next.
+    bool next() {
+        if (stack.empty() || !stack.back().object) {
+            return false;
+        }
+        stack.back().member++;
+        return true;
+    }
+    // Raw bytes, quotes included, of the key expected next; empty if there
+    // is no prediction
+    StringRef expected(bool& hasEscapes) {
+        tried++;
+        const Member* member = currentMember();
+        if (member == nullptr) {
+            return StringRef();
+        }
+        hasEscapes = member->hasEscapes;
+        return StringRef(keyBytes.data() + member->keyOffset,
+                         member->keyLength);
+    }
+    void hit() { matched++; }
+    // The key actually found where expected() was asked
+    void learn(StringRef raw, bool hasEscapes);
+
+   private:
+    static const uint32_t kNone = 0;
+
+    struct Member {
+        uint32_t keyOffset;  // In keyBytes
+        uint32_t keyLength;
+        bool hasEscapes;
+        uint32_t child;  // Shape of the member's value, or kNone
+    };
+    struct Node {
+        std::pmr::vector<Member> members;
+        uint32_t elements;  // Shape of array elements, or kNone
+
+        explicit Node(std::pmr::memory_resource* memory)
+            : members(memory), elements(kNone) {}
+    };
+    struct Frame {
+        uint32_t node;
+        uint32_t member;  // Of the key or value being lexed
+        bool object;
+    };
+
+    std::pmr::vector<Node> nodes;  // Past begin(): [0] unused, [1] the root
+    std::pmr::vector<char> keyBytes;
+    std::pmr::vector<Frame> stack;
+    bool full;  // A key didn't fit in kMaxKeyBytes
+    size_t tried;
+    size_t matched;
+
+    void forget();
+    uint32_t addNode();
+    Member* currentMember() {
+        if (stack.empty()) {
+            return nullptr;
+        }
+        const Frame& top = stack.back();
+        if (!top.object || top.node == kNone) {
+            return nullptr;
+        }
+        std::pmr::vector<Member>& members = nodes[top.node].members;
+        return top.member < members.size() ? &members[top.member] : nullptr;
+    }
+};
@@ -1,304 +1,368 @@
 #include "lexer.h"
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <stack>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "char_class.h"
+#include "input.h"
+#include "kernels.h"
+#include "key_shapes.h"
+#include "memory.h"
 #include "token.h"
 
-Lexer::Lexer(const std::string &filePath) {
-    file.open(filePath);
-    line = 1;
-    column = 1;
+// Token emitted for each single-byte structural class, indexed by CharClass
+static const TokenType kStructuralTokens[CC_COUNT] = {
+    TokenType::NULL_TOKEN,     // CC_OTHER (unused)
+    TokenType::NULL_TOKEN,     // CC_WHITESPACE (unused)
+    TokenType::LEFT_BRACE,     // CC_LEFT_BRACE
+    TokenType::RIGHT_BRACE,    // CC_RIGHT_BRACE
+    TokenType::LEFT_BRACKET,   // CC_LEFT_BRACKET
+    TokenType::RIGHT_BRACKET,  // CC_RIGHT_BRACKET
+    TokenType::COLON,          // CC_COLON
+    TokenType::COMMA,          // CC_COMMA
+};
+
+Lexer::Lexer(const std::string &filePath)
+    : keyShapes(nullptr), tracking(nullptr), expectKey(false) {
+    opened = readFile(filePath, buffer);
+    begin = buffer.data();
+    end = begin + buffer.size();
+    current = begin;
 }
 
-std::vector<Token> Lexer::tokenize() {
-    char firstChar = file.peek();
-    if (firstChar == EOF) {
-        throwError("Invalid JSON: empty input");
-    }
+Lexer::Lexer(const char *data, size_t size)
+    : begin(data),
+      end(data + size),
+      current(data),
+      opened(true),
+      keyShapes(nullptr),
+      tracking(nullptr),
+      expectKey(false) {}
 
+std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
-    char c;
-
-    while (file.get(c)) {
-        // Handle single-character tokens
-        if (c == '{')
-            tokens.push_back(Token(TokenType::LEFT_BRACE, "{"));
-        else if (c == '}')
-            tokens.push_back(Token(TokenType::RIGHT_BRACE, "}"));
-        else if (c == '[')
-            tokens.push_back(Token(TokenType::LEFT_BRACKET, "["));
-        else if (c == ']')
-            tokens.push_back(Token(TokenType::RIGHT_BRACKET, "]"));
-        else if (c == ':')
-            tokens.push_back(Token(TokenType::COLON, ":"));
-        else if (c == ',')
-            tokens.push_back(Token(TokenType::COMMA, ","));
-        // Handle strings
-        else if (c == '"') {
-            tokens.push_back(tokenizeString());
-        }
-        // Handle numbers
-        else if (isdigit(c) || c == '-') {
-            tokens.push_back(tokenizeDigit(c));
-        }
-        // Handle true/false/null
-        else if (c == 't') {
-            tokens.push_back(tokenizeTrue());
-        } else if (c == 'f') {
-            tokens.push_back(tokenizeFalse());
-        } else if (c == 'n') {
-            tokens.push_back(tokenizeNull());
-        }
-        // Skip whitespace
-        else if (isspace(c)) {
-            continue;
-        }
-        // Invalid character
-        else {
-            throwError("Invalid character: " + std::string(1, c));
-        }
+    ParseResult result = tryTokenize(tokens);
+    if (!result.ok()) {
+        throw std::runtime_error(result.message());
     }
-
     return tokens;
 }
 
-Token Lexer::tokenizeString() {
-    char c;
-    std::string str;
-    while (file.get(c)) {
-        if (c == '\\') {
-            char escape = handleEscape();
-            str += escape;
-            continue;
-        }
-        if (c == '"') {
-            return Token(TokenType::STRING, str);
-        }
-        str += c;
-    }
-    if (file.eof()) {
-        throwError("Unterminated string - missing closing quote");
-    }
-
-    // Add a return here to satisfy compiler, though throwError will end
-    // execution
-    return Token(TokenType::STRING, "");
-}
+ParseResult Lexer::tryTokenize(std::vector<Token> &tokens) {
+    TokenBuffer compact;
+    ParseResult result = tryTokenize(compact);
 
-char Lexer::handleEscape() {
-    char c;
-    file.get(c);
-
-    switch (c) {
-        case '\\':
-            return '\\';
-        case '\"':
-            return '\"';
-        case '/':
-            return '/';
-        case 'b':
-            return '\b';
-        case 'f':
-            return '\f';
-        case 'n':
-            return '\n';
-        case 'r':
-            return '\r';
-        case 't':
-            return '\t';
-        case 'u':
-            // Handle Unicode sequences (this needs additional implementation)
-            throwError("Unicode sequences not yet implemented");
-        default:
-            throwError("Invalid escape sequence: \\" + std::string(1, c));
+    tokens.reserve(tokens.size() + compact.size());
+    for (size_t i = 0; i < compact.size(); i++) {
+        tokens.push_back(
+            Token(compact.type(i), lexeme(compact, i), compact.offset(i)));
     }
-    // Add a return here to satisfy compiler, though throwError will end
-    // execution
-    return '\0';
+    return result;
 }
 
-enum class NumberState {
-    INTEGER,   // Parsing the integer part (before decimal)
-    FRACTION,  // Parsing decimal places
-    EXPONENT,  // Parsing the exponent
-};
-
-Token Lexer::tokenizeDigit(char &c) {
-    std::string number;
-
-    NumberState state = NumberState::INTEGER;
-
-    number += c;
-
-    while (file.peek() != EOF) {
-        c = file.peek();
-
-        switch (state) {
-            case NumberState::INTEGER:
-                if (c == '.') {
-                    // Move to fraction state
-                    state = NumberState::FRACTION;
-                    number += file.get();  // Consume the '.'
-                } else if (c == 'e' || c == 'E') {
-                    // Move to exponent state
-                    state = NumberState::EXPONENT;
-                    number += file.get();  // Consume the 'e' or 'E'
-                } else if (isdigit(c)) {
-                    // Stay in integer state
-                    number += file.get();  // Consume the digit
-                } else {
-                    // End of number reached
-                    return Token(TokenType::NUMBER, number);
-                }
-                break;
+ParseResult Lexer::tryTokenize(TokenBuffer &tokens) {
+    error = ParseResult();
+    current = begin;
 
-            case NumberState::FRACTION:
-                if (!isdigit(c)) {  // First check after decimal point
-                    throwError(
-                        "invalid number - expected digit after decimal point");
-                }
-                number += file.get();  // Consume first digit after decimal
-
-                while (file.peek() != EOF) {
-                    c = file.peek();
-                    if (c == '.') {
-                        throwError("invalid number - multiple decimal points");
-                    } else if (c == 'e' || c == 'E') {
-                        state = NumberState::EXPONENT;
-                        number += file.get();
-                        break;
-                    } else if (isdigit(c)) {
-                        number += file.get();
-                    } else {
-                        return Token(TokenType::NUMBER, number);
-                    }
-                }
-                break;
-
-            case NumberState::EXPONENT:
-                // First character after 'e'/'E' can be +/- or must be digit
-                c = file.peek();
-                if (c == '+' || c == '-') {
-                    number += file.get();  // Consume the sign
-                    c = file.peek();
-                }
+    if (!opened) {
+        fail(ErrorCode::CANNOT_OPEN_FILE, begin);
+        return error;
+    }
+    if (begin == end) {
+        fail(ErrorCode::EMPTY_INPUT, begin);
+        return error;
+    }
+    // Token offsets are 32-bit
+    if (size() > UINT32_MAX) {
+        fail(ErrorCode::INPUT_TOO_LARGE, begin);
+        return error;
+    }
 
-                // Must have at least one digit after e/E (+/-)
-                if (!isdigit(c)) {
-                    throwError("invalid number - expected digit in exponent");
-                }
+    const Kernels &scan = kernels();
+    size_t invalid = scan.validateUtf8(begin, size());
+    if (invalid != size()) {
+        fail(ErrorCode::INVALID_UTF8, begin + invalid);
+        return error;
+    }
 
-                // Consume first digit
-                number += file.get();
-
-                // Continue consuming digits until non-digit
-                while (file.peek() != EOF) {
-                    c = file.peek();
-                    if (isdigit(c)) {
-                        number += file.get();
-                    } else {
-                        return Token(TokenType::NUMBER, number);
-                    }
-                }
-                break;
+    tokens.setEndOffset(offsetOf(end));
+    tracking = keyShapes;
+    expectKey = false;
+    if (tracking != nullptr) {
+        tracking->begin();
+    }
+    try {
+        while (current < end && step(tokens)) {
         }
+    } catch (const MemoryLimitExceeded&) {
+        tokens.clear();  // The two arrays may differ in length
+        fail(ErrorCode::MEMORY_LIMIT_EXCEEDED, current);
     }
+    tracking = nullptr;
+    expectKey = false;  // Input may end inside an object
 
-    // After the switch statement, handle EOF
-    return Token(TokenType::NUMBER, number);
+    return error;
 }
 
-Token Lexer::tokenizeTrue() {
-    char c;
-    std::string trueStr = "rue";  // We already consumed 't'
+void Lexer::seek(size_t offset) {
+    error = ParseResult();
+    current = begin + offset;
+    expectKey = false;
+}
 
-    for (char expected : trueStr) {
-        if (file.eof()) {
-            throwError("Unexpected EOF while parsing 'true'");
+bool Lexer::next(TokenBuffer &tokens) {
+    size_t count = tokens.size();
+    while (current < end) {
+        if (!step(tokens)) {
+            return false;
         }
-
-        file.get(c);
-        if (c != expected) {
-            throwError("Invalid literal: expected 'true'");
+        if (tokens.size() > count) {
+            return true;
         }
     }
+    return false;
+}
 
-    // Peek next character to ensure it's a valid delimiter
-    c = file.peek();
-    if (!isspace(c) && c != ',' && c != '}' && c != ']' && c != EOF) {
-        throwError("Invalid character after 'true' literal");
+// Consumes one token, or one run of whitespace, at `current`
+bool Lexer::step(TokenBuffer &tokens) {
+    CharClass cls = charClass(*current);
+    switch (cls) {
+        case CC_WHITESPACE:
+            current += kernels().skipWhitespace(current, end - current);
+            return true;
+        case CC_LEFT_BRACE:
+        case CC_RIGHT_BRACE:
+        case CC_LEFT_BRACKET:
+        case CC_RIGHT_BRACKET:
+        case CC_COLON:
+        case CC_COMMA:
+            tokens.push(kStructuralTokens[cls], offsetOf(current));
+            current++;
+            if (tracking != nullptr) {
+                trackShape(cls);
+            }
+            return true;
+        case CC_QUOTE:
+            return expectKey ? tokenizeKey(tokens) : tokenizeString(tokens);
+        case CC_NUMBER:
+            return tokenizeNumber(tokens);
+        case CC_TRUE:
+            return tokenizeLiteral(TokenType::TRUE, "true", 4, tokens);
+        case CC_FALSE:
+            return tokenizeLiteral(TokenType::FALSE, "false", 5, tokens);
+        case CC_NULL:
+            return tokenizeLiteral(TokenType::NULL_TOKEN, "null", 4, tokens);
+        default:
+            return fail(ErrorCode::INVALID_CHARACTER, current, *current);
     }
-
-    return Token(TokenType::TRUE, "true");
 }
 
-Token Lexer::tokenizeFalse() {
-    char c;
-    std::string falseStr = "alse";  // We already consumed 'f'
+// Follows the nesting for the KeyShapes being predicted from
+inline void Lexer::trackShape(CharClass cls) {
+    switch (cls) {
+        case CC_LEFT_BRACE:
+            tracking->open(true);
+            expectKey = true;
+            break;
+        case CC_LEFT_BRACKET:
+            tracking->open(false);
+            break;
+        case CC_RIGHT_BRACE:
+        case CC_RIGHT_BRACKET:
+            tracking->close();
+            expectKey = false;
+            break;
+        case CC_COMMA:
+            expectKey = tracking->next();
+            break;
+        default:
+            expectKey = false;
+            break;
+    }
+}
 
-    for (char expected : falseStr) {
-        if (file.eof()) {
-            throwError("Unexpected EOF while parsing 'false'");
+std::string Lexer::lexeme(const TokenBuffer &tokens, size_t index) const {
+    const char *start = begin + tokens.offset(index);
+    switch (tokens.type(index)) {
+        case TokenType::STRING: {
+            std::string str;
+            StringRef value = string(tokens, index, str);
+            return tokens.hasEscapes(index) ? str : value.str();
         }
+        case TokenType::NUMBER: {
+            const char *stop = start;
+            matchNumber(stop, end);
+            return std::string(start, stop);
+        }
+        case TokenType::TRUE:
+            return "true";
+        case TokenType::FALSE:
+            return "false";
+        case TokenType::NULL_TOKEN:
+            return "null";
+        default:
+            return std::string(1, *start);
+    }
+}
 
-        file.get(c);
-        if (c != expected) {
-            throwError("Invalid literal: expected 'false'");
+StringRef Lexer::rawString(const TokenBuffer &tokens, size_t index) const {
+    const Kernels &scan = kernels();
+    const char *start = begin + tokens.offset(index) + 1;
+    const char *p = start + scan.scanString(start, end - start);
+    if (tokens.hasEscapes(index)) {
+        // Step over each escape until the closing quote
+        while (*p == '\\') {
+            p += 2;
+            p += scan.scanString(p, end - p);
         }
     }
+    return StringRef(start, p - start);
+}
 
-    // Peek next character to ensure it's a valid delimiter
-    c = file.peek();
-    if (!isspace(c) && c != ',' && c != '}' && c != ']' && c != EOF) {
-        throwError("Invalid character after 'false' literal");
+StringRef Lexer::string(const TokenBuffer &tokens, size_t index,
+                        std::string &scratch) const {
+    StringRef raw = rawString(tokens, index);
+    if (!tokens.hasEscapes(index)) {
+        return raw;
     }
+    scratch.clear();
+    unescapeString(raw, scratch);
+    return StringRef(scratch);
+}
 
-    return Token(TokenType::FALSE, "false");
+StringRef Lexer::string(const TokenBuffer &tokens, size_t index,
+                        std::pmr::string &scratch) const {
+    StringRef raw = rawString(tokens, index);
+    if (!tokens.hasEscapes(index)) {
+        return raw;
+    }
+    scratch.clear();
+    unescapeString(raw, scratch);
+    return StringRef(scratch);
 }
 
-Token Lexer::tokenizeNull() {
-    char c;
-    std::string nullStr = "ull";  // We already consumed 'n'
+// Validates the string body and records whether it contains escapes; the
+// escapes themselves are only decoded when the value is requested
+bool Lexer::tokenizeString(TokenBuffer &tokens) {
+    const Kernels &scan = kernels();
+    const char *start = current++;  // Skip the opening quote
+    bool hasEscapes = false;
+    while (true) {
+        // Jump to the next quote, backslash or control character
+        current += scan.scanString(current, end - current);
+        if (current == end) {
+            return fail(ErrorCode::UNTERMINATED_STRING, current);
+        }
 
-    for (char expected : nullStr) {
-        if (file.eof()) {
-            throwError("Unexpected EOF while parsing 'null'");
+        switch (stringCharClass(*current)) {
+            case SC_PLAIN:
+                break;  // scanString never stops here
+            case SC_QUOTE:
+                current++;
+                tokens.push(TokenType::STRING, offsetOf(start), hasEscapes);
+                return true;
+            case SC_BACKSLASH:
+                if (!handleEscape()) {
+                    return false;
+                }
+                hasEscapes = true;
+                break;
+            case SC_CONTROL:
+                return fail(ErrorCode::CONTROL_CHARACTER_IN_STRING, current);
         }
+    }
+}
 
-        file.get(c);
-        if (c != expected) {
-            throwError("Invalid literal: expected 'null'");
+// A string where an object key is expected. The predicted key's raw bytes
+// include both quotes, so input that matches them holds exactly that string.
+inline bool Lexer::tokenizeKey(TokenBuffer &tokens) {
+    expectKey = false;
+    bool hasEscapes = false;
+    StringRef key = tracking->expected(hasEscapes);
+    if (key.size != 0 && static_cast<size_t>(end - current) >= key.size &&
+        memcmp(current, key.data, key.size) == 0) {
+        tokens.push(TokenType::STRING, offsetOf(current), hasEscapes);
+        current += key.size;
+        tracking->hit();
+        // The colon nearly always follows at once
+        if (current < end && *current == ':') {
+            tokens.push(TokenType::COLON, offsetOf(current));
+            current++;
         }
+        return true;
+    }
+
+    const char *start = current;
+    if (!tokenizeString(tokens)) {
+        return false;
     }
+    tracking->learn(StringRef(start, current - start),
+                    tokens.hasEscapes(tokens.size() - 1));
+    return true;
+}
 
-    // Peek next character to ensure it's a valid delimiter
-    c = file.peek();
-    if (!isspace(c) && c != ',' && c != '}' && c != ']' && c != EOF) {
-        throwError("Invalid character after 'null' literal");
+// `current` points at the backslash; on success it is left past the escape
+bool Lexer::handleEscape() {
+    if (++current == end) {
+        return fail(ErrorCode::UNTERMINATED_STRING, current);
     }
 
-    return Token(TokenType::NULL_TOKEN, "null");
+    char c = *current++;
+    switch (c) {
+        case '\\':
+        case '\"':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            return true;
+        case 'u':
+            for (int i = 0; i < 4; i++) {
+                if (current + i == end || !isHexDigit(current[i])) {
+                    return fail(ErrorCode::INVALID_ESCAPE, current - 1, c);
+                }
+            }
+            current += 4;
+            return true;
+        default:
+            return fail(ErrorCode::INVALID_ESCAPE, current - 1, c);
+    }
 }
 
-char Lexer::advance() {
-    char c;
-    file.get(c);
+bool Lexer::tokenizeNumber(TokenBuffer &tokens) {
+    const char *start = current;
+    NumberState state = matchNumber(current, end);
+    if (state != NS_DONE) {
+        return fail(numberError(state), current);
+    }
 
-    if (c == '\n') {
-        line++;
-        column = 1;
-    } else {
-        column++;
+    tokens.push(TokenType::NUMBER, offsetOf(start));
+    return true;
+}
+
+bool Lexer::tokenizeLiteral(TokenType type, const char *literal,
+                            size_t length, TokenBuffer &tokens) {
+    ErrorCode code = matchLiteral(current, end, literal, length);
+    if (code != ErrorCode::NONE) {
+        // A bad delimiter is reported where it appears
+        const char *at = code == ErrorCode::INVALID_CHARACTER_AFTER_LITERAL
+                             ? current + length
+                             : current;
+        return fail(code, at, literal[0]);
     }
 
-    return c;
+    tokens.push(type, offsetOf(current));
+    current += length;
+    return true;
 }
 
-void Lexer::throwError(const std::string &message) {
-    throw std::runtime_error("Error at line " + std::to_string(line) +
-                             ", column " + std::to_string(column) + ": " +
-                             message);
-}
\ No newline at end of file
+bool Lexer::fail(ErrorCode code, const char *at, char detail) {
+    error = ParseResult(code, at - begin, detail);
+    return false;
+}
@@ -1,27 +1,96 @@
 #pragma once
-#include <fstream>
+#include <cstddef>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+#include "char_class.h"
+#include "error.h"
+#include "key_shapes.h"
+#include "string_ref.h"
 #include "token.h"
+#include "token_buffer.h"
 
 class Lexer {
    public:
     Lexer(const std::string& filePath);
+
+    // Tokenizes an in-memory buffer, which must outlive the Lexer.
+    Lexer(const char* data, size_t size);
+
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    // Throws std::runtime_error describing the first lexical error.
     std::vector<Token> tokenize();
 
+    // No-throw variant: appends to `tokens` and reports the first lexical
+    // error through the returned result instead of unwinding.
+    ParseResult tryTokenize(std::vector<Token>& tokens);
+
+    // Compact variant: records only token types and input offsets, without
+    // building any lexeme strings. Fails with MEMORY_LIMIT_EXCEEDED, and
+    // clears `tokens`, if they allocate from a MemoryAccount whose limit is
+    // reached.
+    ParseResult tryTokenize(TokenBuffer& tokens);
+
+    // Has tryTokenize() predict object keys from, and teach, `shapes`: a key
+    // matching the one at the same place in earlier input is taken with one
+    // compare instead of a scan. Meant for many inputs of the same shape,
+    // such as NDJSON records; the tokens are the same either way. Null, the
+    // default, turns prediction off.
+    void predictKeys(KeyShapes* shapes) { keyShapes = shapes; }
+
+    // Text of a token from a TokenBuffer this Lexer produced, with string
+    // escapes decoded.
+    std::string lexeme(const TokenBuffer& tokens, size_t index) const;
+
+    // Body of a string token exactly as it appears in the input, escapes
+    // included.
+    StringRef rawString(const TokenBuffer& tokens, size_t index) const;
+
+    // Decoded value of a string token. Strings without escapes are returned
+    // as a view into the input; the rest are unescaped into `scratch`, which
+    // the returned view then points into.
+    StringRef string(const TokenBuffer& tokens, size_t index,
+                     std::string& scratch) const;
+    StringRef string(const TokenBuffer& tokens, size_t index,
+                     std::pmr::string& scratch) const;
+
+    // Stepwise use, for re-lexing part of a buffer: seek() moves to a byte
+    // offset that starts a token or whitespace, and next() appends the next
+    // token. next() returns false at the end of the input or on an error,
+    // which lastError() then reports. Unlike tryTokenize(), nothing is
+    // checked up front, so the caller validates UTF-8 of what it re-lexes.
+    void seek(size_t offset);
+    bool next(TokenBuffer& tokens);
+    const ParseResult& lastError() const { return error; }
+    size_t position() const { return current - begin; }
+
+    const char* data() const { return begin; }
+    size_t size() const { return end - begin; }
+
    private:
-    std::ifstream file;
-    int line;
-    int column;
-    char advance();
-    void throwError(const std::string& message);
-
-    Token tokenizeString();
-    char handleEscape();
-
-    Token tokenizeDigit(char& c);
-    Token tokenizeTrue();
-    Token tokenizeFalse();
-    Token tokenizeNull();
+    std::string buffer;  // File contents, when constructed from a path
+    const char* begin;
+    const char* end;
+    const char* current;
+    bool opened;
+    ParseResult error;
+    KeyShapes* keyShapes;
+    KeyShapes* tracking;  // keyShapes while tryTokenize() runs
+    bool expectKey;
+
+    bool fail(ErrorCode code, const char* at, char detail = '\0');
+    bool step(TokenBuffer& tokens);
+    void trackShape(CharClass cls);
+    uint32_t offsetOf(const char* at) const { return at - begin; }
+
+    bool tokenizeString(TokenBuffer& tokens);
+    bool tokenizeKey(TokenBuffer& tokens);
+    bool handleEscape();
+
+    bool tokenizeNumber(TokenBuffer& tokens);
+    bool tokenizeLiteral(TokenType type, const char* literal, size_t length,
+                         TokenBuffer& tokens);
 };
@@ -1,63 +1,87 @@
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "dedup.h"
+#include "document.h"
+#include "kernels.h"
 #include "lexer.h"
 #include "parser.h"
+#include "projection.h"
+#include "schema.h"
+#include "shredder.h"
+#include "snapshot.h"
+#include "validator.h"
 
-// Helper function to test a valid JSON file
-bool testValidFile(const std::string& filepath) {
-    std::cout << "Testing valid file: " << filepath << std::endl;
-    try {
-        // Test lexing
-        Lexer lexer(filepath);
-        std::vector<Token> tokens = lexer.tokenize();
+// Checks a file with the fused single-pass Validator, or with the full
+// Lexer/Parser pipeline when `usePipeline` is set. `strictKeys` rejects
+// duplicate object keys, and `schema` documents that break it; both imply
+// the pipeline.
+ParseResult checkFile(const std::string& filepath, bool usePipeline,
+                      bool strictKeys = false,
+                      const Schema* schema = nullptr) {
+    if (!usePipeline && !strictKeys && schema == nullptr) {
+        return Validator::validateFile(filepath);
+    }
 
-        // Test parsing
-        Parser parser(tokens);
-        bool parseResult = parser.parse();
+    Lexer lexer(filepath);
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    if (!result.ok()) {
+        return result;
+    }
 
-        if (!parseResult) {
-            std::cerr << "Parse failed for valid file: " << filepath
-                      << std::endl;
-            return false;
-        }
+    Parser parser(std::move(tokens));
+    if (strictKeys) {
+        parser.checkDuplicateKeys(&lexer);
+    }
+    parser.checkSchema(schema, &lexer);
+    return parser.tryParse();
+}
+
+// Helper function to test a valid JSON file
+bool testValidFile(const std::string& filepath, bool usePipeline) {
+    std::cout << "Testing valid file: " << filepath << std::endl;
+    ParseResult result = checkFile(filepath, usePipeline);
 
-        std::cout << "✓ Successfully parsed: " << filepath << std::endl;
-        return true;
-    } catch (const std::exception& e) {
+    if (!result.ok()) {
         std::cerr << "✗ Error processing valid file " << filepath << ": "
-                  << e.what() << std::endl;
+                  << result.message() << std::endl;
         return false;
     }
+
+    std::cout << "✓ Successfully parsed: " << filepath << std::endl;
+    return true;
 }
 
 // Helper function to test an invalid JSON file
-bool testInvalidFile(const std::string& filepath) {
+bool testInvalidFile(const std::string& filepath, bool usePipeline) {
     std::cout << "Testing invalid file: " << filepath << std::endl;
-    try {
-        // Test lexing
-        Lexer lexer(filepath);
-        std::vector<Token> tokens = lexer.tokenize();
-
-        // Test parsing
-        Parser parser(tokens);
-        bool parseResult = parser.parse();
+    ParseResult result = checkFile(filepath, usePipeline);
 
-        // If we get here without an exception, that's a problem
+    if (result.ok()) {
         std::cerr << "✗ Failed: Expected error for invalid file: " << filepath
                   << std::endl;
         return false;
-    } catch (const std::exception& e) {
-        std::cout << "✓ Expected error caught for " << filepath << ": "
-                  << e.what() << std::endl;
-        return true;
     }
+
+    std::cout << "✓ Expected error caught for " << filepath << ": "
+              << result.message() << std::endl;
+    return true;
 }
 
 // Helper function to run tests for a specific step
-bool runStepTests(int step) {
+bool runStepTests(int step, bool usePipeline) {
     bool allPassed = true;
     std::string baseDir = "./tests/step" + std::to_string(step) + "/";
 
@@ -71,19 +95,19 @@ bool runStepTests(int step) {
 
     // Test all valid files
     for (const auto& file : validFiles) {
-        if (!testValidFile(file)) {
+        if (!testValidFile(file, usePipeline)) {
             allPassed = false;
         }
     }
 
     // Test invalid file
-    if (!testInvalidFile(baseDir + "invalid.json")) {
+    if (!testInvalidFile(baseDir + "invalid.json", usePipeline)) {
         allPassed = false;
     }
 
     // Add invalid2.json for step 2
     if (step == 2) {
-        if (!testInvalidFile(baseDir + "invalid2.json")) {
+        if (!testInvalidFile(baseDir + "invalid2.json", usePipeline)) {
             allPassed = false;
         }
     }
@@ -91,14 +115,438 @@ bool runStepTests(int step) {
     return allPassed;
 }
 
-int main() {
+// Validates each file given on the command line, printing one line per file
+int checkFiles(const std::vector<std::string>& files, bool usePipeline,
+               bool strictKeys, const Schema* schema) {
+    bool allValid = true;
+    for (const auto& file : files) {
+        ParseResult result = checkFile(file, usePipeline, strictKeys, schema);
+        if (result.ok()) {
+            std::cout << "✓ Valid JSON: " << file << std::endl;
+        } else {
+            std::cerr << "✗ Invalid JSON: " << file << ": "
+                      << result.message() << std::endl;
+            allValid = false;
+        }
+    }
+    return allValid ? 0 : 1;
+}
+
+// Share of object keys that KeyShapes predicted, as "97.5% (39 of 40)"
+std::string keyHitRate(const KeyShapes& shapes) {
+    char rate[64];
+    std::snprintf(rate, sizeof(rate), "%.1f%% (%zu of %zu)",
+                  shapes.hitRate() * 100, shapes.hits(), shapes.lookups());
+    return rate;
+}
+
+// Parses each file into a Document and prints what the parse allocated.
+// Documents that would hold more than `memoryLimit` bytes at once (0 for no
+// limit), or that break `schema` when one is given, fail.
+int statFiles(const std::vector<std::string>& files, bool strictKeys,
+              const Schema* schema, size_t memoryLimit) {
+    int status = 0;
+    for (const auto& file : files) {
+        Document document;
+        document.checkDuplicateKeys(strictKeys);
+        document.checkSchema(schema);
+        document.setMemoryLimit(memoryLimit);
+        document.predictKeys(true);
+        ParseResult result = document.parseFile(file);
+        if (result.ok()) {
+            std::cout << "✓ Valid JSON: " << file << std::endl;
+        } else {
+            std::cerr << "✗ Invalid JSON: " << file << ": "
+                      << result.message() << std::endl;
+            status = 1;
+        }
+
+        const MemoryStats& stats = document.memoryStats();
+        std::cout << "  tape words:      " << document.view().tapeSize
+                  << "\n  string bytes:    " << document.view().stringsSize
+                  << "\n  allocations:     " << stats.allocations
+                  << "\n  bytes allocated: " << stats.bytesAllocated
+                  << "\n  peak bytes:      " << stats.peakBytes
+                  << "\n  bytes in use:    " << stats.bytesInUse
+                  << "\n  key hit rate:    "
+                  << keyHitRate(document.keyShapes()) << std::endl;
+    }
+    return status;
+}
+
+// Parses `input` and writes its binary snapshot to `output`
+int writeSnapshot(const std::string& input, const std::string& output) {
+    Document document;
+    ParseResult result = document.parseFile(input);
+    if (!result.ok()) {
+        std::cerr << "✗ Invalid JSON: " << input << ": " << result.message()
+                  << std::endl;
+        return 1;
+    }
+
+    result = Snapshot::write(document.view(), output);
+    if (!result.ok()) {
+        std::cerr << "✗ " << output << ": " << result.message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "✓ Wrote snapshot: " << output << " ("
+              << document.view().tapeSize << " tape words, "
+              << document.view().stringsSize << " string bytes)" << std::endl;
+    return 0;
+}
+
+// Extracts the comma-separated JSON Pointers in `paths` from each NDJSON
+// record of `file` ("-" for stdin) and writes them to stdout
+int projectFile(const std::string& paths, const std::string& file,
+                const ProjectionOptions& options) {
+    Projection projection;
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t comma = paths.find(',', start);
+        if (comma == std::string::npos) {
+            comma = paths.size();
+        }
+        std::string path = paths.substr(start, comma - start);
+        ParseResult result = projection.addPath(path);
+        if (!result.ok()) {
+            std::cerr << "✗ Bad path '" << path << "': " << result.message()
+                      << std::endl;
+            return 2;
+        }
+        start = comma + 1;
+    }
+
+    std::ifstream input;
+    if (file != "-") {
+        input.open(file, std::ios::binary);
+        if (!input) {
+            std::cerr << "✗ Cannot open file: " << file << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = file == "-" ? std::cin : input;
+
+    ParseResult result = projection.projectStream(in, std::cout, options);
+    std::cout.flush();
+    if (!result.ok()) {
+        std::cerr << "✗ Invalid record in " << file << ": "
+                  << result.message() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static const char* columnTypeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::BOOL:
+            return "bool";
+        case ColumnType::INT64:
+            return "int64";
+        case ColumnType::DOUBLE:
+            return "double";
+        case ColumnType::STRING:
+            return "string";
+        case ColumnType::JSON:
+            return "json";
+        default:
+            return "null";
+    }
+}
+
+// Shreds the NDJSON records of `input` into columns written to `output`
+int shredFile(const std::string& input, const std::string& output) {
+    Shredder shredder;
+    ParseResult result = shredder.addFile(input);
+    if (!result.ok()) {
+        std::cerr << "✗ Invalid record in " << input << ": "
+                  << result.message() << std::endl;
+        return 1;
+    }
+
+    result = shredder.write(output);
+    if (!result.ok()) {
+        std::cerr << "✗ " << output << ": " << result.message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "✓ Wrote " << shredder.rowCount() << " rows to " << output
+              << std::endl;
+    for (size_t i = 0; i < shredder.columnCount(); i++) {
+        const Column& column = shredder.column(i);
+        std::cout << "  " << column.name() << " "
+                  << columnTypeName(column.type()) << " ("
+                  << column.nullCount() << " nulls)" << std::endl;
+    }
+    std::cout << "  key hit rate: " << keyHitRate(shredder.keyShapes())
+              << std::endl;
+    return 0;
+}
+
+// Prints the structural hash of each file; files that print the same hash
+// hold the same JSON value
+int hashFiles(const std::vector<std::string>& files) {
+    int status = 0;
+    std::vector<uint64_t> hashes;
+    for (const auto& file : files) {
+        Lexer lexer(file);
+        TokenBuffer tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+        if (result.ok()) {
+            Parser parser(std::move(tokens));
+            result = parser.tryParseHashed(lexer, hashes);
+        }
+        if (!result.ok()) {
+            std::cerr << "✗ " << file << ": " << result.message()
+                      << std::endl;
+            status = 1;
+            continue;
+        }
+        std::printf("%016" PRIx64 "  %s\n", hashes[0], file.c_str());
+    }
+    return status;
+}
+
+// Copies the NDJSON records of `file` (or stdin) to stdout, dropping those
+// equal to an earlier record
+int dedupFile(const std::string& file) {
+    std::ifstream input;
+    if (file != "-") {
+        input.open(file, std::ios::binary);
+        if (!input) {
+            std::cerr << "✗ Cannot open file: " << file << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = file == "-" ? std::cin : input;
+
+    Deduplicator dedup;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        bool duplicate;
+        ParseResult result = dedup.addRecord(line.data(), line.size(),
+                                             duplicate);
+        if (!result.ok()) {
+            std::cerr << "✗ Invalid record on line " << lineNumber << " of "
+                      << file << ": " << result.message() << std::endl;
+            return 1;
+        }
+        if (!duplicate) {
+            std::cout << line << '\n';
+        }
+    }
+    std::cout.flush();
+    std::cerr << "✓ Kept " << dedup.uniqueCount() << " of "
+              << dedup.recordCount() << " records\n  key hit rate: "
+              << keyHitRate(dedup.keyShapes()) << std::endl;
+    return 0;
+}
+
+// Lists the scanning kernels this CPU supports and the one in use
+void printKernels() {
+    const char* selected = kernels().name;
+    std::cout << "Available kernels:";
+    for (const auto& name : availableKernels()) {
+        std::cout << " " << name;
+    }
+    std::cout << "\nSelected kernel: " << selected << std::endl;
+}
+
+// Reads a count given on the command line. Digits only: strtoull would read
+// "abc" as 0, which the options take as "no limit" or "automatic".
+bool parseCount(const char* text, size_t max, size_t& count) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (!isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' ||
+        errno == ERANGE || value > max) {
+        return false;
+    }
+    count = static_cast<size_t>(value);
+    return true;
+}
+
+void printUsage() {
+    std::cerr << "Usage: json_parser [--pipeline] [--strict] "
+                 "[--schema <schema.json>] [file...]\n"
+              << "       json_parser --stats [--memory-limit <bytes>] "
+                 "[--strict]\n"
+                 "                   [--schema <schema.json>] <file...>\n"
+              << "       json_parser --snapshot <file.json> <out>\n"
+              << "       json_parser --project <pointer,...> [file]\n"
+              << "       json_parser --shred <file.ndjson> <out>\n"
+              << "       json_parser --hash <file...>\n"
+              << "       json_parser --dedup [file]\n"
+              << "  Validates each file. With no files, runs the step tests.\n"
+              << "  --pipeline  Use the Lexer/Parser instead of the Validator\n"
+              << "  --strict    Reject objects with duplicate keys (implies\n"
+              << "              --pipeline)\n"
+              << "  --schema <schema.json>\n"
+              << "              Also check each file against a JSON Schema\n"
+              << "              (implies --pipeline)\n"
+              << "  --stats     Parse each file into a document and print its\n"
+              << "              size, the memory the parse allocated and the\n"
+              << "              share of object keys predicted\n"
+              << "  --memory-limit <bytes>\n"
+              << "              Fail documents that need more memory at once\n"
+              << "              (implies --stats)\n"
+              << "  --kernels   List the SIMD kernels and the one selected\n"
+              << "              (override with JSON_PARSER_KERNEL=<name>)\n"
+              << "  --snapshot <file.json> <out>\n"
+              << "              Write a binary snapshot of the parsed file\n"
+              << "  --project <pointer,...> [--tsv] [--threads N] [file]\n"
+              << "              Extract fields from each NDJSON record of the\n"
+              << "              file (or stdin) as NDJSON or TSV\n"
+              << "  --shred <file.ndjson> <out>\n"
+              << "              Write the records as typed columns\n"
+              << "  --hash <file...>\n"
+              << "              Print the structural hash of each file\n"
+              << "  --dedup [file]\n"
+              << "              Copy NDJSON records from the file (or stdin),\n"
+              << "              dropping structurally equal repeats"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool usePipeline = false;
+    bool strictKeys = false;
+    std::string schemaFile;
+    bool project = false;
+    bool hash = false;
+    bool dedup = false;
+    bool stats = false;
+    size_t memoryLimit = 0;
+    std::string projectPaths;
+    ProjectionOptions projectOptions;
+    bool projectionFlags = false;  // --tsv or --threads, which need --project
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pipeline") {
+            usePipeline = true;
+        } else if (arg == "--strict") {
+            strictKeys = true;
+        } else if (arg == "--schema" && i + 1 < argc) {
+            schemaFile = argv[++i];
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--memory-limit" && i + 1 < argc) {
+            stats = true;
+            if (!parseCount(argv[++i], SIZE_MAX, memoryLimit)) {
+                printUsage();
+                return 2;
+            }
+        } else if (arg == "--kernels") {
+            printKernels();
+            return 0;
+        } else if (arg == "--snapshot") {
+            if (i + 2 >= argc) {
+                printUsage();
+                return 2;
+            }
+            return writeSnapshot(argv[i + 1], argv[i + 2]);
+        } else if (arg == "--shred") {
+            if (i + 2 >= argc) {
+                printUsage();
+                return 2;
+            }
+            return shredFile(argv[i + 1], argv[i + 2]);
+        } else if (arg == "--project" && i + 1 < argc) {
+            project = true;
+            projectPaths = argv[++i];
+        } else if (arg == "--hash") {
+            hash = true;
+        } else if (arg == "--dedup") {
+            dedup = true;
+        } else if (arg == "--tsv") {
+            projectionFlags = true;
+            projectOptions.format = ProjectionFormat::TSV;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            projectionFlags = true;
+            size_t threads;
+            if (!parseCount(argv[++i], UINT_MAX, threads)) {
+                printUsage();
+                return 2;
+            }
+            projectOptions.threads = static_cast<unsigned>(threads);
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (projectionFlags && !project) {
+        printUsage();
+        return 2;
+    }
+
+    if (project) {
+        if (files.size() > 1) {
+            printUsage();
+            return 2;
+        }
+        return projectFile(projectPaths, files.empty() ? "-" : files[0],
+                           projectOptions);
+    }
+
+    if (hash) {
+        if (files.empty()) {
+            printUsage();
+            return 2;
+        }
+        return hashFiles(files);
+    }
+
+    if (dedup) {
+        if (files.size() > 1) {
+            printUsage();
+            return 2;
+        }
+        return dedupFile(files.empty() ? "-" : files[0]);
+    }
+
+    // The step tests below take no schema
+    if ((stats || !schemaFile.empty()) && files.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    Schema schema;
+    if (!schemaFile.empty()) {
+        ParseResult result = schema.compileFile(schemaFile);
+        if (!result.ok()) {
+            std::cerr << "✗ Invalid schema: " << schemaFile << ": "
+                      << result.message() << std::endl;
+            return 2;
+        }
+    }
+    const Schema* checked = schemaFile.empty() ? nullptr : &schema;
+
+    if (stats) {
+        return statFiles(files, strictKeys, checked, memoryLimit);
+    }
+
+    if (!files.empty()) {
+        return checkFiles(files, usePipeline, strictKeys, checked);
+    }
+
     bool allTestsPassed = true;
 
     // Run tests for each step
     for (int step = 1; step <= 4; step++) {
         std::cout << "\n=== Running Step " << step << " Tests ===\n"
                   << std::endl;
-        if (!runStepTests(step)) {
+        if (!runStepTests(step, usePipeline)) {
             allTestsPassed = false;
         }
     }
@@ -0,0 +1,39 @@
+#include "memory.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+const char* MemoryLimitExceeded::what() const noexcept {
+    return "Memory limit exceeded";
+}
+
+void MemoryAccount::resetStats() {
+    totals.allocations = 0;
+    totals.bytesAllocated = 0;
+    totals.peakBytes = totals.bytesInUse;
+}
+
+void* MemoryAccount::do_allocate(size_t bytes, size_t alignment) {
+    if (budget != 0 &&
+        (bytes > budget || totals.bytesInUse > budget - bytes)) {
+        throw MemoryLimitExceeded();
+    }
+    void* p = source->allocate(bytes, alignment);
+    totals.allocations++;
+    totals.bytesAllocated += bytes;
+    totals.bytesInUse += bytes;
+    if (totals.bytesInUse > totals.peakBytes) {
+        totals.peakBytes = totals.bytesInUse;
+    }
+    return p;
+}
+
+void MemoryAccount::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    source->deallocate(p, bytes, alignment);
+    totals.bytesInUse -= bytes;
+}
+
+bool MemoryAccount::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
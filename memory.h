@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+// Totals for the allocations made through a MemoryAccount
+struct MemoryStats {
+    size_t allocations;     // Calls to allocate
+    size_t bytesAllocated;  // Sum of their sizes
+    size_t bytesInUse;      // Allocated and not yet freed
+    size_t peakBytes;       // Highest bytesInUse
+
+    MemoryStats()
+        : allocations(0), bytesAllocated(0), bytesInUse(0), peakBytes(0) {}
+};
+
+// Thrown by MemoryAccount when an allocation would exceed its limit
+class MemoryLimitExceeded : public std::bad_alloc {
+   public:
+    const char* what() const noexcept override;
+};
+
+// Memory resource that passes each allocation on to an upstream resource
+// (the heap by default, or an arena, a pool, huge pages, NUMA-local memory:
+// any std::pmr::memory_resource) and keeps MemoryStats for it. TokenBuffer,
+// Parser, Document and ObjectIndex allocate through one given to them,
+// including the scratch strings that escaped strings are decoded into. The
+// one exception is the `hashes` vector of Parser::tryParseHashed(), which
+// belongs to the caller and grows with the caller's allocator.
+//
+// With a limit set, an allocation that would take bytesInUse over it throws
+// MemoryLimitExceeded before anything is taken from upstream. The no-throw
+// entry points (Lexer::tryTokenize(), Parser::tryParse(), Document::parse())
+// report it as MEMORY_LIMIT_EXCEEDED at the offset where the input needed
+// more memory.
+//
+// An account is not synchronised; give each thread its own, as Document
+// does. Counts are kept in plain fields so accounting costs a few adds per
+// allocation.
+class MemoryAccount : public std::pmr::memory_resource {
+   public:
+    explicit MemoryAccount(std::pmr::memory_resource* upstream =
+                               std::pmr::get_default_resource())
+        : source(upstream), budget(0) {}
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    std::pmr::memory_resource* upstream() const { return source; }
+
+    // Most bytes in use at once; 0 for no limit
+    void setLimit(size_t bytes) { budget = bytes; }
+    size_t limit() const { return budget; }
+
+    const MemoryStats& stats() const { return totals; }
+
+    // Starts new counts. Bytes still in use carry over as the new peak.
+    void resetStats();
+
+   private:
+    std::pmr::memory_resource* source;
+    size_t budget;
+    MemoryStats totals;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+};
@@ -0,0 +1,316 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+// Conversions for number text already accepted by the number DFA
+// (matchNumber in char_class.h).
+
+// Parses an integer without fraction or exponent that fits in int64_t.
+// Returns false for anything else.
+constexpr bool parseInteger(const char* start, const char* end,
+                            int64_t& value) {
+    bool negative = *start == '-';
+    uint64_t magnitude = 0;
+    for (const char* p = start + negative; p < end; p++) {
+        unsigned digit = static_cast<unsigned char>(*p) - '0';
+        if (digit > 9 || magnitude > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+
+    uint64_t limit = uint64_t(INT64_MAX) + (negative ? 1 : 0);
+    if (magnitude > limit) {
+        return false;
+    }
+    value = static_cast<int64_t>(negative ? ~magnitude + 1 : magnitude);
+    return true;
+}
+
+inline double parseDouble(const char* start, const char* end) {
+    // strtod needs a terminated copy
+    std::string text(start, end);
+    return strtod(text.c_str(), nullptr);
+}
+
+// Unsigned integer of up to kLimbs 32-bit limbs, for exact decimal to binary
+// conversion in constant expressions
+struct BigUnsigned {
+    static constexpr size_t kLimbs = 128;
+
+    uint32_t limbs[kLimbs];
+    size_t used;  // The top limb in use is non-zero
+
+    constexpr BigUnsigned() : limbs(), used(0) {}
+
+    // this = this * factor + addend. Returns false on overflow.
+    constexpr bool multiplyAdd(uint32_t factor, uint32_t addend) {
+        uint64_t carry = addend;
+        for (size_t i = 0; i < used; i++) {
+            uint64_t product = uint64_t(limbs[i]) * factor + carry;
+            limbs[i] = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        if (carry != 0) {
+            if (used == kLimbs) {
+                return false;
+            }
+            limbs[used++] = static_cast<uint32_t>(carry);
+        }
+        return true;
+    }
+
+    constexpr bool multiplyPow10(size_t exponent) {
+        for (; exponent >= 9; exponent -= 9) {
+            if (!multiplyAdd(1000000000, 0)) {
+                return false;
+            }
+        }
+        uint32_t factor = 1;
+        for (; exponent > 0; exponent--) {
+            factor *= 10;
+        }
+        return multiplyAdd(factor, 0);
+    }
+
+    constexpr size_t bitLength() const {
+        if (used == 0) {
+            return 0;
+        }
+        size_t bits = 32 * (used - 1);
+        for (uint32_t top = limbs[used - 1]; top != 0; top >>= 1) {
+            bits++;
+        }
+        return bits;
+    }
+
+    constexpr bool shiftLeft(size_t bits) {
+        if (used == 0) {
+            return true;
+        }
+        size_t whole = bits / 32;
+        size_t part = bits % 32;
+        if (used + whole + 1 > kLimbs) {
+            return false;
+        }
+        limbs[used + whole] = 0;
+        for (size_t i = used; i-- > 0;) {
+            uint64_t moved = uint64_t(limbs[i]) << part;
+            limbs[i + whole + 1] |= static_cast<uint32_t>(moved >> 32);
+            limbs[i + whole] = static_cast<uint32_t>(moved);
+        }
+        for (size_t i = 0; i < whole; i++) {
+            limbs[i] = 0;
+        }
+        used += whole + 1;
+        trim();
+        return true;
+    }
+
+    constexpr void shiftRightOne() {
+        for (size_t i = 0; i < used; i++) {
+            uint32_t next = i + 1 < used ? limbs[i + 1] : 0;
+            limbs[i] = (limbs[i] >> 1) | (next << 31);
+        }
+        trim();
+    }
+
+    constexpr int compare(const BigUnsigned& other) const {
+        if (used != other.used) {
+            return used < other.used ? -1 : 1;
+        }
+        for (size_t i = used; i-- > 0;) {
+            if (limbs[i] != other.limbs[i]) {
+                return limbs[i] < other.limbs[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // this -= other, where other <= this
+    constexpr void subtract(const BigUnsigned& other) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < used; i++) {
+            uint64_t take = (i < other.used ? other.limbs[i] : 0) + borrow;
+            borrow = limbs[i] < take ? 1 : 0;
+            limbs[i] = static_cast<uint32_t>(limbs[i] - take);
+        }
+        trim();
+    }
+
+    constexpr void trim() {
+        while (used > 0 && limbs[used - 1] == 0) {
+            used--;
+        }
+    }
+};
+
+// Bits of the double nearest to mantissa * 2^(exponent - 63), rounding half
+// to even. `mantissa` has its top bit set; `sticky` says whether non-zero
+// bits below it were cut off.
+constexpr uint64_t roundToDoubleBits(uint64_t mantissa, int64_t exponent,
+                                     bool sticky) {
+    if (exponent > 1023) {
+        return 0x7FF0000000000000ULL;  // Infinity, as strtod gives
+    }
+    // Normal doubles keep 53 bits; subnormals fewer
+    int64_t drop = 11 + (exponent < -1022 ? -1022 - exponent : 0);
+    if (drop > 64) {
+        return 0;
+    }
+    uint64_t kept = drop == 64 ? 0 : mantissa >> drop;
+    uint64_t rest =
+        drop == 64 ? mantissa : mantissa & ((uint64_t(1) << drop) - 1);
+    uint64_t half = uint64_t(1) << (drop - 1);
+    if (rest > half || (rest == half && (sticky || (kept & 1) != 0))) {
+        kept++;
+    }
+    if (exponent < -1022) {
+        return kept;  // Rounding up to 2^52 gives the smallest normal
+    }
+    // A carry out of the mantissa moves into the exponent field
+    return (uint64_t(exponent + 1023) << 52) + (kept - (uint64_t(1) << 52));
+}
+
+// Bits of the double nearest to numerator / denominator, for the common
+// numbers whose digits and power of ten both fit in 64 bits. Quotient bits
+// are produced one at a time until there are 64 of them.
+constexpr uint64_t smallQuotientBits(uint64_t numerator,
+                                     uint64_t denominator) {
+    uint64_t quotient = numerator / denominator;
+    uint64_t remainder = numerator % denominator;
+    int64_t exponent = 63;
+    while ((quotient >> 63) == 0) {
+        // Twice the remainder may not fit, but is then above denominator
+        bool carry = (remainder >> 63) != 0;
+        remainder <<= 1;
+        quotient <<= 1;
+        if (carry || remainder >= denominator) {
+            remainder -= denominator;
+            quotient |= 1;
+        }
+        exponent--;
+    }
+    return roundToDoubleBits(quotient, exponent, remainder != 0);
+}
+
+// Correctly rounded conversion of number text accepted by matchNumber to the
+// bits of a double, the same value strtod gives, in a constant expression.
+// Numbers of up to 19 significant digits with small exponents are divided
+// in 64 bits; the rest on exact big integers, which is slow next to strtod
+// but needs no floating-point arithmetic. Fails when the number has more
+// than 700 significant digits.
+constexpr bool parseDoubleBits(const char* start, const char* end,
+                               uint64_t& bits) {
+    const char* p = start;
+    uint64_t sign = 0;
+    if (*p == '-') {
+        sign = uint64_t(1) << 63;
+        p++;
+    }
+
+    // value = digits * 10^exponent; `small` holds the first 19 digits
+    const char* first = p;
+    uint64_t small = 0;
+    size_t digits = 0;
+    int64_t exponent = 0;
+    bool fraction = false;
+    for (; p < end && *p != 'e' && *p != 'E'; p++) {
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        exponent -= fraction ? 1 : 0;
+        if (digits == 0 && *p == '0') {
+            continue;  // Leading zeros
+        }
+        if (++digits > 700) {
+            return false;
+        }
+        small = digits <= 19 ? small * 10 + (*p - '0') : small;
+    }
+    const char* digitsEnd = p;
+    if (p < end) {
+        p++;
+        bool negative = *p == '-';
+        p += *p == '-' || *p == '+';
+        int64_t written = 0;
+        for (; p < end; p++) {
+            if (written < 100000) {
+                written = written * 10 + (*p - '0');
+            }
+        }
+        exponent += negative ? -written : written;
+    }
+
+    if (digits > 0 && digits <= 19 && exponent >= -19 && exponent <= 19) {
+        uint64_t power = 1;
+        for (int64_t i = 0; i < (exponent < 0 ? -exponent : exponent); i++) {
+            power *= 10;
+        }
+        if (exponent < 0) {
+            bits = sign | smallQuotientBits(small, power);
+            return true;
+        }
+        if (small <= UINT64_MAX / power) {
+            bits = sign | smallQuotientBits(small * power, 1);
+            return true;
+        }
+    }
+
+    // The value lies in [10^(magnitude - 1), 10^magnitude)
+    int64_t magnitude = exponent + static_cast<int64_t>(digits);
+    if (digits == 0 || magnitude < -323) {
+        bits = sign;
+        return true;
+    }
+    if (magnitude > 309) {
+        bits = sign | 0x7FF0000000000000ULL;
+        return true;
+    }
+
+    BigUnsigned value;
+    bool significant = false;
+    for (p = first; p < digitsEnd; p++) {
+        significant = significant || (*p != '0' && *p != '.');
+        if (significant && *p != '.') {
+            value.multiplyAdd(10, *p - '0');
+        }
+    }
+
+    // Scale numerator or denominator so that the quotient has 63 or 64 bits
+    BigUnsigned denominator;
+    denominator.multiplyAdd(1, 1);
+    if (exponent >= 0) {
+        value.multiplyPow10(static_cast<size_t>(exponent));
+    } else {
+        denominator.multiplyPow10(static_cast<size_t>(-exponent));
+    }
+    int64_t shift = 63 - (static_cast<int64_t>(value.bitLength()) -
+                          static_cast<int64_t>(denominator.bitLength()));
+    if (shift > 0) {
+        value.shiftLeft(static_cast<size_t>(shift));
+    } else {
+        denominator.shiftLeft(static_cast<size_t>(-shift));
+    }
+
+    // Long division, one quotient bit at a time
+    denominator.shiftLeft(63);
+    uint64_t quotient = 0;
+    for (int bit = 63; bit >= 0; bit--) {
+        if (value.compare(denominator) >= 0) {
+            value.subtract(denominator);
+            quotient |= uint64_t(1) << bit;
+        }
+        denominator.shiftRightOne();
+    }
+
+    int64_t binaryExponent = 63 - shift;
+    if ((quotient >> 63) == 0) {
+        quotient <<= 1;
+        binaryExponent--;
+    }
+    bits = sign | roundToDoubleBits(quotient, binaryExponent, value.used != 0);
+    return true;
+}
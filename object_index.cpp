@@ -0,0 +1,208 @@
+#include "object_index.h"
+
+#include <algorithm>
+#include <new>
+
+#include "document.h"
+#include "memory.h"
+#include "structural_hash.h"
+#include "tape.h"
+
+namespace {
+
+uint64_t slotFor(uint64_t hash, size_t keyIndex) {
+    return (hash & 0xffffffff00000000ULL) | keyIndex;
+}
+
+// Spreads tape indexes, which are often close together, over a directory
+size_t directorySlot(size_t object, size_t mask) {
+    return (object * 0x9E3779B97F4A7C15ULL >> 32) & mask;
+}
+
+}  // namespace
+
+size_t ObjectIndex::find(const DocumentView& doc, size_t object,
+                         StringRef key) {
+    const uint64_t* table = lookup(object);
+    if (table == nullptr) {
+        std::lock_guard<std::mutex> guard(lock);
+        table = lookup(object);  // Another thread may have built it
+        if (table == nullptr) {
+            try {
+                table = build(doc, object);
+            } catch (const MemoryLimitExceeded&) {
+                return kNotIndexed;
+            }
+        }
+    }
+
+    uint64_t hash = hashString(key);
+    size_t mask = table[1];
+    const uint64_t* slots = table + 2;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint64_t slot = slots[i];
+        if (slot == 0) {
+            return 0;
+        }
+        size_t keyIndex = slot & 0xffffffff;
+        if ((slot ^ hash) >> 32 == 0 &&
+            Value(&doc, keyIndex).asString() == key) {
+            return keyIndex + 1;
+        }
+    }
+}
+
+// The table of `object`, or nullptr. Takes no lock: the acquire loads pair
+// with the release stores in publish(), so a table that is found is
+// complete.
+const uint64_t* ObjectIndex::lookup(size_t object) const {
+    const Directory* current = directory.load(std::memory_order_acquire);
+    if (current == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = directorySlot(object, current->mask);;
+         i = (i + 1) & current->mask) {
+        const uint64_t* table =
+            current->entries[i].load(std::memory_order_acquire);
+        if (table == nullptr || table[0] == object) {
+            return table;
+        }
+    }
+}
+
+const uint64_t* ObjectIndex::build(const DocumentView& doc, size_t object) {
+    uint64_t start = doc.tape[object];
+    size_t end = tapeContainerEnd(start);
+
+    // At most half full. The saturated count of a huge object is only a
+    // lower bound, so count members when it might be.
+    size_t members = tapeContainerCount(start);
+    if (members >= kTapeCountSaturated) {
+        members = 0;
+        for (size_t i = object + 1; i < end; i = tapeNext(doc.tape, i + 1)) {
+            members++;
+        }
+    }
+    size_t capacity = 1;
+    while (capacity < members * 2) {
+        capacity *= 2;
+    }
+
+    uint64_t* table =
+        static_cast<uint64_t*>(allocate((capacity + 2) * sizeof(uint64_t)));
+    table[0] = object;
+    table[1] = capacity - 1;
+    uint64_t* slots = table + 2;
+    std::fill(slots, slots + capacity, 0);
+
+    // Slot 0 is never a key (the tape starts with the root), so 0 marks an
+    // empty slot
+    for (size_t i = object + 1; i < end; i = tapeNext(doc.tape, i + 1)) {
+        StringRef key = Value(&doc, i).asString();
+        uint64_t hash = hashString(key);
+        uint64_t slot = slotFor(hash, i);
+        for (size_t j = hash & table[1];; j = (j + 1) & table[1]) {
+            if (slots[j] == 0) {
+                slots[j] = slot;
+                break;
+            }
+            // Keep the first of duplicate keys
+            if ((slots[j] ^ slot) >> 32 == 0 &&
+                Value(&doc, slots[j] & 0xffffffff).asString() == key) {
+                break;
+            }
+        }
+    }
+
+    try {
+        publish(table);
+    } catch (const MemoryLimitExceeded&) {
+        releaseLast();
+        throw;
+    }
+    return table;
+}
+
+// Adds `table` to the directory, first moving to a directory twice the size
+// if this one would be more than half full
+void ObjectIndex::publish(const uint64_t* table) {
+    const Directory* current = directory.load(std::memory_order_relaxed);
+    if (current == nullptr || (tables + 1) * 2 > current->mask + 1) {
+        size_t capacity = current == nullptr ? 16 : (current->mask + 1) * 2;
+        void* data =
+            allocate(sizeof(Directory) +
+                     capacity * sizeof(std::atomic<const uint64_t*>));
+        Directory* grown = new (data) Directory();
+        grown->mask = capacity - 1;
+        grown->entries =
+            reinterpret_cast<std::atomic<const uint64_t*>*>(grown + 1);
+        for (size_t i = 0; i < capacity; i++) {
+            new (&grown->entries[i]) std::atomic<const uint64_t*>(nullptr);
+        }
+        if (current != nullptr) {
+            for (size_t i = 0; i <= current->mask; i++) {
+                const uint64_t* moved =
+                    current->entries[i].load(std::memory_order_relaxed);
+                if (moved == nullptr) {
+                    continue;
+                }
+                size_t j = directorySlot(moved[0], grown->mask);
+                while (grown->entries[j].load(std::memory_order_relaxed)) {
+                    j = (j + 1) & grown->mask;
+                }
+                grown->entries[j].store(moved, std::memory_order_relaxed);
+            }
+        }
+        directory.store(grown, std::memory_order_release);
+        current = grown;
+    }
+
+    size_t i = directorySlot(table[0], current->mask);
+    while (current->entries[i].load(std::memory_order_relaxed) != nullptr) {
+        i = (i + 1) & current->mask;
+    }
+    current->entries[i].store(table, std::memory_order_release);
+    tables++;
+}
+
+void* ObjectIndex::allocate(size_t bytes) {
+    void* data = memory->allocate(bytes, alignof(uint64_t));
+    try {
+        blocks.push_back(Block{data, bytes});
+    } catch (...) {
+        memory->deallocate(data, bytes, alignof(uint64_t));
+        throw;
+    }
+    return data;
+}
+
+void ObjectIndex::releaseLast() {
+    Block block = blocks.back();
+    blocks.pop_back();
+    memory->deallocate(block.data, block.bytes, alignof(uint64_t));
+}
+
+void ObjectIndex::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    directory.store(nullptr, std::memory_order_relaxed);
+    tables = 0;
+    for (const Block& block : blocks) {
+        memory->deallocate(block.data, block.bytes, alignof(uint64_t));
+    }
+    blocks.clear();
+    blocks.shrink_to_fit();
+}
+
+size_t ObjectIndex::tableCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return tables;
+}
+
+size_t ObjectIndex::memoryUsage() const {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t bytes = blocks.capacity() * sizeof(Block);
+    for (const Block& block : blocks) {
+        bytes += block.bytes;
+    }
+    return bytes;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "string_ref.h"
+
+struct DocumentView;
+
+// Hash indexes for the large objects of one document. Value::operator[]
+// scans small objects linearly; an object with at least kMinMembers members
+// gets an open-addressing table the first time a key is looked up in it, so
+// objects that are never queried cost nothing. The index belongs to the
+// Document or Snapshot.
+//
+// Each slot packs the upper half of the key's hash with the tape index of the
+// key, so most probes that miss never touch the string area. With duplicate
+// keys the first one wins, as with the linear scan.
+//
+// Tables are allocated from the memory resource given at construction. When
+// a MemoryAccount's limit leaves no room for a table, the object is scanned
+// instead.
+//
+// A table never changes once built, and is published through an atomic
+// directory, so lookups in an object that is already indexed take no lock.
+// The lock is only taken to build a table, and only threads waiting for that
+// object's table (or another new one) queue behind it. A directory that
+// fills up is replaced by a larger copy, and the old one is kept until
+// clear() for readers still probing it.
+class ObjectIndex {
+   public:
+    static const uint32_t kMinMembers = 32;
+    static const size_t kNotIndexed = ~size_t(0);
+
+    explicit ObjectIndex(std::pmr::memory_resource* memory =
+                             std::pmr::get_default_resource())
+        : memory(memory), directory(nullptr), tables(0), blocks(memory) {}
+    ~ObjectIndex() { clear(); }
+    ObjectIndex(const ObjectIndex&) = delete;
+    ObjectIndex& operator=(const ObjectIndex&) = delete;
+
+    // Tape index of the value of `key` in the object starting at tape index
+    // `object`, 0 when there is no such member, or kNotIndexed when the
+    // object's table doesn't fit in the memory limit. Safe to call from
+    // several threads.
+    size_t find(const DocumentView& doc, size_t object, StringRef key);
+
+    // Drops every table, for when the document changes. Not safe while
+    // other threads call find().
+    void clear();
+
+    size_t tableCount() const;
+    size_t memoryUsage() const;
+
+   private:
+    // A table is an array of words: the object's tape index, the slot mask,
+    // then the slots. Directories map tape indexes to tables by open
+    // addressing and are at most half full.
+    struct Directory {
+        size_t mask;
+        std::atomic<const uint64_t*>* entries;
+    };
+
+    // Memory obtained from `memory`, returned by clear()
+    struct Block {
+        void* data;
+        size_t bytes;
+    };
+
+    std::pmr::memory_resource* memory;
+    std::atomic<const Directory*> directory;
+    mutable std::mutex lock;  // Held to build and publish a table
+    size_t tables;
+    std::pmr::vector<Block> blocks;
+
+    const uint64_t* lookup(size_t object) const;
+    const uint64_t* build(const DocumentView& doc, size_t object);
+    void publish(const uint64_t* table);
+    void* allocate(size_t bytes);
+    void releaseLast();
+};
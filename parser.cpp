@@ -1,127 +1,656 @@
 #include "parser.h"
 
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "char_class.h"
+#include "lexer.h"
+#include "memory.h"
+#include "number.h"
+#include "schema.h"
+#include "structural_hash.h"
 #include "token.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define PARSER_SSE2 1
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PARSER_LITTLE_ENDIAN 1
+#endif
+
 Parser::Parser(std::vector<Token> tokens) {
-    this->tokens = tokens;
+    this->tokens.reserve(tokens.size());
+    for (const Token &token : tokens) {
+        this->tokens.push(token.type, token.offset);
+    }
+    if (!tokens.empty()) {
+        const Token &last = tokens.back();
+        this->tokens.setEndOffset(last.offset + last.lexeme.size());
+    }
     current = 0;
+    limit = 0;
+    source = nullptr;
+    hashes = nullptr;
+    keySource = nullptr;
+    keyTop = 0;
+    keyTableDepth = 0;
+    schema = nullptr;
+    schemaSource = nullptr;
+    rule = Schema::kAny;
 }
 
+Parser::Parser(TokenBuffer tokens)
+    : tokens(std::move(tokens)), current(0), limit(0), source(nullptr),
+      hashes(nullptr), scratch(this->tokens.resource()), keySource(nullptr),
+      keyHashes(this->tokens.resource()), keyTokens(this->tokens.resource()),
+      keyTop(0), keyTables(this->tokens.resource()), keyTableDepth(0),
+      keyScratch(this->tokens.resource()),
+      otherKeyScratch(this->tokens.resource()),
+      schema(nullptr), schemaSource(nullptr), rule(Schema::kAny),
+      requiredSeen(this->tokens.resource()) {}
+
 bool Parser::parse() {
     if (tokens.empty()) {
         return false;
     }
 
-    parseValue();
-
-    if (current < tokens.size()) {
-        throw std::runtime_error("Expected end of input");
+    ParseResult result = tryParse();
+    if (!result.ok()) {
+        throw std::runtime_error(result.message());
     }
 
     return true;
 }
 
-void Parser::parseValue() {
-    if (current >= tokens.size()) {
-        throw std::runtime_error("Unexpected end of input");
+ParseResult Parser::tryParse() { return tryParse(0, tokens.size()); }
+
+ParseResult Parser::tryParse(size_t first, size_t last) {
+    error = ParseResult();
+    current = first;
+    limit = last;
+    keyTop = 0;
+    keyTableDepth = 0;
+    rule = schema ? schema->root() : Schema::kAny;
+    requiredSeen.clear();
+
+    try {
+        if (parseValue() && current < limit) {
+            fail(ErrorCode::EXPECTED_END_OF_INPUT);
+        }
+    } catch (const MemoryLimitExceeded&) {
+        fail(ErrorCode::MEMORY_LIMIT_EXCEEDED);
     }
 
-    Token token = tokens[current];
+    return error;
+}
+
+ParseResult Parser::tryParseHashed(const Lexer& lexer,
+                                   std::vector<uint64_t>& hashes) {
+    hashes.assign(tokens.size(), 0);
+    source = &lexer;
+    this->hashes = &hashes;
+    ParseResult result = tryParse();
+    source = nullptr;
+    this->hashes = nullptr;
+    return result;
+}
+
+bool Parser::parseValue() {
+    TokenType type;
+    if (!peek(type)) {
+        return false;
+    }
+    if (rule != Schema::kAny && !checkValue(type)) {
+        return false;
+    }
 
-    switch (token.type) {
+    switch (type) {
         case TokenType::LEFT_BRACE:
-            parseObject();
-            break;
+            return parseObject();
         case TokenType::LEFT_BRACKET:
-            parseArray();
-            break;
+            return parseArray();
         case TokenType::STRING:
         case TokenType::NUMBER:
         case TokenType::TRUE:
         case TokenType::FALSE:
         case TokenType::NULL_TOKEN:
+            if (hashes) {
+                hashScalar(current);
+            }
             current++;  // Consume the token
-            break;
+            return true;
         default:
-            throw std::runtime_error("Unexpected token");
+            return fail(ErrorCode::UNEXPECTED_TOKEN);
     }
 }
 
-void Parser::parseObject() {
-    consume(TokenType::LEFT_BRACE);
+bool Parser::parseObject() {
+    size_t start = current;
+    if (!consume(TokenType::LEFT_BRACE)) {
+        return false;
+    }
+
+    // Member hashes are summed so that order doesn't matter
+    uint64_t memberSum = 0;
+    size_t count = 0;
+    KeyScope keys = {keyTop, 0, kNoTable};
+
+    // Bits for the required properties, cleared
+    uint32_t objectRule = rule;
+    size_t requiredBase = requiredSeen.size();
+    if (objectRule != Schema::kAny) {
+        size_t required = schema->node(objectRule).requiredCount;
+        requiredSeen.resize(requiredBase + (required + 63) / 64, 0);
+    }
 
-    if (peek().type == TokenType::RIGHT_BRACE) {
+    TokenType type;
+    if (!peek(type)) {
+        return false;
+    }
+    if (type == TokenType::RIGHT_BRACE) {
+        if (objectRule != Schema::kAny &&
+            !checkRequired(objectRule, requiredBase)) {
+            return false;
+        }
         current++;  // Empty object
-        return;
+        if (hashes) {
+            (*hashes)[start] = hashObject(0, 0);
+        }
+        return true;
     }
 
     while (true) {
         // Parse key (must be string)
-        if (peek().type != TokenType::STRING) {
-            throw std::runtime_error("Expected string key in object");
+        if (!peek(type)) {
+            return false;
         }
-        current++;  // Consume key
-
-        // Parse colon
-        consume(TokenType::COLON);
+        if (type != TokenType::STRING) {
+            return fail(ErrorCode::EXPECTED_STRING_KEY);
+        }
+        size_t key = current++;  // Consume key
 
-        // Parse value
-        parseValue();
+        // Parse colon and value
+        if (!consume(TokenType::COLON)) {
+            return false;
+        }
+        if (keySource && !addKey(key, keys)) {
+            current = key;
+            return fail(ErrorCode::DUPLICATE_KEY);
+        }
+        if (objectRule != Schema::kAny &&
+            !enterMember(objectRule, key, requiredBase)) {
+            return false;
+        }
+        size_t value = current;
+        if (!parseValue()) {
+            return false;
+        }
+        if (hashes) {
+            hashScalar(key);
+            memberSum += hashMember((*hashes)[key], (*hashes)[value]);
+            count++;
+        }
 
         // Check if we're done or need to parse more key-value pairs
-        if (peek().type == TokenType::RIGHT_BRACE) {
+        if (!peek(type)) {
+            return false;
+        }
+        if (type == TokenType::RIGHT_BRACE) {
+            if (objectRule != Schema::kAny &&
+                !checkRequired(objectRule, requiredBase)) {
+                return false;
+            }
             current++;
-            break;
+            if (hashes) {
+                (*hashes)[start] = hashObject(memberSum, count);
+            }
+            if (keySource) {
+                closeKeyScope(keys);
+            }
+            return true;
         }
 
-        consume(TokenType::COMMA);
+        if (!consume(TokenType::COMMA) || !peek(type)) {
+            return false;
+        }
 
         // Check for trailing comma by looking ahead
-        if (peek().type == TokenType::RIGHT_BRACE) {
-            throw std::runtime_error("Trailing comma in object");
+        if (type == TokenType::RIGHT_BRACE) {
+            return fail(ErrorCode::TRAILING_COMMA_IN_OBJECT);
         }
     }
 }
 
-void Parser::parseArray() {
-    consume(TokenType::LEFT_BRACKET);
+bool Parser::parseArray() {
+    size_t start = current;
+    if (!consume(TokenType::LEFT_BRACKET)) {
+        return false;
+    }
+
+    uint64_t state = hashArrayStart();
+    size_t count = 0;
+    uint32_t items =
+        rule == Schema::kAny ? Schema::kAny : schema->node(rule).items;
 
-    if (peek().type == TokenType::RIGHT_BRACKET) {
+    TokenType type;
+    if (!peek(type)) {
+        return false;
+    }
+    if (type == TokenType::RIGHT_BRACKET) {
         current++;  // Empty array
-        return;
+        if (hashes) {
+            (*hashes)[start] = hashArray(state, 0);
+        }
+        return true;
     }
 
     while (true) {
-        parseValue();
+        // Runs of scalar elements are checked 16 type bytes at a time, unless
+        // each one has to be hashed or checked against the schema
+        size_t pairs = hashes || items != Schema::kAny
+                           ? 0
+                           : tokens.scalarCommaPairs(current);
+        if (pairs > (limit - current) / 2) {
+            pairs = (limit - current) / 2;
+        }
+        if (pairs > 0) {
+            current += pairs * 2;
+            if (!peek(type)) {
+                return false;
+            }
+            if (type == TokenType::RIGHT_BRACKET) {
+                return fail(ErrorCode::TRAILING_COMMA_IN_ARRAY);
+            }
+        }
 
-        if (peek().type == TokenType::RIGHT_BRACKET) {
+        size_t element = current;
+        rule = items;
+        if (!parseValue() || !peek(type)) {
+            return false;
+        }
+        if (hashes) {
+            state = hashArrayElement(state, (*hashes)[element]);
+            count++;
+        }
+
+        if (type == TokenType::RIGHT_BRACKET) {
             current++;
-            break;
+            if (hashes) {
+                (*hashes)[start] = hashArray(state, count);
+            }
+            return true;
         }
 
-        consume(TokenType::COMMA);
+        if (!consume(TokenType::COMMA) || !peek(type)) {
+            return false;
+        }
 
         // Check for trailing comma by looking ahead
-        if (peek().type == TokenType::RIGHT_BRACKET) {
-            throw std::runtime_error("Trailing comma in array");
+        if (type == TokenType::RIGHT_BRACKET) {
+            return fail(ErrorCode::TRAILING_COMMA_IN_ARRAY);
         }
     }
 }
 
-Token Parser::peek() {
-    if (current >= tokens.size()) {
-        throw std::runtime_error("Unexpected end of input");
+bool Parser::peek(TokenType &type) {
+    if (current >= limit) {
+        return fail(ErrorCode::UNEXPECTED_END_OF_INPUT);
     }
-    return tokens[current];
+    type = tokens.type(current);
+    return true;
 }
 
-void Parser::consume(TokenType type) {
-    if (peek().type != type) {
-        throw std::runtime_error("Expected different token type");
+bool Parser::consume(TokenType type) {
+    TokenType next;
+    if (!peek(next)) {
+        return false;
+    }
+    if (next != type) {
+        return fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN);
     }
     current++;
-}
\ No newline at end of file
+    return true;
+}
+
+void Parser::hashScalar(size_t index) {
+    const char* start = source->data() + tokens.offset(index);
+    uint64_t hash;
+    switch (tokens.type(index)) {
+        case TokenType::STRING:
+            hash = hashString(source->string(tokens, index, scratch));
+            break;
+        case TokenType::NUMBER: {
+            const char* end = start;
+            matchNumber(end, source->data() + source->size());
+            hash = hashNumber(start, end);
+            break;
+        }
+        case TokenType::TRUE:
+            hash = hashBool(true);
+            break;
+        case TokenType::FALSE:
+            hash = hashBool(false);
+            break;
+        default:
+            hash = hashNull();
+            break;
+    }
+    (*hashes)[index] = hash;
+}
+
+// Records the key at `token` for the object of `scope`. Returns false if
+// the object already has it.
+bool Parser::addKey(size_t token, KeyScope& scope) {
+    uint32_t hash = keyHash(token);
+    if (scope.table == kNoTable) {
+        const uint32_t* inlineHashes = keyHashes.data() + scope.base;
+        const uint32_t* inlineTokens = keyTokens.data() + scope.base;
+        size_t i = 0;
+#if PARSER_SSE2
+        const __m128i needle = _mm_set1_epi32(static_cast<int>(hash));
+        for (; i + 4 <= scope.count; i += 4) {
+            __m128i block = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(inlineHashes + i));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpeq_epi32(block, needle))));
+            while (mask != 0) {
+                if (sameKey(inlineTokens[i + __builtin_ctz(mask)], token)) {
+                    return false;
+                }
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i < scope.count; i++) {
+            if (inlineHashes[i] == hash && sameKey(inlineTokens[i], token)) {
+                return false;
+            }
+        }
+        if (scope.count < kInlineKeys) {
+            if (keyTop == keyHashes.size()) {
+                // keyTokens first: if the memory limit stops the second
+                // resize, keyTokens is still at least as long
+                keyTokens.resize(2 * keyTop + 4 * kInlineKeys);
+                keyHashes.resize(keyTokens.size());
+            }
+            keyHashes[keyTop] = hash;
+            keyTokens[keyTop++] = static_cast<uint32_t>(token);
+            scope.count++;
+            return true;
+        }
+
+        // Too many keys to search linearly; move them to a set
+        scope.table = keyTableDepth++;
+        if (keyTables.size() < keyTableDepth) {
+            keyTables.emplace_back();
+        }
+        std::pmr::vector<uint64_t>& table = keyTables[scope.table];
+        table.assign(4 * kInlineKeys, 0);
+        for (i = 0; i < scope.count; i++) {
+            addTableKey(table, i, inlineHashes[i], inlineTokens[i]);
+        }
+        keyTop = scope.base;
+    }
+
+    if (!addTableKey(keyTables[scope.table], scope.count, hash, token)) {
+        return false;
+    }
+    scope.count++;
+    return true;
+}
+
+// Open addressing with linear probing, kept at most half full. A slot holds
+// the key's hash above its token index; token 0 is never a key, so 0 marks
+// an empty slot.
+bool Parser::addTableKey(std::pmr::vector<uint64_t>& table, size_t count,
+                         uint32_t hash, size_t token) {
+    if ((count + 1) * 2 > table.size()) {
+        std::pmr::vector<uint64_t> old(table.get_allocator());
+        old.swap(table);
+        table.assign(old.size() * 2, 0);
+        size_t mask = table.size() - 1;
+        for (uint64_t slot : old) {
+            if (slot != 0) {
+                size_t i = (slot >> 32) & mask;
+                while (table[i] != 0) {
+                    i = (i + 1) & mask;
+                }
+                table[i] = slot;
+            }
+        }
+    }
+
+    size_t mask = table.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint64_t slot = table[i];
+        if (slot == 0) {
+            table[i] = (uint64_t(hash) << 32) | token;
+            return true;
+        }
+        if ((slot >> 32) == hash && sameKey(slot & 0xffffffff, token)) {
+            return false;
+        }
+    }
+}
+
+void Parser::closeKeyScope(const KeyScope& scope) {
+    if (scope.table != kNoTable) {
+        keyTableDepth--;
+    } else {
+        keyTop = scope.base;
+    }
+}
+
+// Decoded text of a key whose colon has been consumed. Without escapes the
+// closing quote is found by stepping back from the colon, which saves
+// scanning the key again.
+StringRef Parser::keyText(const Lexer& lexer, size_t token,
+                          std::pmr::string& decoded) const {
+    if (tokens.hasEscapes(token)) {
+        return lexer.string(tokens, token, decoded);
+    }
+    const char* start = lexer.data() + tokens.offset(token) + 1;
+    const char* quote = lexer.data() + tokens.offset(token + 1) - 1;
+    while (*quote != '"') {
+        quote--;
+    }
+    return StringRef(start, quote - start);
+}
+
+// Keys of up to 16 bytes are covered by their first and last 8 bytes and
+// take two multiplies; longer ones are hashed in full
+uint32_t Parser::keyHash(size_t token) {
+    StringRef key = keyText(*keySource, token, keyScratch);
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    if (key.size > 16) {
+        return static_cast<uint32_t>(hashString(key));
+    } else if (key.size >= 8) {
+        memcpy(&head, key.data, 8);
+        memcpy(&tail, key.data + key.size - 8, 8);
+#if PARSER_LITTLE_ENDIAN
+    } else if (key.size > 0 && !tokens.hasEscapes(token) &&
+               key.data - keySource->data() >= 8) {
+        // Load the 8 bytes that end with the key and shift out the ones
+        // before it, giving the same value as the loop below
+        memcpy(&head, key.data + key.size - 8, 8);
+        head >>= 64 - 8 * key.size;
+#endif
+    } else {
+        for (size_t i = 0; i < key.size; i++) {
+            head |= uint64_t(static_cast<unsigned char>(key.data[i]))
+                    << (8 * i);
+        }
+    }
+    uint64_t hash = (head ^ key.size) * 0x9e3779b97f4a7c15ULL;
+    hash ^= tail * 0xc2b2ae3d27d4eb4fULL;
+    return static_cast<uint32_t>(hash >> 32) ^ static_cast<uint32_t>(hash);
+}
+
+bool Parser::sameKey(size_t a, size_t b) {
+    return keyText(*keySource, a, keyScratch) ==
+           keyText(*keySource, b, otherKeyScratch);
+}
+
+// Checks the value at `current` against `rule`, apart from the members and
+// elements of containers
+bool Parser::checkValue(TokenType type) {
+    const SchemaNode& node = schema->node(rule);
+    uint8_t kind;
+    switch (type) {
+        case TokenType::LEFT_BRACE:
+            kind = ST_OBJECT;
+            break;
+        case TokenType::LEFT_BRACKET:
+            kind = ST_ARRAY;
+            break;
+        case TokenType::STRING:
+            kind = ST_STRING;
+            break;
+        case TokenType::NUMBER:
+            kind = ST_NUMBER;
+            break;
+        case TokenType::TRUE:
+        case TokenType::FALSE:
+            kind = ST_BOOLEAN;
+            break;
+        case TokenType::NULL_TOKEN:
+            kind = ST_NULL;
+            break;
+        default:
+            return true;  // Left to parseValue() to reject
+    }
+
+    // Numbers are only converted when something depends on their value
+    bool allowed = (node.types & kind) != 0;
+    double number = 0;
+    if (kind == ST_NUMBER && (node.checksNumber || !allowed)) {
+        number = numberAt(current);
+        allowed = allowed || ((node.types & ST_INTEGER) &&
+                              std::isfinite(number) &&
+                              std::floor(number) == number);
+    }
+    if (!allowed) {
+        return fail(ErrorCode::SCHEMA_TYPE_MISMATCH);
+    }
+
+    if (node.hasEnum) {
+        bool found = false;
+        StringRef text;
+        if (kind == ST_STRING) {
+            text = schemaSource->string(tokens, current, scratch);
+        }
+        for (uint32_t e = node.firstEnum;
+             e < node.firstEnum + node.enumCount && !found; e++) {
+            const SchemaEnumValue& value = schema->enumValue(e);
+            if (value.type != kind) {
+                continue;
+            }
+            switch (kind) {
+                case ST_STRING:
+                    found = text == StringRef(value.text);
+                    break;
+                case ST_NUMBER:
+                    found = number == value.number;
+                    break;
+                case ST_BOOLEAN:
+                    found = value.boolean == (type == TokenType::TRUE);
+                    break;
+                default:
+                    found = true;
+                    break;
+            }
+        }
+        if (!found) {
+            return fail(ErrorCode::SCHEMA_ENUM_MISMATCH);
+        }
+    }
+
+    if (kind == ST_NUMBER && node.checksNumber) {
+        bool low = node.exclusiveMinimum ? number <= node.minimum
+                                         : number < node.minimum;
+        bool high = node.exclusiveMaximum ? number >= node.maximum
+                                          : number > node.maximum;
+        if (low || high) {
+            return fail(ErrorCode::SCHEMA_OUT_OF_RANGE);
+        }
+    }
+
+    if (kind == ST_STRING && node.checksLength) {
+        // Code points: every byte but UTF-8 continuation bytes
+        StringRef text = schemaSource->string(tokens, current, scratch);
+        size_t length = 0;
+        for (size_t i = 0; i < text.size; i++) {
+            unsigned char c = static_cast<unsigned char>(text.data[i]);
+            length += (c & 0xc0) != 0x80;
+        }
+        if (length < node.minLength || length > node.maxLength) {
+            return fail(ErrorCode::SCHEMA_LENGTH_OUT_OF_RANGE);
+        }
+    }
+    return true;
+}
+
+// Sets `rule` for the value of the member whose key is at `key`, marking
+// required properties as found. Fails when the schema allows no such
+// property.
+bool Parser::enterMember(uint32_t objectRule, size_t key,
+                         size_t requiredBase) {
+    const SchemaNode& node = schema->node(objectRule);
+    uint32_t found = Schema::kNoProperty;
+    if (node.propertyCount > 0) {
+        found = schema->findProperty(
+            objectRule, keyText(*schemaSource, key, scratch));
+    }
+    if (found == Schema::kNoProperty) {
+        if (node.additional == Schema::kNever) {
+            current = key;
+            return fail(ErrorCode::SCHEMA_ADDITIONAL_PROPERTY);
+        }
+        rule = node.additional;
+        return true;
+    }
+
+    const SchemaProperty& property = schema->property(found);
+    if (property.required != Schema::kNotRequired) {
+        requiredSeen[requiredBase + property.required / 64] |=
+            uint64_t(1) << (property.required % 64);
+    }
+    rule = property.node;
+    return true;
+}
+
+// At the closing brace of an object: were all its required properties
+// found? Drops the object's bits either way.
+bool Parser::checkRequired(uint32_t objectRule, size_t requiredBase) {
+    size_t found = 0;
+    for (size_t i = requiredBase; i < requiredSeen.size(); i++) {
+        found += __builtin_popcountll(requiredSeen[i]);
+    }
+    requiredSeen.resize(requiredBase);
+    if (found != schema->node(objectRule).requiredCount) {
+        return fail(ErrorCode::SCHEMA_MISSING_PROPERTY);
+    }
+    return true;
+}
+
+double Parser::numberAt(size_t index) const {
+    const char* start = schemaSource->data() + tokens.offset(index);
+    const char* end = start;
+    matchNumber(end, schemaSource->data() + schemaSource->size());
+    return parseDouble(start, end);
+}
+
+bool Parser::fail(ErrorCode code) {
+    size_t offset =
+        current < tokens.size() ? tokens.offset(current) : tokens.endOffset();
+    error = ParseResult(code, offset);
+    return false;
+}
@@ -1,20 +1,125 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
 #include <vector>
 
+#include "error.h"
+#include "string_ref.h"
 #include "token.h"
+#include "token_buffer.h"
+
+class Lexer;
+class Schema;
 
 class Parser {
    public:
     Parser(std::vector<Token> tokens);
+
+    // The key sets of strict mode and the scratch space for decoding escaped
+    // strings are allocated from the same memory resource as `tokens`
+    Parser(TokenBuffer tokens);
+
+    // Throws std::runtime_error describing the first syntax error.
     bool parse();
 
+    // No-throw variant of parse(). An empty token stream is reported as
+    // UNEXPECTED_END_OF_INPUT, and running out of a MemoryAccount's limit
+    // as MEMORY_LIMIT_EXCEEDED. Error offsets are byte offsets of the
+    // offending token.
+    ParseResult tryParse();
+
+    // Checks that tokens [first, last) form exactly one value, e.g. a single
+    // container whose surroundings are known to be valid.
+    ParseResult tryParse(size_t first, size_t last);
+
+    // Validates like tryParse() and, in the same pass, computes the
+    // structural hash (structural_hash.h) of every value. `hashes` gets one
+    // entry per token: the hash of the value or key starting there, or 0.
+    // hashes[0] is the hash of the whole document. `lexer` is the Lexer
+    // that produced the tokens.
+    ParseResult tryParseHashed(const Lexer& lexer,
+                               std::vector<uint64_t>& hashes);
+
+    // Strict mode: later parses fail with DUPLICATE_KEY, at the second
+    // occurrence, when an object repeats a key. Keys are compared decoded,
+    // so "a" and "\u0061" clash. `lexer` produced the tokens and must
+    // outlive the parses; nullptr turns the check off.
+    void checkDuplicateKeys(const Lexer* lexer) { keySource = lexer; }
+
+    // Makes later parses check the document against `schema` as they go,
+    // failing with a SCHEMA_ error at the first value, key or closing brace
+    // that breaks it. `lexer` produced the tokens; both must outlive the
+    // parses. nullptr turns the check off.
+    void checkSchema(const Schema* schema, const Lexer* lexer) {
+        this->schema = schema;
+        schemaSource = lexer;
+    }
+
+    const TokenBuffer& tokenBuffer() const { return tokens; }
+    TokenBuffer& tokenBuffer() { return tokens; }
+
    private:
-    std::vector<Token> tokens;
+    TokenBuffer tokens;
     size_t current;
+    size_t limit;  // End of the token range being parsed
+    ParseResult error;
+
+    // Set only while hashing
+    const Lexer* source;
+    std::vector<uint64_t>* hashes;
+    std::pmr::string scratch;
+
+    // Keys of the objects being parsed, for checkDuplicateKeys(). The first
+    // kInlineKeys keys of an object go on a stack of 32-bit hashes that is
+    // searched with SIMD compares; an object with more moves to a flat hash
+    // set. Sets are kept per nesting level and reused across objects.
+    struct KeyScope {
+        size_t base;   // Start of the object's keys on the stack
+        size_t count;
+        size_t table;  // Index into keyTables, or kNoTable
+    };
+    static const size_t kInlineKeys = 16;
+    static const size_t kNoTable = ~size_t(0);
+
+    const Lexer* keySource;
+    std::pmr::vector<uint32_t> keyHashes;
+    std::pmr::vector<uint32_t> keyTokens;
+    size_t keyTop;  // Size of the stack; the vectors are its capacity
+    std::pmr::vector<std::pmr::vector<uint64_t>> keyTables;
+    size_t keyTableDepth;
+    std::pmr::string keyScratch;
+    std::pmr::string otherKeyScratch;
+
+    // For checkSchema(). `rule` is the schema node of the value about to be
+    // parsed, Schema::kAny when there is nothing to check. requiredSeen has
+    // a bit per required property of each object being parsed.
+    const Schema* schema;
+    const Lexer* schemaSource;
+    uint32_t rule;
+    std::pmr::vector<uint64_t> requiredSeen;
+
+    bool fail(ErrorCode code);
+
+    bool parseValue();
+    bool parseObject();
+    bool parseArray();
+    bool peek(TokenType& type);
+    bool consume(TokenType type);
+    void hashScalar(size_t index);
+
+    bool addKey(size_t token, KeyScope& scope);
+    bool addTableKey(std::pmr::vector<uint64_t>& table, size_t count,
+                     uint32_t hash, size_t token);
+    void closeKeyScope(const KeyScope& scope);
+    StringRef keyText(const Lexer& lexer, size_t token,
+                      std::pmr::string& decoded) const;
+    uint32_t keyHash(size_t token);
+    bool sameKey(size_t a, size_t b);
 
-    void parseValue();
-    void parseObject();
-    void parseArray();
-    Token peek();
-    void consume(TokenType type);
-};
\ No newline at end of file
+    bool checkValue(TokenType type);
+    bool enterMember(uint32_t objectRule, size_t key, size_t requiredBase);
+    bool checkRequired(uint32_t objectRule, size_t requiredBase);
+    double numberAt(size_t index) const;
+};
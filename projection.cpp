@@ -0,0 +1,530 @@
+#include "projection.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "char_class.h"
+#include "input.h"
+#include "kernels.h"
+
+// Inputs smaller than this per thread are projected on the calling thread
+static const size_t kMinBytesPerThread = 1 << 16;
+
+static const size_t kNoNode = static_cast<size_t>(-1);
+
+// Walks one record, descending only into members and elements that lead to
+// a requested field
+struct Projection::RecordScanner {
+    const Projection& projection;
+    const char* begin;
+    const char* p;
+    const char* end;
+    const Kernels& scan;
+    std::vector<StringRef>& values;
+    size_t remaining;  // Field nodes not found yet
+    ParseResult error;
+    std::string key;  // Scratch for keys containing escapes
+
+    bool fail(ErrorCode code, const char* at, char detail = '\0') {
+        error = ParseResult(code, at - begin, detail);
+        return false;
+    }
+
+    void skipWhitespace() { p += scan.skipWhitespace(p, end - p); }
+
+    // `p` is at the opening quote; leaves it past the closing one
+    bool skipString() {
+        p++;
+        while (true) {
+            p += scan.scanString(p, end - p);
+            if (p == end) {
+                return fail(ErrorCode::UNTERMINATED_STRING, p);
+            }
+            switch (stringCharClass(*p)) {
+                case SC_QUOTE:
+                    p++;
+                    return true;
+                case SC_BACKSLASH:
+                    if (end - p < 2) {
+                        return fail(ErrorCode::UNTERMINATED_STRING, end);
+                    }
+                    p += 2;  // The escaped byte can't end the string
+                    break;
+                default:
+                    return fail(ErrorCode::CONTROL_CHARACTER_IN_STRING, p);
+            }
+        }
+    }
+
+    // Matches brackets without looking at anything between them except
+    // strings, whose contents could otherwise be mistaken for brackets
+    bool skipContainer() {
+        size_t depth = 0;
+        while (true) {
+            p += scan.findStructural(p, end - p);
+            if (p == end) {
+                return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+            }
+            switch (charClass(*p)) {
+                case CC_QUOTE:
+                    if (!skipString()) {
+                        return false;
+                    }
+                    break;
+                case CC_LEFT_BRACE:
+                case CC_LEFT_BRACKET:
+                    depth++;
+                    p++;
+                    break;
+                case CC_RIGHT_BRACE:
+                case CC_RIGHT_BRACKET:
+                    p++;
+                    if (--depth == 0) {
+                        return true;
+                    }
+                    break;
+                default:  // Colons and commas
+                    p++;
+                    break;
+            }
+        }
+    }
+
+    bool skipLiteral(const char* literal, size_t length) {
+        ErrorCode code = matchLiteral(p, end, literal, length);
+        if (code != ErrorCode::NONE) {
+            return fail(code, p, literal[0]);
+        }
+        p += length;
+        return true;
+    }
+
+    bool skipValue() {
+        if (p == end) {
+            return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+        }
+        switch (charClass(*p)) {
+            case CC_LEFT_BRACE:
+            case CC_LEFT_BRACKET:
+                return skipContainer();
+            case CC_QUOTE:
+                return skipString();
+            case CC_NUMBER: {
+                NumberState state = matchNumber(p, end);
+                return state == NS_DONE || fail(numberError(state), p);
+            }
+            case CC_TRUE:
+                return skipLiteral("true", 4);
+            case CC_FALSE:
+                return skipLiteral("false", 5);
+            case CC_NULL:
+                return skipLiteral("null", 4);
+            case CC_OTHER:
+                return fail(ErrorCode::INVALID_CHARACTER, p, *p);
+            default:
+                return fail(ErrorCode::UNEXPECTED_TOKEN, p);
+        }
+    }
+
+    size_t findChild(size_t node, StringRef rawKey) {
+        // Keys are compared unescaped, but only decoded when they need it
+        if (memchr(rawKey.data, '\\', rawKey.size) != nullptr) {
+            key.clear();
+            unescapeString(rawKey, key);
+            rawKey = StringRef(key);
+        }
+        for (size_t child : projection.nodes[node].children) {
+            if (StringRef(projection.nodes[child].segment) == rawKey) {
+                return child;
+            }
+        }
+        return kNoNode;
+    }
+
+    size_t findChild(size_t node, long index) const {
+        for (size_t child : projection.nodes[node].children) {
+            if (projection.nodes[child].index == index) {
+                return child;
+            }
+        }
+        return kNoNode;
+    }
+
+    // Expects ',' or the closing bracket after a member or element. Sets
+    // `done` at the closing bracket.
+    bool separator(char close, bool& done) {
+        skipWhitespace();
+        if (p == end) {
+            return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+        }
+        if (*p == close) {
+            p++;
+            done = true;
+            return true;
+        }
+        if (*p != ',') {
+            return fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN, p);
+        }
+        p++;
+        done = false;
+        return true;
+    }
+
+    bool projectObject(size_t node) {
+        p++;  // Skip '{'
+        skipWhitespace();
+        if (p < end && *p == '}') {
+            p++;
+            return true;
+        }
+
+        while (true) {
+            skipWhitespace();
+            if (p == end) {
+                return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+            }
+            if (*p == '}') {
+                return fail(ErrorCode::TRAILING_COMMA_IN_OBJECT, p);
+            }
+            if (*p != '"') {
+                return fail(ErrorCode::EXPECTED_STRING_KEY, p);
+            }
+            const char* keyStart = p + 1;
+            if (!skipString()) {
+                return false;
+            }
+            size_t child =
+                findChild(node, StringRef(keyStart, p - 1 - keyStart));
+
+            skipWhitespace();
+            if (p == end) {
+                return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+            }
+            if (*p != ':') {
+                return fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN, p);
+            }
+            p++;
+
+            if (!member(child)) {
+                return false;
+            }
+            if (remaining == 0) {
+                return true;  // Nothing left to find in this record
+            }
+
+            bool done;
+            if (!separator('}', done)) {
+                return false;
+            }
+            if (done) {
+                return true;
+            }
+        }
+    }
+
+    bool projectArray(size_t node) {
+        p++;  // Skip '['
+        skipWhitespace();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+
+        for (long index = 0;; index++) {
+            skipWhitespace();
+            if (p < end && *p == ']') {
+                return fail(ErrorCode::TRAILING_COMMA_IN_ARRAY, p);
+            }
+            if (!member(findChild(node, index))) {
+                return false;
+            }
+            if (remaining == 0) {
+                return true;
+            }
+
+            bool done;
+            if (!separator(']', done)) {
+                return false;
+            }
+            if (done) {
+                return true;
+            }
+        }
+    }
+
+    // Projects a member or element value, or skips it when no path uses it
+    bool member(size_t child) {
+        if (child != kNoNode) {
+            return projectValue(child);
+        }
+        skipWhitespace();
+        return skipValue();
+    }
+
+    bool projectValue(size_t node) {
+        const PathNode& path = projection.nodes[node];
+        skipWhitespace();
+        if (p == end) {
+            return fail(ErrorCode::UNEXPECTED_END_OF_INPUT, p);
+        }
+
+        const char* start = p;
+        bool ok;
+        if (!path.children.empty() && *p == '{') {
+            ok = projectObject(node);
+        } else if (!path.children.empty() && *p == '[') {
+            ok = projectArray(node);
+        } else {
+            ok = skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+
+        // While a field here is missing `remaining` is non-zero, so the
+        // container above was scanned to its end. Duplicate keys keep the
+        // first value.
+        if (!path.fields.empty() && values[path.fields[0]].data == nullptr) {
+            for (size_t field : path.fields) {
+                values[field] = StringRef(start, p - start);
+            }
+            remaining--;
+        }
+        return true;
+    }
+};
+
+ParseResult Projection::addPath(const std::string& pointer) {
+    if (!pointer.empty() && pointer[0] != '/') {
+        return ParseResult(ErrorCode::INVALID_JSON_POINTER, 0);
+    }
+
+    size_t node = 0;
+    size_t i = 0;
+    while (i < pointer.size()) {
+        // pointer[i] is the '/' starting a segment
+        std::string segment;
+        for (i++; i < pointer.size() && pointer[i] != '/'; i++) {
+            if (pointer[i] != '~') {
+                segment += pointer[i];
+                continue;
+            }
+            char escaped = i + 1 < pointer.size() ? pointer[i + 1] : '\0';
+            if (escaped != '0' && escaped != '1') {
+                return ParseResult(ErrorCode::INVALID_JSON_POINTER, i);
+            }
+            segment += escaped == '0' ? '~' : '/';
+            i++;
+        }
+        node = childFor(node, segment);
+    }
+
+    if (nodes[node].fields.empty()) {
+        fieldNodes++;
+    }
+    nodes[node].fields.push_back(paths.size());
+    paths.push_back(pointer);
+
+    std::string key = "\"";
+    for (char c : pointer) {
+        if (c == '"' || c == '\\') {
+            key += '\\';
+        }
+        key += c;
+    }
+    outputKeys.push_back(key + "\":");
+    return ParseResult();
+}
+
+size_t Projection::childFor(size_t node, const std::string& segment) {
+    for (size_t child : nodes[node].children) {
+        if (nodes[child].segment == segment) {
+            return child;
+        }
+    }
+
+    PathNode child;
+    child.segment = segment;
+    // Array indices are decimal without leading zeros
+    bool digits = !segment.empty() && segment.size() < 10 &&
+                  (segment[0] != '0' || segment.size() == 1);
+    for (char c : segment) {
+        digits = digits && c >= '0' && c <= '9';
+    }
+    if (digits) {
+        child.index = strtol(segment.c_str(), nullptr, 10);
+    }
+
+    nodes.push_back(child);
+    nodes[node].children.push_back(nodes.size() - 1);
+    return nodes.size() - 1;
+}
+
+ParseResult Projection::project(const char* data, size_t size,
+                                std::vector<StringRef>& values) const {
+    values.assign(paths.size(), StringRef(nullptr, 0));
+    RecordScanner scanner = {*this,  data,       data, data + size,
+                             kernels(), values, fieldNodes, ParseResult(),
+                             std::string()};
+    if (!scanner.projectValue(0)) {
+        return scanner.error;
+    }
+
+    // Trailing content is only checked when the whole record was scanned
+    if (scanner.remaining > 0) {
+        scanner.skipWhitespace();
+        if (scanner.p != scanner.end) {
+            scanner.fail(ErrorCode::EXPECTED_END_OF_INPUT, scanner.p);
+        }
+    }
+    return scanner.error;
+}
+
+void Projection::appendRecord(const std::vector<StringRef>& values,
+                              ProjectionFormat format,
+                              std::string& output) const {
+    if (format == ProjectionFormat::NDJSON) {
+        output += '{';
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) {
+                output += ',';
+            }
+            output += outputKeys[i];
+            if (values[i].data != nullptr) {
+                output.append(values[i].data, values[i].size);
+            } else {
+                output += "null";
+            }
+        }
+        output += "}\n";
+        return;
+    }
+
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i > 0) {
+            output += '\t';
+        }
+        size_t start = output.size();
+        output.append(values[i].data, values[i].size);
+        // Tabs can only be whitespace between tokens of a container value
+        for (size_t j = start; j < output.size(); j++) {
+            if (output[j] == '\t') {
+                output[j] = ' ';
+            }
+        }
+    }
+    output += '\n';
+}
+
+ParseResult Projection::projectChunk(const char* data, size_t size,
+                                     size_t base, ProjectionFormat format,
+                                     std::string& output) const {
+    std::vector<StringRef> values;
+    ParseResult result =
+        forEachRecord(data, size, [&](const char* line, size_t length) {
+            ParseResult projected = project(line, length, values);
+            if (projected.ok()) {
+                appendRecord(values, format, output);
+            }
+            return projected;
+        });
+    if (!result.ok()) {
+        result.offset += base;
+    }
+    return result;
+}
+
+ParseResult Projection::projectLines(const char* data, size_t size,
+                                     const ProjectionOptions& options,
+                                     std::string& output) const {
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads > size / kMinBytesPerThread) {
+        threads = size / kMinBytesPerThread;
+    }
+    if (threads <= 1) {
+        return projectChunk(data, size, 0, options.format, output);
+    }
+
+    // Split at line boundaries so each thread gets whole records
+    std::vector<size_t> bounds(1, 0);
+    for (size_t i = 1; i < threads; i++) {
+        size_t target = size * i / threads;
+        if (target < bounds.back()) {
+            target = bounds.back();
+        }
+        const char* newline = static_cast<const char*>(
+            memchr(data + target, '\n', size - target));
+        bounds.push_back(newline != nullptr ? newline - data + 1 : size);
+    }
+    bounds.push_back(size);
+
+    size_t chunks = bounds.size() - 1;
+    std::vector<std::string> outputs(chunks);
+    std::vector<ParseResult> results(chunks);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks; i++) {
+        workers.push_back(std::thread([&, i]() {
+            results[i] =
+                projectChunk(data + bounds[i], bounds[i + 1] - bounds[i],
+                             bounds[i], options.format, outputs[i]);
+        }));
+    }
+    results[0] = projectChunk(data, bounds[1], 0, options.format, outputs[0]);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Same output as a sequential run: everything up to the first error
+    for (size_t i = 0; i < chunks; i++) {
+        output += outputs[i];
+        if (!results[i].ok()) {
+            return results[i];
+        }
+    }
+    return ParseResult();
+}
+
+ParseResult Projection::projectStream(std::istream& in, std::ostream& out,
+                                      const ProjectionOptions& options) const {
+    std::string block;
+    std::string output;
+    size_t base = 0;  // Input offset of block[0]
+    while (true) {
+        size_t kept = block.size();
+        block.resize(kept + options.blockSize);
+        in.read(&block[kept], options.blockSize);
+        block.resize(kept + in.gcount());
+        bool last = !in;
+
+        // Hold back a partial last line until the rest of it is read
+        size_t cut = block.size();
+        if (!last) {
+            size_t newline = block.rfind('\n');
+            if (newline == std::string::npos) {
+                continue;
+            }
+            cut = newline + 1;
+        }
+
+        output.clear();
+        ParseResult result = projectLines(block.data(), cut, options, output);
+        out.write(output.data(), output.size());
+        if (!result.ok()) {
+            result.offset += base;
+            return result;
+        }
+        if (last) {
+            return ParseResult();
+        }
+        base += cut;
+        block.erase(0, cut);
+    }
+}
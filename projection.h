@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "error.h"
+#include "string_ref.h"
+
+enum class ProjectionFormat {
+    NDJSON,  // {"<path>": <value>, ...} per record, null when missing
+    TSV,     // Tab-separated values, empty when missing
+};
+
+struct ProjectionOptions {
+    ProjectionFormat format;
+    unsigned threads;  // 0 picks one per hardware thread
+    size_t blockSize;  // Bytes of input read per batch when streaming
+
+    ProjectionOptions()
+        : format(ProjectionFormat::NDJSON), threads(0), blockSize(8 << 20) {}
+};
+
+// Extracts a fixed set of fields from JSON records given as JSON Pointers
+// (RFC 6901), e.g. "/user/name" or "/items/0/id". A record is scanned
+// once: members and elements that no path leads into are skipped by quote
+// and bracket matching alone, scanning stops as soon as every field has been
+// found, and matched values are returned as raw slices of the input with
+// nothing decoded. Skipped parts are only checked for balanced brackets and
+// terminated strings, so use the Validator when full validation matters.
+class Projection {
+   public:
+    Projection() : fieldNodes(0) { nodes.push_back(PathNode()); }
+
+    // Adds a field. Fails with INVALID_JSON_POINTER, with the offset into
+    // `pointer`, if it is neither empty nor starts with '/' or contains a bad
+    // '~' escape.
+    ParseResult addPath(const std::string& pointer);
+
+    size_t fieldCount() const { return paths.size(); }
+    const std::string& path(size_t field) const { return paths[field]; }
+
+    // Finds the fields in one record. `values` gets one entry per field, in
+    // the order they were added; missing fields have a null `data`.
+    ParseResult project(const char* data, size_t size,
+                        std::vector<StringRef>& values) const;
+
+    // Projects every non-blank line of `data`, appending one output line per
+    // record to `output`. Records are split between threads; error offsets
+    // are relative to `data`.
+    ParseResult projectLines(const char* data, size_t size,
+                             const ProjectionOptions& options,
+                             std::string& output) const;
+
+    // Streams NDJSON from `in` to `out` in blocks of options.blockSize
+    ParseResult projectStream(std::istream& in, std::ostream& out,
+                              const ProjectionOptions& options) const;
+
+   private:
+    // One step of the path trie. `segment` is the unescaped key; `index` is
+    // its value as an array index, or -1 when it isn't one.
+    struct PathNode {
+        std::string segment;
+        long index;
+        std::vector<size_t> fields;  // Output columns of paths ending here
+        std::vector<size_t> children;
+
+        PathNode() : index(-1) {}
+    };
+
+    std::vector<PathNode> nodes;  // nodes[0] is the document root
+    std::vector<std::string> paths;
+    std::vector<std::string> outputKeys;  // "<path>": for NDJSON output
+    size_t fieldNodes;                    // Nodes with at least one field
+
+    struct RecordScanner;
+
+    size_t childFor(size_t node, const std::string& segment);
+
+    ParseResult projectChunk(const char* data, size_t size, size_t base,
+                             ProjectionFormat format,
+                             std::string& output) const;
+    void appendRecord(const std::vector<StringRef>& values,
+                      ProjectionFormat format, std::string& output) const;
+};
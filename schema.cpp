@@ -0,0 +1,415 @@
+#include "schema.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "char_class.h"
+#include "input.h"
+#include "lexer.h"
+#include "number.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+SchemaNode::SchemaNode()
+    : types(ST_ANY),
+      hasEnum(false),
+      checksNumber(false),
+      checksLength(false),
+      exclusiveMinimum(false),
+      exclusiveMaximum(false),
+      minimum(-std::numeric_limits<double>::infinity()),
+      maximum(std::numeric_limits<double>::infinity()),
+      minLength(0),
+      maxLength(SIZE_MAX),
+      items(Schema::kAny),
+      additional(Schema::kAny),
+      firstProperty(0),
+      propertyCount(0),
+      requiredCount(0),
+      firstEnum(0),
+      enumCount(0) {}
+
+Schema::Schema() { clear(); }
+
+void Schema::clear() {
+    nodes.assign(2, SchemaNode());
+    nodes[kNever].types = 0;
+    properties.clear();
+    enumValues.clear();
+    rootNode = kAny;
+}
+
+// Walks the tokens of a schema the Parser accepted, adding a node for each
+// object schema
+struct SchemaCompiler {
+    const Lexer& lexer;
+    const TokenBuffer& tokens;
+    Schema& schema;
+    size_t i;
+    ParseResult error;
+    std::string scratch;
+
+    bool fail(size_t token) {
+        error = ParseResult(ErrorCode::INVALID_SCHEMA, tokens.offset(token));
+        return false;
+    }
+
+    std::string text(size_t token) {
+        return lexer.string(tokens, token, scratch).str();
+    }
+
+    double number(size_t token) {
+        const char* start = lexer.data() + tokens.offset(token);
+        const char* end = start;
+        matchNumber(end, lexer.data() + lexer.size());
+        return parseDouble(start, end);
+    }
+
+    // Steps over the value at `i`
+    void skipValue() {
+        size_t depth = 0;
+        do {
+            TokenType type = tokens.type(i++);
+            if (type == TokenType::LEFT_BRACE ||
+                type == TokenType::LEFT_BRACKET) {
+                depth++;
+            } else if (type == TokenType::RIGHT_BRACE ||
+                       type == TokenType::RIGHT_BRACKET) {
+                depth--;
+            }
+        } while (depth > 0);
+    }
+
+    bool compileSchema(uint32_t& result);
+    bool compileKeyword(uint32_t index, size_t key,
+                        std::vector<SchemaProperty>& listed,
+                        std::vector<std::string>& required);
+    bool compileTypeName(uint8_t& types);
+    bool compileEnum(uint32_t index);
+    bool compileLength(size_t& length);
+};
+
+bool SchemaCompiler::compileSchema(uint32_t& result) {
+    switch (tokens.type(i)) {
+        case TokenType::TRUE:
+            i++;
+            result = Schema::kAny;
+            return true;
+        case TokenType::FALSE:
+            i++;
+            result = Schema::kNever;
+            return true;
+        case TokenType::LEFT_BRACE:
+            break;
+        default:
+            return fail(i);
+    }
+
+    // Nested schemas add nodes too, so this one is only ever reached by
+    // index, and its properties are gathered here until it is complete
+    uint32_t index = static_cast<uint32_t>(schema.nodes.size());
+    schema.nodes.push_back(SchemaNode());
+    std::vector<SchemaProperty> listed;
+    std::vector<std::string> required;
+    if (tokens.type(++i) == TokenType::RIGHT_BRACE) {
+        i++;
+    } else {
+        while (true) {
+            size_t key = i;
+            i += 2;  // Key and colon
+            if (!compileKeyword(index, key, listed, required)) {
+                return false;
+            }
+            if (tokens.type(i++) == TokenType::RIGHT_BRACE) {
+                break;
+            }
+        }
+    }
+
+    // Required keys number from 0 and become properties if not listed
+    SchemaNode& node = schema.nodes[index];
+    for (const std::string& name : required) {
+        SchemaProperty* property = nullptr;
+        for (SchemaProperty& candidate : listed) {
+            if (candidate.key == name) {
+                property = &candidate;
+            }
+        }
+        if (property == nullptr) {
+            listed.push_back(
+                SchemaProperty{name, Schema::kAny, Schema::kNotRequired});
+            property = &listed.back();
+        }
+        if (property->required == Schema::kNotRequired) {
+            property->required = node.requiredCount++;
+        }
+    }
+    node.firstProperty = static_cast<uint32_t>(schema.properties.size());
+    node.propertyCount = static_cast<uint32_t>(listed.size());
+    for (SchemaProperty& property : listed) {
+        schema.properties.push_back(std::move(property));
+    }
+    node.checksLength = node.minLength > 0 || node.maxLength != SIZE_MAX;
+
+    // A schema without assertions, such as {}, accepts anything
+    bool trivial = node.types == ST_ANY && !node.hasEnum &&
+                   !node.checksNumber && !node.checksLength &&
+                   node.items == Schema::kAny &&
+                   node.additional == Schema::kAny &&
+                   node.propertyCount == 0;
+    if (trivial && index + 1 == schema.nodes.size()) {
+        schema.nodes.pop_back();
+        index = Schema::kAny;
+    }
+    result = index;
+    return true;
+}
+
+// Compiles the keyword at token `key`, whose value is at `i`
+bool SchemaCompiler::compileKeyword(uint32_t index, size_t key,
+                                    std::vector<SchemaProperty>& listed,
+                                    std::vector<std::string>& required) {
+    std::string keyword = text(key);
+    TokenType type = tokens.type(i);
+    uint32_t child;
+
+    if (keyword == "type") {
+        uint8_t types = 0;
+        if (type == TokenType::STRING) {
+            if (!compileTypeName(types)) {
+                return false;
+            }
+        } else if (type == TokenType::LEFT_BRACKET) {
+            if (tokens.type(++i) == TokenType::RIGHT_BRACKET) {
+                return fail(i);
+            }
+            do {
+                if (tokens.type(i) != TokenType::STRING) {
+                    return fail(i);
+                }
+                if (!compileTypeName(types)) {
+                    return false;
+                }
+            } while (tokens.type(i++) == TokenType::COMMA);
+        } else {
+            return fail(i);
+        }
+        schema.nodes[index].types = types;
+    } else if (keyword == "enum") {
+        return compileEnum(index);
+    } else if (keyword == "minimum" || keyword == "exclusiveMinimum" ||
+               keyword == "maximum" || keyword == "exclusiveMaximum") {
+        if (type != TokenType::NUMBER) {
+            return fail(i);
+        }
+        double bound = number(i++);
+        bool exclusive = keyword[0] == 'e';
+        SchemaNode& node = schema.nodes[index];
+
+        // Of two bounds on one side the tighter holds
+        if (keyword == "minimum" || keyword == "exclusiveMinimum") {
+            if (bound > node.minimum ||
+                (bound == node.minimum && exclusive)) {
+                node.minimum = bound;
+                node.exclusiveMinimum = exclusive;
+            }
+        } else if (bound < node.maximum ||
+                   (bound == node.maximum && exclusive)) {
+            node.maximum = bound;
+            node.exclusiveMaximum = exclusive;
+        }
+        node.checksNumber = true;
+    } else if (keyword == "minLength") {
+        return compileLength(schema.nodes[index].minLength);
+    } else if (keyword == "maxLength") {
+        return compileLength(schema.nodes[index].maxLength);
+    } else if (keyword == "items") {
+        if (!compileSchema(child)) {
+            return false;
+        }
+        schema.nodes[index].items = child;
+    } else if (keyword == "additionalProperties") {
+        if (!compileSchema(child)) {
+            return false;
+        }
+        schema.nodes[index].additional = child;
+    } else if (keyword == "properties") {
+        if (type != TokenType::LEFT_BRACE) {
+            return fail(i);
+        }
+        if (tokens.type(++i) == TokenType::RIGHT_BRACE) {
+            i++;
+            return true;
+        }
+        do {
+            std::string name = text(i);
+            i += 2;  // Key and colon
+            if (!compileSchema(child)) {
+                return false;
+            }
+            listed.push_back(
+                SchemaProperty{name, child, Schema::kNotRequired});
+        } while (tokens.type(i++) == TokenType::COMMA);
+    } else if (keyword == "required") {
+        if (type != TokenType::LEFT_BRACKET) {
+            return fail(i);
+        }
+        if (tokens.type(++i) == TokenType::RIGHT_BRACKET) {
+            i++;
+            return true;
+        }
+        do {
+            if (tokens.type(i) != TokenType::STRING) {
+                return fail(i);
+            }
+            required.push_back(text(i++));
+        } while (tokens.type(i++) == TokenType::COMMA);
+    } else if (keyword == "$schema" || keyword == "$id" ||
+               keyword == "$comment" || keyword == "title" ||
+               keyword == "description" || keyword == "default" ||
+               keyword == "examples") {
+        skipValue();
+    } else {
+        return fail(key);
+    }
+    return true;
+}
+
+// Adds the type named by the string at `i` to `types`
+bool SchemaCompiler::compileTypeName(uint8_t& types) {
+    std::string name = text(i);
+    if (name == "null") {
+        types |= ST_NULL;
+    } else if (name == "boolean") {
+        types |= ST_BOOLEAN;
+    } else if (name == "object") {
+        types |= ST_OBJECT;
+    } else if (name == "array") {
+        types |= ST_ARRAY;
+    } else if (name == "number") {
+        types |= ST_NUMBER;
+    } else if (name == "integer") {
+        types |= ST_INTEGER;
+    } else if (name == "string") {
+        types |= ST_STRING;
+    } else {
+        return fail(i);
+    }
+    i++;
+    return true;
+}
+
+bool SchemaCompiler::compileEnum(uint32_t index) {
+    if (tokens.type(i) != TokenType::LEFT_BRACKET) {
+        return fail(i);
+    }
+    SchemaNode& node = schema.nodes[index];
+    node.hasEnum = true;
+    node.firstEnum = static_cast<uint32_t>(schema.enumValues.size());
+    if (tokens.type(++i) == TokenType::RIGHT_BRACKET) {
+        i++;
+        return true;
+    }
+    do {
+        SchemaEnumValue value = {0, false, 0, std::string()};
+        switch (tokens.type(i)) {
+            case TokenType::STRING:
+                value.type = ST_STRING;
+                value.text = text(i);
+                break;
+            case TokenType::NUMBER:
+                value.type = ST_NUMBER;
+                value.number = number(i);
+                node.checksNumber = true;
+                break;
+            case TokenType::TRUE:
+            case TokenType::FALSE:
+                value.type = ST_BOOLEAN;
+                value.boolean = tokens.type(i) == TokenType::TRUE;
+                break;
+            case TokenType::NULL_TOKEN:
+                value.type = ST_NULL;
+                break;
+            default:
+                return fail(i);  // Objects and arrays are not supported
+        }
+        schema.enumValues.push_back(std::move(value));
+        node.enumCount++;
+        i++;
+    } while (tokens.type(i++) == TokenType::COMMA);
+    return true;
+}
+
+// A non-negative integer at `i`
+bool SchemaCompiler::compileLength(size_t& length) {
+    if (tokens.type(i) != TokenType::NUMBER) {
+        return fail(i);
+    }
+    const char* start = lexer.data() + tokens.offset(i);
+    const char* end = start;
+    matchNumber(end, lexer.data() + lexer.size());
+    int64_t value;
+    if (!parseInteger(start, end, value) || value < 0) {
+        return fail(i);
+    }
+    length = static_cast<size_t>(value);
+    i++;
+    return true;
+}
+
+ParseResult Schema::compile(const char* data, size_t size) {
+    clear();
+    Lexer lexer(data, size);
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    if (!result.ok()) {
+        return result;
+    }
+
+    Parser parser(std::move(tokens));
+    parser.checkDuplicateKeys(&lexer);
+    result = parser.tryParse();
+    if (!result.ok()) {
+        return result;
+    }
+
+    SchemaCompiler compiler = {lexer, parser.tokenBuffer(), *this, 0,
+                               ParseResult(), std::string()};
+    uint32_t node;
+    if (!compiler.compileSchema(node)) {
+        clear();
+        return compiler.error;
+    }
+    rootNode = node;
+    return result;
+}
+
+ParseResult Schema::compile(const std::string& json) {
+    return compile(json.data(), json.size());
+}
+
+ParseResult Schema::compileFile(const std::string& filePath) {
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        clear();
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    return compile(contents);
+}
+
+uint32_t Schema::findProperty(uint32_t node, StringRef key) const {
+    const SchemaNode& schemaNode = nodes[node];
+    for (uint32_t p = schemaNode.firstProperty;
+         p < schemaNode.firstProperty + schemaNode.propertyCount; p++) {
+        const std::string& name = properties[p].key;
+        if (name.size() == key.size &&
+            memcmp(name.data(), key.data, key.size) == 0) {
+            return p;
+        }
+    }
+    return kNoProperty;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "error.h"
+#include "string_ref.h"
+
+// Bits of SchemaNode::types, one per JSON Schema "type" name
+enum SchemaType : uint8_t {
+    ST_NULL = 1 << 0,
+    ST_BOOLEAN = 1 << 1,
+    ST_OBJECT = 1 << 2,
+    ST_ARRAY = 1 << 3,
+    ST_NUMBER = 1 << 4,
+    ST_INTEGER = 1 << 5,  // Numbers without a fractional part
+    ST_STRING = 1 << 6,
+    ST_ANY = 0x7f,
+};
+
+// One compiled (sub)schema. Nodes refer to each other by index; the
+// properties and enum values of a node are ranges of Schema's tables.
+struct SchemaNode {
+    uint8_t types;
+    bool hasEnum;
+    bool checksNumber;  // Has bounds, or a number among its enum values
+    bool checksLength;
+    bool exclusiveMinimum;
+    bool exclusiveMaximum;
+    double minimum;  // -inf and +inf when absent
+    double maximum;
+    size_t minLength;  // In code points
+    size_t maxLength;
+    uint32_t items;       // Node for array elements
+    uint32_t additional;  // Node for properties not listed
+    uint32_t firstProperty;
+    uint32_t propertyCount;
+    uint32_t requiredCount;
+    uint32_t firstEnum;
+    uint32_t enumCount;
+
+    SchemaNode();
+};
+
+// A key listed under "properties" or "required". Required ones are numbered
+// 0 to requiredCount - 1 within their node.
+struct SchemaProperty {
+    std::string key;  // Decoded
+    uint32_t node;
+    uint32_t required;  // Or kNotRequired
+};
+
+// A scalar listed under "enum". Numbers compare by value, so 1 matches 1.0.
+struct SchemaEnumValue {
+    uint8_t type;  // One SchemaType bit; ST_INTEGER is not used
+    bool boolean;
+    double number;
+    std::string text;  // Decoded string
+};
+
+// A subset of JSON Schema compiled ahead of time into a table of nodes,
+// checked by the Parser in the same pass as the syntax
+// (Parser::checkSchema(), Document::checkSchema()). The parse fails at the
+// first value that breaks it, without looking at the rest of the document.
+//
+// Supported keywords: type, enum (of scalars), minimum, maximum,
+// exclusiveMinimum and exclusiveMaximum (as numbers), minLength and
+// maxLength, items (one schema for every element), properties, required and
+// additionalProperties. true and false are schemas too. The annotations
+// $schema, $id, $comment, title, description, default and examples are
+// ignored. Any other keyword fails compile() with INVALID_SCHEMA rather
+// than being skipped, so a schema is never checked less strictly than it
+// reads.
+class Schema {
+   public:
+    static constexpr uint32_t kAny = 0;    // Node of the schema true
+    static constexpr uint32_t kNever = 1;  // Node of the schema false
+    static constexpr uint32_t kNotRequired = ~uint32_t(0);
+    static constexpr uint32_t kNoProperty = ~uint32_t(0);
+
+    // Accepts any document until compiled
+    Schema();
+
+    // Replaces this schema with the one in `data`. Fails with the Lexer's
+    // and Parser's errors for bad JSON, DUPLICATE_KEY for a repeated
+    // keyword, and INVALID_SCHEMA, at the offending token, for a keyword
+    // that is unsupported or has a value of the wrong kind.
+    ParseResult compile(const char* data, size_t size);
+    ParseResult compile(const std::string& json);
+    ParseResult compileFile(const std::string& filePath);
+
+    uint32_t root() const { return rootNode; }
+    size_t nodeCount() const { return nodes.size(); }
+
+    // The program the Parser runs
+    const SchemaNode& node(uint32_t index) const { return nodes[index]; }
+    const SchemaProperty& property(uint32_t index) const {
+        return properties[index];
+    }
+    const SchemaEnumValue& enumValue(uint32_t index) const {
+        return enumValues[index];
+    }
+
+    // Index of `key` among the properties of `node`, or kNoProperty
+    uint32_t findProperty(uint32_t node, StringRef key) const;
+
+   private:
+    std::vector<SchemaNode> nodes;
+    std::vector<SchemaProperty> properties;
+    std::vector<SchemaEnumValue> enumValues;
+    uint32_t rootNode;
+
+    friend struct SchemaCompiler;
+
+    void clear();
+};
@@ -0,0 +1,508 @@
+#include "shared_document.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "input.h"
+
+namespace {
+
+// Position named by a JSON Pointer step into an array of `size` elements:
+// decimal without leading zeros, or "-" for the end
+bool arrayIndex(const std::string& step, size_t size, size_t& index) {
+    if (step == "-") {
+        index = size;
+        return true;
+    }
+    if (step.empty() || step.size() > 19 ||
+        (step[0] == '0' && step.size() > 1)) {
+        return false;
+    }
+    index = 0;
+    for (char c : step) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        index = index * 10 + (c - '0');
+    }
+    return index <= size;
+}
+
+}  // namespace
+
+// A value that isn't on a tape: a scalar made with make*(), or a container
+// that was copied to be edited. A copied container's items still point at
+// the old version's children.
+struct SharedValue::Node {
+    ValueType type;
+    bool boolean;
+    int64_t integer;
+    double number;
+    std::string text;
+    std::vector<std::string> keys;  // One per item for objects
+    std::vector<SharedValue> items;
+
+    explicit Node(ValueType type)
+        : type(type), boolean(false), integer(0), number(0) {}
+};
+
+// One unescaped reference token of a JSON Pointer
+struct SharedValue::Step {
+    std::string key;
+    size_t offset;  // Of the '/' before it
+};
+
+ParseResult SharedValue::parse(const char* data, size_t size,
+                               SharedValue& value) {
+    std::shared_ptr<Document> parsed = std::make_shared<Document>();
+    ParseResult result = parsed->parse(data, size);
+    if (result.ok()) {
+        value = SharedValue(parsed, parsed->root());
+    }
+    return result;
+}
+
+ParseResult SharedValue::parse(const std::string& json, SharedValue& value) {
+    return parse(json.data(), json.size(), value);
+}
+
+SharedValue SharedValue::makeNull() {
+    return SharedValue(std::make_shared<Node>(ValueType::NULL_VALUE));
+}
+
+SharedValue SharedValue::makeBool(bool value) {
+    std::shared_ptr<Node> made = std::make_shared<Node>(ValueType::BOOLEAN);
+    made->boolean = value;
+    return SharedValue(made);
+}
+
+SharedValue SharedValue::makeInt64(int64_t value) {
+    std::shared_ptr<Node> made = std::make_shared<Node>(ValueType::INT64);
+    made->integer = value;
+    return SharedValue(made);
+}
+
+SharedValue SharedValue::makeDouble(double value) {
+    std::shared_ptr<Node> made = std::make_shared<Node>(ValueType::DOUBLE);
+    made->number = value;
+    return SharedValue(made);
+}
+
+SharedValue SharedValue::makeString(StringRef value) {
+    std::shared_ptr<Node> made = std::make_shared<Node>(ValueType::STRING);
+    made->text = value.str();
+    return SharedValue(made);
+}
+
+SharedValue SharedValue::makeArray() {
+    return SharedValue(std::make_shared<Node>(ValueType::ARRAY));
+}
+
+SharedValue SharedValue::makeObject() {
+    return SharedValue(std::make_shared<Node>(ValueType::OBJECT));
+}
+
+ValueType SharedValue::type() const {
+    return node ? node->type : tapeValue.type();
+}
+
+bool SharedValue::asBool() const {
+    if (!node) {
+        return tapeValue.asBool();
+    }
+    return node->type == ValueType::BOOLEAN && node->boolean;
+}
+
+int64_t SharedValue::asInt64() const {
+    if (!node) {
+        return tapeValue.asInt64();
+    }
+    return node->type == ValueType::INT64 ? node->integer : 0;
+}
+
+double SharedValue::asDouble() const {
+    if (!node) {
+        return tapeValue.asDouble();
+    }
+    switch (node->type) {
+        case ValueType::INT64:
+            return static_cast<double>(node->integer);
+        case ValueType::DOUBLE:
+            return node->number;
+        default:
+            return 0;
+    }
+}
+
+StringRef SharedValue::asString() const {
+    if (!node) {
+        return tapeValue.asString();
+    }
+    return node->type == ValueType::STRING ? StringRef(node->text)
+                                           : StringRef();
+}
+
+size_t SharedValue::size() const {
+    return node ? node->items.size() : tapeValue.size();
+}
+
+SharedValue SharedValue::operator[](size_t i) const {
+    if (!node) {
+        Value element = tapeValue[i];
+        return element.exists() ? SharedValue(document, element)
+                                : SharedValue();
+    }
+    if (node->type != ValueType::ARRAY || i >= node->items.size()) {
+        return SharedValue();
+    }
+    return node->items[i];
+}
+
+SharedValue SharedValue::operator[](StringRef key) const {
+    if (!node) {
+        Value member = tapeValue[key];
+        return member.exists() ? SharedValue(document, member) : SharedValue();
+    }
+    for (size_t i = 0; i < node->keys.size(); i++) {
+        if (StringRef(node->keys[i]) == key) {
+            return node->items[i];
+        }
+    }
+    return SharedValue();
+}
+
+SharedValue SharedValue::at(const std::string& pointer) const {
+    std::vector<Step> path;
+    if (!splitPointer(pointer, path).ok()) {
+        return SharedValue();
+    }
+    SharedValue current = *this;
+    for (const Step& step : path) {
+        size_t index;
+        if (current.isObject()) {
+            current = current[StringRef(step.key)];
+        } else if (current.isArray() &&
+                   arrayIndex(step.key, current.size(), index)) {
+            current = current[index];
+        } else {
+            return SharedValue();
+        }
+    }
+    return current;
+}
+
+SharedValue::Iterator SharedValue::begin() const {
+    if (!node) {
+        return Iterator(this, 0, tapeValue.begin());
+    }
+    return Iterator(this, 0, Value::Iterator(nullptr, 0, false));
+}
+
+SharedValue::Iterator SharedValue::end() const {
+    if (!node) {
+        return Iterator(this, 0, tapeValue.end());
+    }
+    return Iterator(this, node->items.size(),
+                    Value::Iterator(nullptr, 0, false));
+}
+
+StringRef SharedValue::Iterator::key() const {
+    const Node* container = parent->node.get();
+    if (!container) {
+        return tapeIt.key();
+    }
+    return container->type == ValueType::OBJECT
+               ? StringRef(container->keys[position])
+               : StringRef();
+}
+
+SharedValue SharedValue::Iterator::value() const {
+    if (!parent->node) {
+        return SharedValue(parent->document, tapeIt.value());
+    }
+    return parent->node->items[position];
+}
+
+SharedValue::Iterator& SharedValue::Iterator::operator++() {
+    if (parent->node) {
+        position++;
+    } else {
+        ++tapeIt;
+    }
+    return *this;
+}
+
+bool SharedValue::Iterator::operator==(const Iterator& other) const {
+    return position == other.position && tapeIt == other.tapeIt;
+}
+
+bool SharedValue::identical(const SharedValue& other) const {
+    if (node || other.node) {
+        return node == other.node;
+    }
+    return document == other.document &&
+           tapeValue.tapeIndex() == other.tapeValue.tapeIndex() &&
+           tapeValue.exists() == other.tapeValue.exists();
+}
+
+ParseResult SharedValue::set(const std::string& pointer,
+                             const SharedValue& value,
+                             SharedValue& updated) const {
+    return update(pointer, &value, updated);
+}
+
+ParseResult SharedValue::remove(const std::string& pointer,
+                                SharedValue& updated) const {
+    return update(pointer, nullptr, updated);
+}
+
+ParseResult SharedValue::splitPointer(const std::string& pointer,
+                                      std::vector<Step>& path) {
+    if (!pointer.empty() && pointer[0] != '/') {
+        return ParseResult(ErrorCode::INVALID_JSON_POINTER, 0);
+    }
+    size_t i = 0;
+    while (i < pointer.size()) {
+        // pointer[i] is the '/' starting a step
+        Step step;
+        step.offset = i;
+        for (i++; i < pointer.size() && pointer[i] != '/'; i++) {
+            if (pointer[i] != '~') {
+                step.key += pointer[i];
+                continue;
+            }
+            char escaped = i + 1 < pointer.size() ? pointer[i + 1] : '\0';
+            if (escaped != '0' && escaped != '1') {
+                return ParseResult(ErrorCode::INVALID_JSON_POINTER, i);
+            }
+            step.key += escaped == '0' ? '~' : '/';
+            i++;
+        }
+        path.push_back(std::move(step));
+    }
+    return ParseResult();
+}
+
+// A null `value` means remove
+ParseResult SharedValue::update(const std::string& pointer,
+                                const SharedValue* value,
+                                SharedValue& updated) const {
+    std::vector<Step> path;
+    ParseResult result = splitPointer(pointer, path);
+    if (!result.ok()) {
+        return result;
+    }
+    return update(path, 0, value, updated);
+}
+
+// Copies the container at this level, then recurses into the one child on
+// the path. Every other child of the copy is shared with this version.
+ParseResult SharedValue::update(const std::vector<Step>& path, size_t depth,
+                                const SharedValue* value,
+                                SharedValue& updated) const {
+    if (depth == path.size()) {
+        updated = value ? *value : SharedValue();
+        return ParseResult();
+    }
+    const Step& step = path[depth];
+    ParseResult notFound(ErrorCode::PATH_NOT_FOUND, step.offset);
+    bool last = depth + 1 == path.size();
+
+    size_t i = 0;
+    size_t count = size();
+    if (isObject()) {
+        Iterator it = begin();
+        while (it != end() && it.key() != StringRef(step.key)) {
+            ++it;
+            i++;
+        }
+    } else if (!isArray() || !arrayIndex(step.key, count, i)) {
+        return notFound;
+    }
+    bool adding = i == count;
+    if (adding && (!last || !value)) {
+        return notFound;
+    }
+
+    std::shared_ptr<Node> copy = copyContainer();
+    if (adding) {
+        if (copy->type == ValueType::OBJECT) {
+            copy->keys.push_back(step.key);
+        }
+        copy->items.push_back(*value);
+    } else if (last && !value) {
+        if (copy->type == ValueType::OBJECT) {
+            copy->keys.erase(copy->keys.begin() + i);
+        }
+        copy->items.erase(copy->items.begin() + i);
+    } else {
+        SharedValue child;
+        ParseResult result =
+            copy->items[i].update(path, depth + 1, value, child);
+        if (!result.ok()) {
+            return result;
+        }
+        copy->items[i] = child;
+    }
+    updated = SharedValue(std::shared_ptr<const Node>(copy));
+    return ParseResult();
+}
+
+// Shallow copy of this array or object: new key and item lists whose items
+// refer to the same children
+std::shared_ptr<SharedValue::Node> SharedValue::copyContainer() const {
+    if (node) {
+        return std::make_shared<Node>(*node);
+    }
+    std::shared_ptr<Node> copy = std::make_shared<Node>(tapeValue.type());
+    bool object = copy->type == ValueType::OBJECT;
+    copy->items.reserve(tapeValue.size());
+    for (Value::Iterator it = tapeValue.begin(); it != tapeValue.end(); ++it) {
+        if (object) {
+            copy->keys.push_back(it.key().str());
+        }
+        copy->items.push_back(SharedValue(document, it.value()));
+    }
+    return copy;
+}
+
+SharedDocument::SharedDocument() : version(new SharedValue()) {}
+
+SharedDocument::~SharedDocument() {
+    delete version.load();
+    for (const SharedValue* old : retired) {
+        delete old;
+    }
+    Hazard* hazard = hazards.load();
+    while (hazard) {
+        Hazard* next = hazard->next;
+        delete hazard;
+        hazard = next;
+    }
+}
+
+ParseResult SharedDocument::parse(const std::string& json) {
+    SharedValue root;
+    ParseResult result = SharedValue::parse(json, root);
+    if (result.ok()) {
+        publish(root);
+    }
+    return result;
+}
+
+ParseResult SharedDocument::parseFile(const std::string& filePath) {
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    return parse(contents);
+}
+
+SharedValue SharedDocument::current() const {
+    Hazard* hazard = claimHazard();
+    const SharedValue* seen = version.load();
+    while (true) {
+        hazard->version.store(seen);
+        // A writer that swapped after this check sees the hazard before it
+        // frees `seen`
+        const SharedValue* now = version.load();
+        if (now == seen) {
+            break;
+        }
+        seen = now;
+    }
+    SharedValue copy = *seen;
+    hazard->version.store(nullptr);
+    hazard->taken.store(false, std::memory_order_release);
+    return copy;
+}
+
+SharedDocument::Hazard* SharedDocument::claimHazard() const {
+    for (Hazard* hazard = hazards.load(std::memory_order_acquire); hazard;
+         hazard = hazard->next) {
+        if (!hazard->taken.load(std::memory_order_relaxed) &&
+            !hazard->taken.exchange(true, std::memory_order_acquire)) {
+            return hazard;
+        }
+    }
+    Hazard* hazard = new Hazard;
+    hazard->taken.store(true, std::memory_order_relaxed);
+    hazard->next = hazards.load(std::memory_order_relaxed);
+    while (!hazards.compare_exchange_weak(hazard->next, hazard,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    return hazard;
+}
+
+void SharedDocument::publish(const SharedValue& root) {
+    std::unique_ptr<const SharedValue> next(new SharedValue(root));
+    std::lock_guard<std::mutex> hold(writers);
+    install(std::move(next));
+}
+
+// Caller holds `writers`
+void SharedDocument::install(std::unique_ptr<const SharedValue> next) {
+    retired.reserve(retired.size() + 1);  // Nothing changes if this throws
+    retired.push_back(version.exchange(next.release()));
+    generation++;
+    reclaim();
+}
+
+// Frees the replaced versions that no reader is copying. Caller holds
+// `writers`.
+void SharedDocument::reclaim() {
+    size_t kept = 0;
+    for (const SharedValue* old : retired) {
+        bool guarded = false;
+        for (Hazard* hazard = hazards.load(); hazard && !guarded;
+             hazard = hazard->next) {
+            guarded = hazard->version.load() == old;
+        }
+        if (guarded) {
+            retired[kept++] = old;
+        } else {
+            delete old;
+        }
+    }
+    retired.resize(kept);
+}
+
+ParseResult SharedDocument::set(const std::string& pointer,
+                                const SharedValue& value) {
+    return apply(pointer, &value);
+}
+
+ParseResult SharedDocument::remove(const std::string& pointer) {
+    return apply(pointer, nullptr);
+}
+
+ParseResult SharedDocument::apply(const std::string& pointer,
+                                  const SharedValue* value) {
+    while (true) {
+        SharedValue old;
+        uint64_t base;
+        {
+            std::lock_guard<std::mutex> hold(writers);
+            old = *version.load();
+            base = generation;
+        }
+        SharedValue updated;
+        ParseResult result = value ? old.set(pointer, *value, updated)
+                                   : old.remove(pointer, updated);
+        if (!result.ok()) {
+            return result;
+        }
+        std::unique_ptr<const SharedValue> next(new SharedValue(updated));
+        std::lock_guard<std::mutex> hold(writers);
+        // Otherwise another writer got in first: rebuild from its version
+        if (generation == base) {
+            install(std::move(next));
+            return result;
+        }
+    }
+}
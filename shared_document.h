@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "error.h"
+#include "string_ref.h"
+
+// Immutable JSON value that any number of threads can read at once. Reads
+// take no locks, except that the first lookup in a large object on the tape
+// builds its ObjectIndex table under the index's lock (see object_index.h).
+// A parsed value stays on the tape of a reference-counted Document; every
+// SharedValue taken from it holds a reference, so the tape lives as long as
+// any of them. Values are never changed in place: set() and remove() return
+// a new version that copies only the containers on the path to the change,
+// one level at a time, and points at the same children as the old version
+// everywhere else. Updating one member of a large document costs the sizes
+// of the containers along the path, not the size of the document.
+//
+// Copying a SharedValue is cheap (one reference count). Handles may be
+// passed between threads freely; a handle is itself not synchronised, so
+// don't assign to one while another thread reads it. SharedDocument holds
+// the version that readers should see.
+class SharedValue {
+   public:
+    // Walks the elements of an array or the members of an object
+    class Iterator {
+       public:
+        StringRef key() const;  // Empty for arrays
+        SharedValue value() const;
+        SharedValue operator*() const { return value(); }
+
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+       private:
+        friend class SharedValue;
+
+        const SharedValue* parent;
+        size_t position;         // For edited containers
+        Value::Iterator tapeIt;  // For containers still on the tape
+
+        Iterator(const SharedValue* parent, size_t position,
+                 Value::Iterator tapeIt)
+            : parent(parent), position(position), tapeIt(tapeIt) {}
+    };
+
+    SharedValue() {}
+
+    // Parses `data` into a value backed by its own Document
+    static ParseResult parse(const char* data, size_t size,
+                             SharedValue& value);
+    static ParseResult parse(const std::string& json, SharedValue& value);
+
+    static SharedValue makeNull();
+    static SharedValue makeBool(bool value);
+    static SharedValue makeInt64(int64_t value);
+    static SharedValue makeDouble(double value);
+    static SharedValue makeString(StringRef value);
+    static SharedValue makeArray();   // Empty
+    static SharedValue makeObject();  // Empty
+
+    bool exists() const { return node != nullptr || tapeValue.exists(); }
+    ValueType type() const;
+
+    bool isNull() const { return exists() && type() == ValueType::NULL_VALUE; }
+    bool isObject() const { return exists() && type() == ValueType::OBJECT; }
+    bool isArray() const { return exists() && type() == ValueType::ARRAY; }
+
+    // Same conversions as Value
+    bool asBool() const;
+    int64_t asInt64() const;
+    double asDouble() const;
+    StringRef asString() const;
+
+    size_t size() const;
+    SharedValue operator[](size_t i) const;
+    SharedValue operator[](StringRef key) const;
+
+    // Value at a JSON Pointer (RFC 6901); missing if there is none
+    SharedValue at(const std::string& pointer) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Whether both handles refer to the same stored value, as unchanged
+    // parts of two versions do. Equal values stored twice are not the same.
+    bool identical(const SharedValue& other) const;
+
+    // Stores in `updated` a version of this value with the value at
+    // `pointer` replaced by `value`. The last step of the pointer may name a
+    // new object member, or the end of an array as "-" or its size, to add
+    // one. Fails with INVALID_JSON_POINTER, or with PATH_NOT_FOUND at the
+    // offset of the first step that leads nowhere.
+    ParseResult set(const std::string& pointer, const SharedValue& value,
+                    SharedValue& updated) const;
+
+    // Like set(), but drops the member or element at `pointer`. Removing
+    // the root gives a missing value.
+    ParseResult remove(const std::string& pointer, SharedValue& updated) const;
+
+   private:
+    struct Node;
+    struct Step;
+
+    std::shared_ptr<const Document> document;  // Owns tapeValue's tape
+    Value tapeValue;
+    std::shared_ptr<const Node> node;  // Built or edited values
+
+    SharedValue(const std::shared_ptr<const Document>& document, Value value)
+        : document(document), tapeValue(value) {}
+    explicit SharedValue(const std::shared_ptr<const Node>& node)
+        : node(node) {}
+
+    static ParseResult splitPointer(const std::string& pointer,
+                                    std::vector<Step>& path);
+    ParseResult update(const std::string& pointer, const SharedValue* value,
+                       SharedValue& updated) const;
+    ParseResult update(const std::vector<Step>& path, size_t depth,
+                       const SharedValue* value, SharedValue& updated) const;
+    std::shared_ptr<Node> copyContainer() const;
+};
+
+// The current version of a document, shared between threads. Readers call
+// current() and keep the handle for as long as they need a consistent view;
+// it never changes under them. current() takes no lock: the reader
+// announces the version it is about to copy in a hazard slot, checks that
+// it is still current, and copies the handle. A version that a writer
+// replaces is freed only once no hazard slot names it. A reader allocates a
+// slot only when more readers are inside current() than ever before.
+//
+// Writers build the next version off to the side and swap it in as a single
+// pointer under a writers' mutex, which readers never touch. set() and
+// remove() rebuild from the newer version if another writer got in first,
+// so no update is lost.
+class SharedDocument {
+   public:
+    SharedDocument();
+    ~SharedDocument();
+    SharedDocument(const SharedDocument&) = delete;
+    SharedDocument& operator=(const SharedDocument&) = delete;
+
+    // Parses a new document and publishes it. On failure the current
+    // version is kept.
+    ParseResult parse(const std::string& json);
+    ParseResult parseFile(const std::string& filePath);
+
+    SharedValue current() const;
+    void publish(const SharedValue& root);
+
+    // Applies SharedValue::set() or remove() to the current version and
+    // publishes the result
+    ParseResult set(const std::string& pointer, const SharedValue& value);
+    ParseResult remove(const std::string& pointer);
+
+   private:
+    // A reader's claim on the version it is copying
+    struct Hazard {
+        std::atomic<const SharedValue*> version{nullptr};
+        std::atomic<bool> taken{false};
+        Hazard* next = nullptr;
+    };
+
+    std::atomic<const SharedValue*> version;
+    mutable std::atomic<Hazard*> hazards{nullptr};  // Only ever grows
+    std::mutex writers;
+    uint64_t generation = 0;  // Swaps so far; guarded by `writers`
+    std::vector<const SharedValue*> retired;  // Guarded by `writers`
+
+    Hazard* claimHazard() const;
+    void install(std::unique_ptr<const SharedValue> next);
+    void reclaim();
+    ParseResult apply(const std::string& pointer, const SharedValue* value);
+};
@@ -0,0 +1,551 @@
+#include "shredder.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "char_class.h"
+#include "input.h"
+#include "lexer.h"
+#include "number.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+static const char kColumnMagic[8] = {'J', 'S', 'O', 'N', 'C', 'O', 'L', 'S'};
+static const uint32_t kColumnVersion = 2;
+
+static size_t bitmapBytes(size_t bits) { return (bits + 7) / 8; }
+
+// `value` as a JSON string literal
+static std::string quoteJson(StringRef value) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string quoted = "\"";
+    for (size_t i = 0; i < value.size; i++) {
+        unsigned char c = static_cast<unsigned char>(value.data[i]);
+        switch (c) {
+            case '"':
+                quoted += "\\\"";
+                break;
+            case '\\':
+                quoted += "\\\\";
+                break;
+            case '\n':
+                quoted += "\\n";
+                break;
+            case '\r':
+                quoted += "\\r";
+                break;
+            case '\t':
+                quoted += "\\t";
+                break;
+            default:
+                if (c < 0x20) {
+                    quoted += "\\u00";
+                    quoted += kHex[c >> 4];
+                    quoted += kHex[c & 15];
+                } else {
+                    quoted += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+// Shortest text that reads back as `value`. Numbers too large for a double
+// were read as infinity and are written as 1e999, which reads back the same.
+static std::string formatDouble(double value) {
+    if (std::isinf(value)) {
+        return value < 0 ? "-1e999" : "1e999";
+    }
+    char buffer[32];
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    return buffer;
+}
+
+void Column::setBit(std::vector<uint8_t>& bits, size_t i, bool value) {
+    if (bits.size() <= i / 8) {
+        bits.resize(i / 8 + 1, 0);
+    }
+    if (value) {
+        bits[i / 8] |= 1 << (i % 8);
+    } else {
+        bits[i / 8] &= ~(1 << (i % 8));
+    }
+}
+
+void Column::appendSlot(bool valid) {
+    setBit(validity, rows, valid);
+    nulls += valid ? 0 : 1;
+    rows++;
+}
+
+void Column::appendString(const char* data, size_t size) {
+    arena.insert(arena.end(), data, data + size);
+    offsets.push_back(arena.size());
+}
+
+void Column::appendNull() {
+    switch (columnType) {
+        case ColumnType::NULL_ONLY:
+            break;
+        case ColumnType::BOOL:
+            setBit(bools, rows, false);
+            break;
+        case ColumnType::INT64:
+            int64s.push_back(0);
+            break;
+        case ColumnType::DOUBLE:
+            doubles.push_back(0);
+            break;
+        case ColumnType::STRING:
+        case ColumnType::JSON:
+            offsets.push_back(arena.size());
+            break;
+    }
+    appendSlot(false);
+}
+
+void Column::padTo(size_t count) {
+    while (rows < count) {
+        appendNull();
+    }
+}
+
+void Column::append(const ShredValue& value) {
+    if (value.type == ColumnType::NULL_ONLY) {
+        appendNull();
+        return;
+    }
+
+    ColumnType target = ColumnType::JSON;
+    if (columnType == ColumnType::NULL_ONLY || columnType == value.type) {
+        target = value.type;
+    } else if ((columnType == ColumnType::INT64 &&
+                value.type == ColumnType::DOUBLE) ||
+               (columnType == ColumnType::DOUBLE &&
+                value.type == ColumnType::INT64)) {
+        target = ColumnType::DOUBLE;
+    }
+    widen(target);
+
+    switch (columnType) {
+        case ColumnType::NULL_ONLY:
+            break;
+        case ColumnType::BOOL:
+            setBit(bools, rows, value.boolean);
+            break;
+        case ColumnType::INT64:
+            int64s.push_back(value.integer);
+            break;
+        case ColumnType::DOUBLE:
+            doubles.push_back(value.type == ColumnType::INT64
+                                  ? static_cast<double>(value.integer)
+                                  : value.number);
+            break;
+        case ColumnType::STRING:
+            appendString(value.text.data, value.text.size);
+            break;
+        case ColumnType::JSON:
+            appendString(value.json.data, value.json.size);
+            break;
+    }
+    appendSlot(true);
+}
+
+// JSON text of a non-null row, for widening to JSON
+std::string Column::jsonText(size_t row) const {
+    switch (columnType) {
+        case ColumnType::BOOL:
+            return boolAt(row) ? "true" : "false";
+        case ColumnType::INT64:
+            return std::to_string(int64At(row));
+        case ColumnType::DOUBLE:
+            return formatDouble(doubleAt(row));
+        case ColumnType::STRING:
+            return quoteJson(stringAt(row));
+        default:
+            return "";
+    }
+}
+
+void Column::widen(ColumnType type) {
+    if (type == columnType) {
+        return;
+    }
+
+    if (columnType == ColumnType::NULL_ONLY) {
+        // Every existing row is null
+        switch (type) {
+            case ColumnType::BOOL:
+                bools.assign(bitmapBytes(rows), 0);
+                break;
+            case ColumnType::INT64:
+                int64s.assign(rows, 0);
+                break;
+            case ColumnType::DOUBLE:
+                doubles.assign(rows, 0);
+                break;
+            default:
+                offsets.assign(rows + 1, 0);
+                break;
+        }
+    } else if (columnType == ColumnType::INT64 &&
+               type == ColumnType::DOUBLE) {
+        doubles.assign(int64s.begin(), int64s.end());
+        std::vector<int64_t>().swap(int64s);
+    } else {
+        // Anything else is rewritten as JSON text
+        std::vector<uint64_t> textOffsets(1, 0);
+        std::vector<char> textArena;
+        for (size_t row = 0; row < rows; row++) {
+            if (!isNull(row)) {
+                std::string value = jsonText(row);
+                textArena.insert(textArena.end(), value.begin(), value.end());
+            }
+            textOffsets.push_back(textArena.size());
+        }
+        std::vector<uint8_t>().swap(bools);
+        std::vector<int64_t>().swap(int64s);
+        std::vector<double>().swap(doubles);
+        offsets.swap(textOffsets);
+        arena.swap(textArena);
+    }
+    columnType = type;
+}
+
+ParseResult Shredder::addRecord(const char* data, size_t size) {
+    Lexer lexer(data, size);
+    lexer.predictKeys(&shapes);
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    if (!result.ok()) {
+        return result;
+    }
+
+    Parser parser(std::move(tokens));
+    result = parser.tryParse();
+    if (!result.ok()) {
+        return result;
+    }
+
+    path.clear();
+    size_t i = 0;
+    shredValue(lexer, parser.tokenBuffer(), i);
+
+    rows++;
+    for (Column& column : columns) {
+        column.padTo(rows);
+    }
+    return result;
+}
+
+// Walks the value starting at token `i` of an accepted token stream,
+// leaving `i` past it
+void Shredder::shredValue(const Lexer& lexer, const TokenBuffer& tokens,
+                          size_t& i) {
+    ShredValue value;
+    switch (tokens.type(i)) {
+        case TokenType::LEFT_BRACE: {
+            if (tokens.type(++i) == TokenType::RIGHT_BRACE) {
+                i++;
+                return;
+            }
+            while (true) {
+                // Extend the path with the key, escaped as in a JSON Pointer
+                size_t parent = path.size();
+                path += '/';
+                StringRef key = lexer.string(tokens, i, scratch);
+                for (size_t k = 0; k < key.size; k++) {
+                    char c = key.data[k];
+                    if (c == '~') {
+                        path += "~0";
+                    } else if (c == '/') {
+                        path += "~1";
+                    } else {
+                        path += c;
+                    }
+                }
+                i += 2;  // Key and colon
+                shredValue(lexer, tokens, i);
+                path.resize(parent);
+
+                if (tokens.type(i++) == TokenType::RIGHT_BRACE) {
+                    return;
+                }
+            }
+        }
+        case TokenType::LEFT_BRACKET: {
+            // Arrays are kept whole, as their JSON text
+            size_t start = i;
+            size_t depth = 0;
+            do {
+                TokenType type = tokens.type(i++);
+                if (type == TokenType::LEFT_BRACE ||
+                    type == TokenType::LEFT_BRACKET) {
+                    depth++;
+                } else if (type == TokenType::RIGHT_BRACE ||
+                           type == TokenType::RIGHT_BRACKET) {
+                    depth--;
+                }
+            } while (depth > 0);
+            value.type = ColumnType::JSON;
+            value.json = StringRef(lexer.data() + tokens.offset(start),
+                                   tokens.offset(i - 1) + 1 -
+                                       tokens.offset(start));
+            break;
+        }
+        case TokenType::STRING: {
+            StringRef body = lexer.rawString(tokens, i);
+            value.type = ColumnType::STRING;
+            value.json = StringRef(body.data - 1, body.size + 2);
+            value.text = lexer.string(tokens, i++, scratch);
+            break;
+        }
+        case TokenType::NUMBER: {
+            const char* start = lexer.data() + tokens.offset(i++);
+            const char* end = start;
+            matchNumber(end, lexer.data() + lexer.size());
+            value.json = StringRef(start, end - start);
+            if (parseInteger(start, end, value.integer)) {
+                value.type = ColumnType::INT64;
+            } else {
+                value.type = ColumnType::DOUBLE;
+                value.number = parseDouble(start, end);
+            }
+            break;
+        }
+        case TokenType::TRUE:
+        case TokenType::FALSE:
+            value.type = ColumnType::BOOL;
+            value.boolean = tokens.type(i++) == TokenType::TRUE;
+            value.json = value.boolean ? "true" : "false";
+            break;
+        default:  // NULL_TOKEN
+            i++;
+            break;
+    }
+    emit(value);
+}
+
+void Shredder::emit(const ShredValue& value) {
+    size_t index;
+    auto found = columnIndex.find(path);
+    if (found == columnIndex.end()) {
+        index = columns.size();
+        columns.push_back(Column(path));
+        columnIndex[path] = index;
+    } else {
+        index = found->second;
+    }
+
+    Column& column = columns[index];
+    if (column.size() > rows) {
+        return;  // Duplicate key: the first value wins
+    }
+    column.padTo(rows);
+    column.append(value);
+}
+
+ParseResult Shredder::addLines(const char* data, size_t size) {
+    return forEachRecord(data, size, [this](const char* line, size_t length) {
+        return addRecord(line, length);
+    });
+}
+
+ParseResult Shredder::addFile(const std::string& filePath) {
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    return addLines(contents.data(), contents.size());
+}
+
+const Column* Shredder::find(const std::string& path) const {
+    auto found = columnIndex.find(path);
+    return found == columnIndex.end() ? nullptr : &columns[found->second];
+}
+
+void Shredder::clear() {
+    columns.clear();
+    columnIndex.clear();
+    rows = 0;
+    shapes.clear();
+}
+
+namespace {
+
+// Appends fixed-size fields and buffers to the output file
+struct ColumnWriter {
+    FILE* file;
+    bool ok;
+
+    void bytes(const void* data, size_t size) {
+        ok = ok && (size == 0 || fwrite(data, 1, size, file) == size);
+    }
+    template <typename T>
+    void value(T field) {
+        bytes(&field, sizeof(field));
+    }
+    // Bitmaps are written at their full size even if trailing bytes were
+    // never touched
+    void bitmap(const std::vector<uint8_t>& bits, size_t count) {
+        std::vector<uint8_t> padded(bits);
+        padded.resize(bitmapBytes(count), 0);
+        bytes(padded.data(), padded.size());
+    }
+};
+
+// Reads the same layout back, failing on anything out of bounds
+struct ColumnReader {
+    const char* p;
+    const char* end;
+
+    bool bytes(void* data, size_t size) {
+        if (size > size_t(end - p)) {
+            return false;
+        }
+        memcpy(data, p, size);
+        p += size;
+        return true;
+    }
+    template <typename T>
+    bool value(T& field) {
+        return bytes(&field, sizeof(field));
+    }
+    template <typename T>
+    bool vector(std::vector<T>& out, size_t count) {
+        if (count > size_t(end - p) / sizeof(T)) {
+            return false;
+        }
+        out.resize(count);
+        return bytes(out.data(), count * sizeof(T));
+    }
+};
+
+}  // namespace
+
+ParseResult Shredder::write(const std::string& filePath) const {
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (file == nullptr) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+
+    ColumnWriter out = {file, true};
+    out.bytes(kColumnMagic, sizeof(kColumnMagic));
+    out.value<uint32_t>(kColumnVersion);
+    out.value<uint32_t>(columns.size());
+    out.value<uint64_t>(rows);
+    for (const Column& column : columns) {
+        out.value<uint32_t>(column.columnName.size());
+        out.bytes(column.columnName.data(), column.columnName.size());
+        out.value<uint8_t>(static_cast<uint8_t>(column.columnType));
+        out.bitmap(column.validity, rows);
+        switch (column.columnType) {
+            case ColumnType::NULL_ONLY:
+                break;
+            case ColumnType::BOOL:
+                out.bitmap(column.bools, rows);
+                break;
+            case ColumnType::INT64:
+                out.bytes(column.int64s.data(), rows * sizeof(int64_t));
+                break;
+            case ColumnType::DOUBLE:
+                out.bytes(column.doubles.data(), rows * sizeof(double));
+                break;
+            case ColumnType::STRING:
+            case ColumnType::JSON:
+                out.bytes(column.offsets.data(),
+                          (rows + 1) * sizeof(uint64_t));
+                out.bytes(column.arena.data(), column.arena.size());
+                break;
+        }
+    }
+
+    if (fclose(file) != 0 || !out.ok) {
+        return ParseResult(ErrorCode::CANNOT_WRITE_FILE, 0);
+    }
+    return ParseResult();
+}
+
+ParseResult Shredder::read(const std::string& filePath) {
+    clear();
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+
+    const ParseResult invalid(ErrorCode::INVALID_COLUMN_FILE, 0);
+    ColumnReader in = {contents.data(), contents.data() + contents.size()};
+    char magic[sizeof(kColumnMagic)];
+    uint32_t version;
+    uint32_t count;
+    uint64_t rowCount;
+    if (!in.bytes(magic, sizeof(magic)) ||
+        memcmp(magic, kColumnMagic, sizeof(magic)) != 0 ||
+        !in.value(version) || version != kColumnVersion ||
+        !in.value(count) || !in.value(rowCount)) {
+        return invalid;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t nameLength;
+        std::vector<char> name;
+        uint8_t type;
+        if (!in.value(nameLength) || !in.vector(name, nameLength) ||
+            !in.value(type) || type > uint8_t(ColumnType::JSON)) {
+            clear();
+            return invalid;
+        }
+
+        Column column(std::string(name.begin(), name.end()));
+        column.columnType = static_cast<ColumnType>(type);
+        column.rows = rowCount;
+        bool ok = in.vector(column.validity, bitmapBytes(rowCount));
+        switch (column.columnType) {
+            case ColumnType::NULL_ONLY:
+                break;
+            case ColumnType::BOOL:
+                ok = ok && in.vector(column.bools, bitmapBytes(rowCount));
+                break;
+            case ColumnType::INT64:
+                ok = ok && in.vector(column.int64s, rowCount);
+                break;
+            case ColumnType::DOUBLE:
+                ok = ok && in.vector(column.doubles, rowCount);
+                break;
+            case ColumnType::STRING:
+            case ColumnType::JSON:
+                ok = ok && in.vector(column.offsets, rowCount + 1) &&
+                     column.offsets[0] == 0;
+                for (size_t row = 0; ok && row < rowCount; row++) {
+                    ok = column.offsets[row] <= column.offsets[row + 1];
+                }
+                ok = ok && in.vector(column.arena, column.offsets[rowCount]);
+                break;
+        }
+        if (!ok) {
+            clear();
+            return invalid;
+        }
+        for (size_t row = 0; row < rowCount; row++) {
+            column.nulls += column.isNull(row) ? 1 : 0;
+        }
+
+        columnIndex[column.columnName] = columns.size();
+        columns.push_back(std::move(column));
+    }
+    rows = rowCount;
+    return ParseResult();
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "key_shapes.h"
+#include "string_ref.h"
+
+class Lexer;
+class TokenBuffer;
+
+// Column types ordered by how they widen: NULL_ONLY takes the type of the
+// first value, INT64 widens to DOUBLE, and any other mix becomes JSON. A
+// STRING column holds decoded strings; a JSON column holds the JSON text of
+// each value, so the string "42" stays distinct from the number 42.
+enum class ColumnType : uint8_t {
+    NULL_ONLY,
+    BOOL,
+    INT64,
+    DOUBLE,
+    STRING,
+    JSON,
+};
+
+// One value taken from a record: a scalar, or an array kept whole as JSON.
+// `text` is the decoded value of a string; `json` is the value's text as it
+// appears in the record, quotes and escapes included.
+struct ShredValue {
+    ColumnType type;
+    bool boolean;
+    int64_t integer;
+    double number;
+    StringRef text;
+    StringRef json;
+
+    ShredValue() : type(ColumnType::NULL_ONLY), boolean(false), integer(0),
+                   number(0) {}
+};
+
+// Typed values of one path across all records. Buffers are laid out for
+// vectorized consumers: fixed-width arrays for numbers, LSB-first bitmaps
+// for booleans and validity, and, for STRING and JSON columns, a string
+// arena indexed by size() + 1 offsets. Null rows hold 0, false or an empty
+// string.
+class Column {
+   public:
+    explicit Column(const std::string& name)
+        : columnName(name), columnType(ColumnType::NULL_ONLY), rows(0),
+          nulls(0) {}
+
+    const std::string& name() const { return columnName; }
+    ColumnType type() const { return columnType; }
+    size_t size() const { return rows; }
+    size_t nullCount() const { return nulls; }
+
+    bool isNull(size_t row) const { return !getBit(validity, row); }
+    bool boolAt(size_t row) const { return getBit(bools, row); }
+    int64_t int64At(size_t row) const { return int64s[row]; }
+    double doubleAt(size_t row) const { return doubles[row]; }
+    StringRef stringAt(size_t row) const {
+        return StringRef(arena.data() + offsets[row],
+                         offsets[row + 1] - offsets[row]);
+    }
+
+    const std::vector<uint8_t>& validityBitmap() const { return validity; }
+    const std::vector<uint8_t>& boolBitmap() const { return bools; }
+    const std::vector<int64_t>& int64Values() const { return int64s; }
+    const std::vector<double>& doubleValues() const { return doubles; }
+    const std::vector<uint64_t>& stringOffsets() const { return offsets; }
+    const std::vector<char>& stringArena() const { return arena; }
+
+   private:
+    friend class Shredder;
+
+    std::string columnName;
+    ColumnType columnType;
+    size_t rows;
+    size_t nulls;
+    std::vector<uint8_t> validity;
+    std::vector<uint8_t> bools;
+    std::vector<int64_t> int64s;
+    std::vector<double> doubles;
+    std::vector<uint64_t> offsets;
+    std::vector<char> arena;
+
+    static bool getBit(const std::vector<uint8_t>& bits, size_t i) {
+        return (bits[i / 8] >> (i % 8)) & 1;
+    }
+    static void setBit(std::vector<uint8_t>& bits, size_t i, bool value);
+
+    void append(const ShredValue& value);
+    void appendNull();
+    void padTo(size_t count);
+    void widen(ColumnType type);
+    void appendSlot(bool valid);
+    void appendString(const char* data, size_t size);
+    std::string jsonText(size_t row) const;
+};
+
+// Turns JSON records into columns, one per leaf path, named by JSON Pointer
+// ("/user/name"). Each record is checked by the Lexer and Parser and then
+// shredded straight from its token stream, so no document tree is built.
+// Arrays are not split into columns; they are stored as their JSON text in a
+// JSON column. Columns are created as new paths appear, with nulls for
+// earlier records, and widened when a value doesn't fit their type. Values
+// added to a JSON column keep their text from the record; rows converted when
+// a column widens are written out again, with doubles in the shortest form
+// that reads back as the same number. Rows usually share one layout, so each
+// record's keys are checked against those of the rows before it (KeyShapes)
+// before they are scanned.
+class Shredder {
+   public:
+    Shredder() : rows(0) {}
+
+    // Adds one record as a row. An invalid record adds nothing.
+    ParseResult addRecord(const char* data, size_t size);
+
+    // Adds each non-blank line as a record; stops at the first invalid one.
+    // Error offsets are relative to `data`.
+    ParseResult addLines(const char* data, size_t size);
+    ParseResult addFile(const std::string& filePath);
+
+    size_t rowCount() const { return rows; }
+    size_t columnCount() const { return columns.size(); }
+    const Column& column(size_t i) const { return columns[i]; }
+    const Column* find(const std::string& path) const;
+
+    // The layout learned across rows, with how many keys it predicted
+    const KeyShapes& keyShapes() const { return shapes; }
+
+    // Columnar file: a header, then each column's name, type, validity
+    // bitmap and value buffers
+    ParseResult write(const std::string& filePath) const;
+    ParseResult read(const std::string& filePath);
+
+    void clear();
+
+   private:
+    std::vector<Column> columns;
+    std::unordered_map<std::string, size_t> columnIndex;
+    size_t rows;
+    KeyShapes shapes;
+
+    // Per-record scratch
+    std::string path;
+    std::string scratch;
+
+    void shredValue(const Lexer& lexer, const TokenBuffer& tokens,
+                    size_t& i);
+    void emit(const ShredValue& value);
+};
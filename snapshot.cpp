@@ -0,0 +1,260 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tape.h"
+
+namespace {
+
+const char kMagic[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+const uint32_t kByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t tapeWords;
+    uint64_t stringBytes;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+// Keeps the tape 8-byte aligned within the page-aligned mapping
+static_assert(sizeof(SnapshotHeader) % sizeof(uint64_t) == 0,
+              "header must preserve tape alignment");
+
+// Word-at-a-time multiplicative hash; fast enough to check a large snapshot
+// at memory bandwidth
+uint64_t checksumBytes(const char* data, size_t size, uint64_t hash) {
+    const uint64_t prime = 0x100000001B3ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+}
+
+uint64_t checksumView(const DocumentView& view) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = checksumBytes(reinterpret_cast<const char*>(view.tape),
+                         view.tapeSize * sizeof(uint64_t), hash);
+    return checksumBytes(view.strings, view.stringsSize, hash);
+}
+
+// Checks that every link on the tape stays inside the sections, so that
+// Values read from a damaged file never go out of bounds: containers nest,
+// point at each other and hold as many members as they say; numbers have
+// their second word; object keys are strings; and each string entry,
+// NUL included, fits in the string area. One pass over the tape, reading
+// only the lengths of strings.
+bool checkTape(const DocumentView& view) {
+    struct Open {
+        size_t start;
+        size_t count;
+    };
+    std::vector<Open> open;
+    bool wantKey = false;  // Inside an object, between members
+    size_t i = 0;
+    do {
+        if (i >= view.tapeSize) {
+            return false;
+        }
+        uint64_t word = view.tape[i];
+        TapeTag tag = tapeTag(word);
+        bool inObject = !open.empty() &&
+                        tapeTag(view.tape[open.back().start]) ==
+                            TAPE_OBJECT_START;
+
+        if (tag == TAPE_OBJECT_END || tag == TAPE_ARRAY_END) {
+            if (open.empty() || (inObject && !wantKey)) {
+                return false;
+            }
+            Open closed = open.back();
+            uint64_t start = view.tape[closed.start];
+            TapeTag startTag = tag == TAPE_OBJECT_END ? TAPE_OBJECT_START
+                                                      : TAPE_ARRAY_START;
+            if (tapeTag(start) != startTag ||
+                tapePayload(word) != closed.start ||
+                tapeContainerEnd(start) != i ||
+                tapeContainerCount(start) !=
+                    std::min<size_t>(closed.count, kTapeCountSaturated)) {
+                return false;
+            }
+            open.pop_back();
+            wantKey = !open.empty() && tapeTag(view.tape[open.back().start]) ==
+                                           TAPE_OBJECT_START;
+            i++;
+            continue;
+        }
+
+        if (wantKey && tag != TAPE_STRING) {
+            return false;
+        }
+        if (!open.empty() && (!inObject || wantKey)) {
+            open.back().count++;
+        }
+
+        switch (tag) {
+            case TAPE_OBJECT_START:
+            case TAPE_ARRAY_START:
+                open.push_back(Open{i, 0});
+                wantKey = tag == TAPE_OBJECT_START;
+                i++;
+                continue;
+            case TAPE_STRING: {
+                uint64_t offset = tapePayload(word);
+                uint32_t length;
+                if (offset > view.stringsSize ||
+                    view.stringsSize - offset < sizeof(length)) {
+                    return false;
+                }
+                memcpy(&length, view.strings + offset, sizeof(length));
+                size_t end = offset + sizeof(length) + length;
+                if (length >= view.stringsSize - offset - sizeof(length) ||
+                    view.strings[end] != '\0') {
+                    return false;
+                }
+                i++;
+                break;
+            }
+            case TAPE_INT64:
+            case TAPE_DOUBLE:
+                i += 2;
+                break;
+            case TAPE_TRUE:
+            case TAPE_FALSE:
+            case TAPE_NULL:
+                i++;
+                break;
+            default:
+                return false;
+        }
+        // A key is followed by its value; a value by the next key
+        wantKey = inObject && !wantKey;
+    } while (!open.empty());
+    return i == view.tapeSize;
+}
+
+}  // namespace
+
+const uint32_t Snapshot::kVersion;
+
+Snapshot::Snapshot() : mapping(nullptr), mappedSize(0), checksum(0) {}
+
+Snapshot::~Snapshot() { close(); }
+
+ParseResult Snapshot::write(const DocumentView& document,
+                            const std::string& filePath) {
+    SnapshotHeader header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.tapeWords = document.tapeSize;
+    header.stringBytes = document.stringsSize;
+    header.checksum = checksumView(document);
+    header.reserved = 0;
+
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (file == nullptr) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    bool written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(document.tape, sizeof(uint64_t), document.tapeSize, file) ==
+            document.tapeSize &&
+        fwrite(document.strings, 1, document.stringsSize, file) ==
+            document.stringsSize;
+    if (fclose(file) != 0 || !written) {
+        return ParseResult(ErrorCode::CANNOT_WRITE_FILE, 0);
+    }
+    return ParseResult();
+}
+
+ParseResult Snapshot::open(const std::string& filePath) {
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return ParseResult(ErrorCode::INVALID_SNAPSHOT, 0);
+    }
+
+    size_t size = info.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (data == MAP_FAILED) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    mapping = data;
+    mappedSize = size;
+
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.byteOrder != kByteOrderMark) {
+        close();
+        return ParseResult(ErrorCode::INVALID_SNAPSHOT, 0);
+    }
+    if (header.version != kVersion) {
+        close();
+        return ParseResult(ErrorCode::SNAPSHOT_VERSION_MISMATCH, 0);
+    }
+    size_t sections = size - sizeof(header);
+    if (header.tapeWords > sections / sizeof(uint64_t) ||
+        header.stringBytes !=
+            sections - header.tapeWords * sizeof(uint64_t)) {
+        close();
+        return ParseResult(ErrorCode::INVALID_SNAPSHOT, 0);
+    }
+
+    const char* base = static_cast<const char*>(data);
+    tapeView.tape = reinterpret_cast<const uint64_t*>(base + sizeof(header));
+    tapeView.tapeSize = header.tapeWords;
+    tapeView.strings = base + sizeof(header) +
+                       header.tapeWords * sizeof(uint64_t);
+    tapeView.stringsSize = header.stringBytes;
+    tapeView.objectIndex = &keyIndex;
+    checksum = header.checksum;
+    return ParseResult();
+}
+
+void Snapshot::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedSize);
+    }
+    mapping = nullptr;
+    mappedSize = 0;
+    checksum = 0;
+    keyIndex.clear();
+    tapeView = DocumentView();
+}
+
+bool Snapshot::verify() const {
+    return mapping != nullptr && checksumView(tapeView) == checksum &&
+           (tapeView.tapeSize == 0 || checkTape(tapeView));
+}
+
+Value Snapshot::root() const {
+    return empty() ? Value() : Value(&tapeView, 0);
+}
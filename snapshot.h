@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "document.h"
+#include "error.h"
+
+// Binary snapshot of a parsed document: a fixed header followed by the tape
+// words and the string area, exactly as they are laid out in memory. Since
+// the tape holds only indices and offsets, a snapshot is mapped read-only and
+// navigated in place, with no parsing and no allocation.
+//
+// The header records a format version, the byte order of the writer, the
+// section sizes and a checksum of both sections. open() checks only the
+// header and that the sections fit in the file, in constant time, and then
+// trusts the tape. Call verify() before reading a snapshot that may be
+// damaged: it makes one pass over the tape to check that every container
+// link and string offset stays inside the file, and recomputes the
+// checksum.
+class Snapshot {
+   public:
+    static const uint32_t kVersion = 1;
+
+    Snapshot();
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Writes `document` to `filePath`
+    static ParseResult write(const DocumentView& document,
+                             const std::string& filePath);
+
+    // Maps `filePath`, replacing any snapshot already open. Fails with
+    // INVALID_SNAPSHOT when the header is broken or the file is too short
+    // for the sections it describes.
+    ParseResult open(const std::string& filePath);
+    void close();
+
+    // Checks the tape's structure and the checksum of the mapped sections.
+    // O(size of the snapshot); Values of a snapshot that fails may read out
+    // of bounds.
+    bool verify() const;
+
+    bool empty() const { return tapeView.tapeSize == 0; }
+    Value root() const;
+    const DocumentView& view() const { return tapeView; }
+    size_t fileSize() const { return mappedSize; }
+
+   private:
+    void* mapping;
+    size_t mappedSize;
+    uint64_t checksum;
+    ObjectIndex keyIndex;  // Built in memory, never written
+    DocumentView tapeView;
+};
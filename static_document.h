@@ -0,0 +1,517 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "char_class.h"
+#include "document.h"
+#include "error.h"
+#include "number.h"
+#include "string_ref.h"
+#include "tape.h"
+#include "token.h"
+
+// Compile-time parsing of JSON string literals, for configs and schemas
+// embedded in a binary. The Lexer and Parser grammar is run as a constant
+// expression and writes the same tape and string area as Document (see
+// tape.h) into arrays sized for the literal, so the result is read with the
+// usual Value API and costs nothing at startup:
+//
+//     STATIC_JSON_DOCUMENT(kDefaults, R"({"port": 8080, "hosts": ["a"]})");
+//     int64_t port = kDefaults.root()["port"].asInt64();
+//
+// A malformed literal fails the build. Errors are the ones Document::parse()
+// reports, at the same offsets; staticLayout() returns them for a closer
+// look. Large objects are not indexed, so key lookups scan them linearly.
+// Constant evaluation is slow and bounded: with GCC's default
+// -fconstexpr-ops-limit a literal can be around 100 KB, and one that size
+// adds tens of seconds to the build. Nesting is bounded by -fconstexpr-depth
+// to a few hundred levels.
+
+// Tape and string area sizes needed by a literal, and whether it parses
+struct StaticLayout {
+    ParseResult result;
+    size_t tapeSize;
+    size_t stringsSize;
+};
+
+// Parses a literal in a constant expression. run() checks the input with
+// the Lexer's rules, then parses it with the Parser's and writes the tape as
+// it goes. With null output arrays it only measures.
+class StaticParser {
+   public:
+    constexpr StaticParser(const char* data, size_t size, uint64_t* tape,
+                           size_t tapeCapacity, char* strings,
+                           size_t stringsCapacity)
+        : data(data),
+          size(size),
+          current(0),
+          tape(tape),
+          tapeCapacity(tapeCapacity),
+          tapeSize(0),
+          strings(strings),
+          stringsCapacity(stringsCapacity),
+          stringsSize(0),
+          error() {}
+
+    // Lexes everything first, like Lexer::tryTokenize(), so lexical errors
+    // win over grammar errors earlier in the input
+    constexpr ParseResult run() {
+        if (check()) {
+            current = 0;
+            if (parseValue() && nextToken() && current < size) {
+                fail(ErrorCode::EXPECTED_END_OF_INPUT);
+            }
+        }
+        return error;
+    }
+
+    constexpr size_t tapeWords() const { return tapeSize; }
+    constexpr size_t stringBytes() const { return stringsSize; }
+
+   private:
+    const char* data;
+    size_t size;
+    size_t current;  // Offset of the next token once nextToken() succeeds
+    uint64_t* tape;
+    size_t tapeCapacity;
+    size_t tapeSize;
+    char* strings;
+    size_t stringsCapacity;
+    size_t stringsSize;
+    ParseResult error;
+
+    // Lexer rules
+
+    constexpr bool check() {
+        if (size == 0) {
+            return lexFail(ErrorCode::EMPTY_INPUT, 0);
+        }
+        for (size_t i = 0; i < size;) {
+            size_t length = utf8SequenceLength(data + i, size - i);
+            if (length == 0) {
+                return lexFail(ErrorCode::INVALID_UTF8, i);
+            }
+            i += length;
+        }
+        for (current = 0; current < size;) {
+            if (!checkToken()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool checkToken() {
+        const char* end = data + size;
+        switch (charClass(data[current])) {
+            case CC_WHITESPACE:
+            case CC_LEFT_BRACE:
+            case CC_RIGHT_BRACE:
+            case CC_LEFT_BRACKET:
+            case CC_RIGHT_BRACKET:
+            case CC_COLON:
+            case CC_COMMA:
+                current++;
+                return true;
+            case CC_QUOTE:
+                return checkString();
+            case CC_NUMBER: {
+                const char* p = data + current;
+                NumberState state = matchNumber(p, end);
+                current = p - data;
+                return state == NS_DONE ||
+                       lexFail(numberError(state), current);
+            }
+            case CC_TRUE:
+                return checkLiteral("true", 4);
+            case CC_FALSE:
+                return checkLiteral("false", 5);
+            case CC_NULL:
+                return checkLiteral("null", 4);
+            default:
+                return lexFail(ErrorCode::INVALID_CHARACTER, current,
+                               data[current]);
+        }
+    }
+
+    constexpr bool checkString() {
+        for (current++; current < size; current++) {
+            switch (stringCharClass(data[current])) {
+                case SC_PLAIN:
+                    break;
+                case SC_QUOTE:
+                    current++;
+                    return true;
+                case SC_BACKSLASH:
+                    if (!checkEscape()) {
+                        return false;
+                    }
+                    break;
+                case SC_CONTROL:
+                    return lexFail(ErrorCode::CONTROL_CHARACTER_IN_STRING,
+                                   current);
+            }
+        }
+        return lexFail(ErrorCode::UNTERMINATED_STRING, size);
+    }
+
+    // `current` is on the backslash; left on the escape's last byte
+    constexpr bool checkEscape() {
+        if (++current == size) {
+            return lexFail(ErrorCode::UNTERMINATED_STRING, current);
+        }
+        char c = data[current];
+        switch (c) {
+            case '\\':
+            case '"':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                return true;
+            case 'u':
+                for (size_t i = 1; i <= 4; i++) {
+                    if (current + i == size ||
+                        !isHexDigit(data[current + i])) {
+                        return lexFail(ErrorCode::INVALID_ESCAPE, current, c);
+                    }
+                }
+                current += 4;
+                return true;
+            default:
+                return lexFail(ErrorCode::INVALID_ESCAPE, current, c);
+        }
+    }
+
+    constexpr bool checkLiteral(const char* literal, size_t length) {
+        size_t remaining = size - current;
+        for (size_t i = 0; i < length; i++) {
+            if (i == remaining) {
+                return lexFail(ErrorCode::UNEXPECTED_EOF_IN_LITERAL, current,
+                               literal[0]);
+            }
+            if (data[current + i] != literal[i]) {
+                return lexFail(ErrorCode::INVALID_LITERAL, current,
+                               literal[0]);
+            }
+        }
+        current += length;
+        if (current < size && !isLiteralDelimiter(data[current])) {
+            return lexFail(ErrorCode::INVALID_CHARACTER_AFTER_LITERAL,
+                           current, literal[0]);
+        }
+        return true;
+    }
+
+    constexpr bool lexFail(ErrorCode code, size_t offset, char detail = 0) {
+        error = ParseResult(code, offset, detail);
+        return false;
+    }
+
+    // Parser rules, over input the Lexer rules accepted
+
+    // Skips whitespace to the next token; false at the end of the input
+    constexpr bool nextToken() {
+        while (current < size && charClass(data[current]) == CC_WHITESPACE) {
+            current++;
+        }
+        return current < size;
+    }
+
+    constexpr bool peek(TokenType& type) {
+        if (!nextToken()) {
+            return fail(ErrorCode::UNEXPECTED_END_OF_INPUT);
+        }
+        switch (charClass(data[current])) {
+            case CC_LEFT_BRACE:
+                type = TokenType::LEFT_BRACE;
+                break;
+            case CC_RIGHT_BRACE:
+                type = TokenType::RIGHT_BRACE;
+                break;
+            case CC_LEFT_BRACKET:
+                type = TokenType::LEFT_BRACKET;
+                break;
+            case CC_RIGHT_BRACKET:
+                type = TokenType::RIGHT_BRACKET;
+                break;
+            case CC_COLON:
+                type = TokenType::COLON;
+                break;
+            case CC_COMMA:
+                type = TokenType::COMMA;
+                break;
+            case CC_QUOTE:
+                type = TokenType::STRING;
+                break;
+            case CC_TRUE:
+                type = TokenType::TRUE;
+                break;
+            case CC_FALSE:
+                type = TokenType::FALSE;
+                break;
+            case CC_NULL:
+                type = TokenType::NULL_TOKEN;
+                break;
+            default:
+                type = TokenType::NUMBER;
+                break;
+        }
+        return true;
+    }
+
+    constexpr bool consume(TokenType type) {
+        TokenType next = TokenType::NULL_TOKEN;
+        if (!peek(next)) {
+            return false;
+        }
+        if (next != type) {
+            return fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN);
+        }
+        current++;
+        return true;
+    }
+
+    constexpr bool parseValue() {
+        TokenType type = TokenType::NULL_TOKEN;
+        if (!peek(type)) {
+            return false;
+        }
+        switch (type) {
+            case TokenType::LEFT_BRACE:
+                return parseContainer(true);
+            case TokenType::LEFT_BRACKET:
+                return parseContainer(false);
+            case TokenType::STRING:
+                return appendString();
+            case TokenType::NUMBER:
+                return appendNumber();
+            case TokenType::TRUE:
+                current += 4;
+                return append(tapeWord(TAPE_TRUE, 0));
+            case TokenType::FALSE:
+                current += 5;
+                return append(tapeWord(TAPE_FALSE, 0));
+            case TokenType::NULL_TOKEN:
+                current += 4;
+                return append(tapeWord(TAPE_NULL, 0));
+            default:
+                return fail(ErrorCode::UNEXPECTED_TOKEN);
+        }
+    }
+
+    // Objects and arrays, with the same checks and errors as
+    // Parser::parseObject() and Parser::parseArray()
+    constexpr bool parseContainer(bool object) {
+        TokenType close =
+            object ? TokenType::RIGHT_BRACE : TokenType::RIGHT_BRACKET;
+        size_t start = tapeSize;
+        uint32_t count = 0;
+        current++;
+        if (!append(0)) {  // Patched when the container closes
+            return false;
+        }
+
+        TokenType type = TokenType::NULL_TOKEN;
+        if (!peek(type)) {
+            return false;
+        }
+        while (type != close) {
+            if (object) {
+                if (type != TokenType::STRING) {
+                    return fail(ErrorCode::EXPECTED_STRING_KEY);
+                }
+                if (!appendString() || !consume(TokenType::COLON)) {
+                    return false;
+                }
+            }
+            if (!parseValue() || !peek(type)) {
+                return false;
+            }
+            count++;
+            if (type == close) {
+                break;
+            }
+            if (!consume(TokenType::COMMA) || !peek(type)) {
+                return false;
+            }
+            if (type == close) {
+                return fail(object ? ErrorCode::TRAILING_COMMA_IN_OBJECT
+                                   : ErrorCode::TRAILING_COMMA_IN_ARRAY);
+            }
+        }
+        current++;
+
+        size_t end = tapeSize;
+        if (tape != nullptr) {
+            tape[start] = tapeWord(object ? TAPE_OBJECT_START
+                                          : TAPE_ARRAY_START,
+                                   tapeContainerPayload(end, count));
+        }
+        return append(tapeWord(object ? TAPE_OBJECT_END : TAPE_ARRAY_END,
+                               start));
+    }
+
+    // A uint32 length in host byte order, the decoded bytes and a NUL, as
+    // Document writes them
+    constexpr bool appendString() {
+        size_t entry = stringsSize;
+        if (!append(tapeWord(TAPE_STRING, entry))) {
+            return false;
+        }
+        stringsSize += 4;
+        const char* end = data + size;
+        const char* p = data + current + 1;
+        while (*p != '"') {
+            char decoded[4] = {};
+            size_t length = 1;
+            if (*p != '\\') {
+                decoded[0] = *p++;
+            } else {
+                char c = p[1];
+                p += 2;
+                switch (c) {
+                    case 'b':
+                        decoded[0] = '\b';
+                        break;
+                    case 'f':
+                        decoded[0] = '\f';
+                        break;
+                    case 'n':
+                        decoded[0] = '\n';
+                        break;
+                    case 'r':
+                        decoded[0] = '\r';
+                        break;
+                    case 't':
+                        decoded[0] = '\t';
+                        break;
+                    case 'u':
+                        length = encodeUtf8(decodeEscapedCodePoint(p, end),
+                                            decoded);
+                        break;
+                    default:  // '\\', '"' and '/' stand for themselves
+                        decoded[0] = c;
+                        break;
+                }
+            }
+            for (size_t i = 0; i < length; i++) {
+                appendByte(decoded[i]);
+            }
+        }
+        current = p + 1 - data;
+
+        uint32_t length = static_cast<uint32_t>(stringsSize - entry - 4);
+        for (size_t i = 0; i < 4; i++) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            size_t shift = 8 * (3 - i);
+#else
+            size_t shift = 8 * i;
+#endif
+            if (strings != nullptr && entry + i < stringsCapacity) {
+                strings[entry + i] = static_cast<char>(length >> shift);
+            }
+        }
+        appendByte('\0');
+        return stringsSize <= stringsCapacity || strings == nullptr;
+    }
+
+    // Integers that fit in 64 bits are kept exact, as in Document
+    constexpr bool appendNumber() {
+        const char* start = data + current;
+        const char* end = start;
+        matchNumber(end, data + size);
+        current = end - data;
+
+        int64_t integer = 0;
+        uint64_t bits = 0;
+        if (parseInteger(start, end, integer)) {
+            return append(tapeWord(TAPE_INT64, 0)) &&
+                   append(static_cast<uint64_t>(integer));
+        }
+        if (!parseDoubleBits(start, end, bits)) {
+            error = ParseResult(ErrorCode::TOO_MANY_DIGITS, start - data);
+            return false;
+        }
+        return append(tapeWord(TAPE_DOUBLE, 0)) && append(bits);
+    }
+
+    constexpr bool append(uint64_t word) {
+        if (tape != nullptr) {
+            if (tapeSize == tapeCapacity) {
+                return fail(ErrorCode::INPUT_TOO_LARGE);
+            }
+            tape[tapeSize] = word;
+        }
+        tapeSize++;
+        return true;
+    }
+
+    constexpr void appendByte(char c) {
+        if (strings != nullptr && stringsSize < stringsCapacity) {
+            strings[stringsSize] = c;
+        }
+        stringsSize++;
+    }
+
+    // Grammar errors point at the current token, or at the end of the input
+    constexpr bool fail(ErrorCode code) {
+        nextToken();
+        error = ParseResult(code, current);
+        return false;
+    }
+};
+
+constexpr StaticLayout staticLayout(const char* data, size_t size) {
+    StaticParser parser(data, size, nullptr, 0, nullptr, 0);
+    ParseResult result = parser.run();
+    return StaticLayout{result, parser.tapeWords(), parser.stringBytes()};
+}
+
+// A document parsed at compile time. Declare it static constexpr (or use
+// STATIC_JSON_DOCUMENT) with the sizes staticLayout() gives for the same
+// literal; the view points into the object itself, so it must not be a
+// local variable.
+template <size_t TapeSize, size_t StringsSize>
+class StaticDocument {
+   public:
+    constexpr StaticDocument(const char* data, size_t size)
+        : tape(), strings(), tapeView() {
+        StaticParser parser(data, size, tape, TapeSize, strings, StringsSize);
+        if (!parser.run().ok() || parser.tapeWords() != TapeSize ||
+            parser.stringBytes() != StringsSize) {
+            // Reached at compile time this stops the build: the literal
+            // is malformed or the sizes don't match it
+            throw std::invalid_argument("Malformed static JSON document");
+        }
+        tapeView.tape = tape;
+        tapeView.tapeSize = TapeSize;
+        tapeView.strings = strings;
+        tapeView.stringsSize = StringsSize;
+    }
+
+    StaticDocument(const StaticDocument&) = delete;
+    StaticDocument& operator=(const StaticDocument&) = delete;
+
+    Value root() const { return Value(&tapeView, 0); }
+    const DocumentView& view() const { return tapeView; }
+
+   private:
+    uint64_t tape[TapeSize];
+    char strings[StringsSize > 0 ? StringsSize : 1];
+    DocumentView tapeView;
+};
+
+// Declares `name` as a static constexpr StaticDocument parsed from the
+// string literal `literal`, with a static_assert naming it if the literal is
+// malformed
+#define STATIC_JSON_DOCUMENT(name, literal)                                  \
+    static constexpr StaticLayout name##Layout =                             \
+        staticLayout(literal, sizeof(literal) - 1);                          \
+    static_assert(name##Layout.result.ok(), "Malformed JSON in " #name);     \
+    static constexpr StaticDocument<name##Layout.tapeSize,                   \
+                                    name##Layout.stringsSize>                \
+        name(literal, sizeof(literal) - 1)
@@ -0,0 +1,64 @@
+#include "string_ref.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+
+namespace {
+
+template <typename String>
+void unescapeInto(StringRef raw, String& out) {
+    const char* p = raw.data;
+    const char* end = raw.data + raw.size;
+    out.reserve(out.size() + raw.size);
+
+    while (true) {
+        const char* backslash =
+            static_cast<const char*>(memchr(p, '\\', end - p));
+        if (backslash == nullptr) {
+            out.append(p, end);
+            return;
+        }
+        out.append(p, backslash);
+
+        char c = backslash[1];
+        p = backslash + 2;
+        switch (c) {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                char utf8[4] = {};
+                out.append(utf8, encodeUtf8(decodeEscapedCodePoint(p, end),
+                                            utf8));
+                break;
+            }
+            default:  // '\\', '"' and '/' stand for themselves
+                out += c;
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+void unescapeString(StringRef raw, std::string& out) {
+    unescapeInto(raw, out);
+}
+
+void unescapeString(StringRef raw, std::pmr::string& out) {
+    unescapeInto(raw, out);
+}
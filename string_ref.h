@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+
+// Non-owning view of a run of bytes, usually a slice of the parser input.
+// The referenced memory must outlive the view.
+struct StringRef {
+    const char* data;
+    size_t size;
+
+    StringRef() : data(""), size(0) {}
+    StringRef(const char* d, size_t s) : data(d), size(s) {}
+    StringRef(const char* s) : data(s), size(strlen(s)) {}
+    StringRef(const std::string& s) : data(s.data()), size(s.size()) {}
+    StringRef(const std::pmr::string& s) : data(s.data()), size(s.size()) {}
+
+    bool empty() const { return size == 0; }
+    std::string str() const { return std::string(data, size); }
+
+    bool operator==(StringRef other) const {
+        return size == other.size && memcmp(data, other.data, size) == 0;
+    }
+    bool operator!=(StringRef other) const { return !(*this == other); }
+};
+
+// Decodes the escapes in an already validated string body (the bytes between
+// the quotes) and appends the result to `out`. \u escapes are written as
+// UTF-8; a surrogate that isn't part of a pair becomes U+FFFD.
+void unescapeString(StringRef raw, std::string& out);
+void unescapeString(StringRef raw, std::pmr::string& out);
+
+// Value of the four hex digits at `p`
+constexpr uint32_t escapeHexValue(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        uint32_t digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+// `p` points just past "\u"; advances past the code point's escape(s). A
+// surrogate that isn't part of a pair becomes U+FFFD.
+constexpr uint32_t decodeEscapedCodePoint(const char*& p, const char* end) {
+    uint32_t unit = escapeHexValue(p);
+    p += 4;
+    if (unit < 0xD800 || unit > 0xDFFF) {
+        return unit;
+    }
+
+    // A high surrogate must be followed by an escaped low surrogate
+    if (unit <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+        uint32_t low = escapeHexValue(p + 2);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            p += 6;
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+    return 0xFFFD;
+}
+
+// Writes `codePoint` as UTF-8 to `out` and returns the byte count, 1 to 4
+constexpr size_t encodeUtf8(uint32_t codePoint, char* out) {
+    if (codePoint < 0x80) {
+        out[0] = static_cast<char>(codePoint);
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+        out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+        out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+    out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 4;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "number.h"
+#include "string_ref.h"
+
+// Canonical 64-bit hashes of JSON values. Equal values hash equal however
+// they are written: whitespace, string escapes, object member order and
+// number spelling ("1", "1.0" and "10e-1" are the same number) make no
+// difference. Numbers compare as int64 when their value is a whole number
+// in range and as doubles otherwise, so -0 equals 0. Hashes are the same on
+// every run and platform, so they can be stored and compared later.
+//
+// Objects add up their member hashes, which makes them order-insensitive;
+// arrays fold their elements in order. Distinct values collide with
+// probability around 2^-64 per pair.
+
+// splitmix64 finalizer
+inline uint64_t hashMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Seeds keep values of different types apart, e.g. "1" and 1, [] and {}
+const uint64_t kHashNull = 0x6e756c6c00000001ULL;
+const uint64_t kHashFalse = 0x66616c7365000002ULL;
+const uint64_t kHashTrue = 0x7472756500000003ULL;
+const uint64_t kHashInteger = 0x696e740000000004ULL;
+const uint64_t kHashDouble = 0x646f75626c000005ULL;
+const uint64_t kHashString = 0x7374720000000006ULL;
+const uint64_t kHashArray = 0x6172720000000007ULL;
+const uint64_t kHashObject = 0x6f626a0000000008ULL;
+const uint64_t kHashMember = 0x6d656d6265000009ULL;
+
+inline uint64_t hashString(StringRef value) {
+    uint64_t hash = hashMix(kHashString ^ value.size);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(value.data);
+    size_t remaining = value.size;
+    while (remaining > 0) {
+        // Little-endian words, whatever the host byte order
+        size_t count = remaining < 8 ? remaining : 8;
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; i++) {
+            word |= static_cast<uint64_t>(p[i]) << (8 * i);
+        }
+        hash = hashMix(hash ^ word) + kHashString;
+        p += count;
+        remaining -= count;
+    }
+    return hash;
+}
+
+// `start` and `end` bound number text accepted by matchNumber
+inline uint64_t hashNumber(const char* start, const char* end) {
+    int64_t integer;
+    if (!parseInteger(start, end, integer)) {
+        double value = parseDouble(start, end);
+        // Whole doubles in int64 range hash as the integer
+        if (value >= -9223372036854775808.0 && value < 9223372036854775808.0 &&
+            static_cast<double>(static_cast<int64_t>(value)) == value) {
+            integer = static_cast<int64_t>(value);
+        } else {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return hashMix(kHashDouble ^ bits);
+        }
+    }
+    return hashMix(kHashInteger ^ static_cast<uint64_t>(integer));
+}
+
+inline uint64_t hashBool(bool value) {
+    return hashMix(value ? kHashTrue : kHashFalse);
+}
+
+inline uint64_t hashNull() { return hashMix(kHashNull); }
+
+// Arrays: start from hashArrayStart(), add each element with
+// hashArrayElement() and finish with hashArray()
+inline uint64_t hashArrayStart() { return kHashArray; }
+
+inline uint64_t hashArrayElement(uint64_t state, uint64_t element) {
+    return hashMix(state ^ element) + kHashArray;
+}
+
+inline uint64_t hashArray(uint64_t state, size_t count) {
+    return hashMix(state ^ hashMix(kHashArray + count));
+}
+
+// Objects: sum hashMember() over the members, in any order, and finish with
+// hashObject()
+inline uint64_t hashMember(uint64_t key, uint64_t value) {
+    return hashMix(key ^ hashMix(value ^ kHashMember));
+}
+
+inline uint64_t hashObject(uint64_t memberSum, size_t count) {
+    return hashMix(memberSum ^ hashMix(kHashObject + count));
+}
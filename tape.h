@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a parsed document. A document is an array of 64-bit tape words
+// plus a string area; every link between them is an index or a byte offset,
+// never a pointer, so the same bytes can be written to disk and used again
+// from any address.
+//
+// Each word holds a tag in its top byte and a 56-bit payload:
+//   TAPE_OBJECT_START / TAPE_ARRAY_START  index of the matching end word in
+//                                         the low 32 bits, element count
+//                                         (saturated) in the next 24
+//   TAPE_OBJECT_END / TAPE_ARRAY_END      index of the matching start word
+//   TAPE_STRING                           offset of the string in the string
+//                                         area: a uint32 length, the bytes
+//                                         and a NUL terminator
+//   TAPE_INT64 / TAPE_DOUBLE              unused; the value is stored raw in
+//                                         the following word
+//   TAPE_TRUE / TAPE_FALSE / TAPE_NULL    unused
+// Object members are stored as a key string followed by its value.
+enum TapeTag : uint8_t {
+    TAPE_NULL = 'n',
+    TAPE_TRUE = 't',
+    TAPE_FALSE = 'f',
+    TAPE_INT64 = 'l',
+    TAPE_DOUBLE = 'd',
+    TAPE_STRING = '"',
+    TAPE_OBJECT_START = '{',
+    TAPE_OBJECT_END = '}',
+    TAPE_ARRAY_START = '[',
+    TAPE_ARRAY_END = ']',
+};
+
+constexpr uint64_t kTapePayloadMask = (uint64_t(1) << 56) - 1;
+constexpr uint32_t kTapeCountSaturated = 0xFFFFFF;
+
+constexpr uint64_t tapeWord(TapeTag tag, uint64_t payload) {
+    return (uint64_t(tag) << 56) | (payload & kTapePayloadMask);
+}
+
+constexpr TapeTag tapeTag(uint64_t word) {
+    return static_cast<TapeTag>(word >> 56);
+}
+
+constexpr uint64_t tapePayload(uint64_t word) {
+    return word & kTapePayloadMask;
+}
+
+constexpr uint64_t tapeContainerPayload(uint32_t endIndex, uint32_t count) {
+    if (count > kTapeCountSaturated) {
+        count = kTapeCountSaturated;
+    }
+    return (uint64_t(count) << 32) | endIndex;
+}
+
+constexpr uint32_t tapeContainerEnd(uint64_t word) {
+    return static_cast<uint32_t>(word);
+}
+
+constexpr uint32_t tapeContainerCount(uint64_t word) {
+    return static_cast<uint32_t>(tapePayload(word) >> 32);
+}
+
+// Index of the word after the value starting at `index`
+constexpr size_t tapeNext(const uint64_t* tape, size_t index) {
+    switch (tapeTag(tape[index])) {
+        case TAPE_OBJECT_START:
+        case TAPE_ARRAY_START:
+            return tapeContainerEnd(tape[index]) + 1;
+        case TAPE_INT64:
+        case TAPE_DOUBLE:
+            return index + 2;
+        default:
+            return index + 1;
+    }
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dedup.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+// Structural hashes of every token of `json`, which must be valid
+std::vector<uint64_t> hashTokens(const std::string& json) {
+    Lexer lexer(json.data(), json.size());
+    TokenBuffer tokens;
+    assert(lexer.tryTokenize(tokens).ok());
+    Parser parser(std::move(tokens));
+    std::vector<uint64_t> hashes;
+    assert(parser.tryParseHashed(lexer, hashes).ok());
+    return hashes;
+}
+
+uint64_t hashOf(const std::string& json) { return hashTokens(json)[0]; }
+
+void test_hashing() {
+    // Test case 1: Spelling doesn't matter
+    {
+        assert(hashOf(R"({"a": 1, "b": [1, 2]})") ==
+               hashOf(R"({ "b" : [1, 2.0], "\u0061": 10e-1 })"));
+        assert(hashOf(R"("tab\there")") == hashOf("\"tab\\u0009here\""));
+        assert(hashOf("0") == hashOf("-0.0"));
+        assert(hashOf("1.5") == hashOf("15e-1"));
+        assert(hashOf("100") == hashOf("1E2"));
+        assert(hashOf("9223372036854775807") ==
+               hashOf(" 9223372036854775807 "));
+    }
+
+    // Test case 2: Values that differ hash differently
+    {
+        assert(hashOf("[1, 2]") != hashOf("[2, 1]"));
+        assert(hashOf("[1]") != hashOf("[1, 1]"));
+        assert(hashOf("[[]]") != hashOf("[]"));
+        assert(hashOf("{}") != hashOf("[]"));
+        assert(hashOf("\"1\"") != hashOf("1"));
+        assert(hashOf("1") != hashOf("1.5"));
+        assert(hashOf("true") != hashOf("false"));
+        assert(hashOf("null") != hashOf("false"));
+        assert(hashOf("\"\"") != hashOf("null"));
+        assert(hashOf(R"({"a": 1, "b": 2})") != hashOf(R"({"a": 2, "b": 1})"));
+        assert(hashOf(R"({"a": 1})") != hashOf(R"({"a": 1, "a": 1})"));
+        assert(hashOf(R"({"a": {"b": 1}})") != hashOf(R"({"b": {"a": 1}})"));
+        assert(hashOf(R"(["ab", "c"])") != hashOf(R"(["a", "bc"])"));
+        assert(hashOf("\"abcdefgh\"") != hashOf("\"abcdefgh\\u0000\""));
+    }
+
+    // Test case 3: Every member order of an object hashes the same
+    {
+        std::vector<std::string> members = {R"("a": 1)", R"("b": [true])",
+                                            R"("c": {"d": null})",
+                                            R"("e": "f")"};
+        uint64_t first = 0;
+        std::vector<size_t> order = {0, 1, 2, 3};
+        do {
+            std::string json = "{";
+            for (size_t i = 0; i < order.size(); i++) {
+                json += (i > 0 ? ", " : "") + members[order[i]];
+            }
+            json += "}";
+            if (first == 0) {
+                first = hashOf(json);
+            }
+            assert(hashOf(json) == first);
+        } while (std::next_permutation(order.begin(), order.end()));
+    }
+
+    // Test case 4: Each subtree gets the hash it would have on its own
+    {
+        std::vector<uint64_t> hashes =
+            hashTokens(R"([{"x": [1, 2]}, {"x": [1, 2.0]}, 3])");
+        // [ { "x" : [ 1 , 2 ] } , { "x" : [ 1 , 2.0 ] } , 3 ]
+        assert(hashes[1] == hashes[11]);
+        assert(hashes[1] == hashOf(R"({"x": [1, 2]})"));
+        assert(hashes[4] == hashOf("[1, 2]"));
+        assert(hashes[2] == hashOf("\"x\""));
+        assert(hashes[21] == hashOf("3"));
+        assert(hashes[3] == 0);  // Colon
+    }
+
+    // Test case 5: Hashing doesn't change what is accepted
+    {
+        const char* inputs[] = {"[1, 2,]", R"({"a" 1})", "[1] 2", "[[1]"};
+        for (const char* input : inputs) {
+            std::string json = input;
+            Lexer lexer(json.data(), json.size());
+            TokenBuffer tokens;
+            assert(lexer.tryTokenize(tokens).ok());
+            Parser plain(tokens);
+            Parser hashed(tokens);
+            std::vector<uint64_t> hashes;
+            ParseResult expected = plain.tryParse();
+            ParseResult actual = hashed.tryParseHashed(lexer, hashes);
+            assert(!expected.ok());
+            assert(actual.code == expected.code);
+            assert(actual.offset == expected.offset);
+        }
+    }
+
+    std::cout << "Structural hash tests passed!" << std::endl;
+}
+
+void test_dedup() {
+    // Test case 1: Repeats are dropped whatever their spelling
+    {
+        std::string input =
+            "{\"id\": 1, \"tags\": [\"a\"]}\n"
+            "{\"tags\": [\"a\"], \"id\": 1.0}\n"
+            "\n"
+            "{\"id\": 2, \"tags\": [\"a\"]}\n"
+            "  {\"id\":1,\"tags\":[\"\\u0061\"]}  \n"
+            "{\"id\": 2, \"tags\": [\"a\"]}";
+        Deduplicator dedup;
+        std::string output;
+        assert(dedup.addLines(input.data(), input.size(), output).ok());
+        assert(output ==
+               "{\"id\": 1, \"tags\": [\"a\"]}\n"
+               "{\"id\": 2, \"tags\": [\"a\"]}\n");
+        assert(dedup.recordCount() == 5);
+        assert(dedup.duplicateCount() == 3);
+        assert(dedup.uniqueCount() == 2);
+
+        // Keys are predicted once the last two records repeat their order
+        assert(dedup.keyShapes().lookups() == 10);
+        assert(dedup.keyShapes().hits() == 4);
+    }
+
+    // Test case 2: Records seen in an earlier call still count
+    {
+        Deduplicator dedup;
+        bool duplicate = true;
+        assert(dedup.addRecord("[1, 2]", 6, duplicate).ok());
+        assert(!duplicate);
+        uint64_t hash = dedup.lastHash();
+        assert(dedup.addRecord("[1,2.0]", 7, duplicate).ok());
+        assert(duplicate);
+        assert(dedup.lastHash() == hash);
+        dedup.clear();
+        assert(dedup.addRecord("[1, 2]", 6, duplicate).ok());
+        assert(!duplicate);
+    }
+
+    // Test case 3: Invalid records stop the run at their offset
+    {
+        std::string input = "[1]\n[1]\n{\"a\": }\n[2]\n";
+        Deduplicator dedup;
+        std::string output;
+        ParseResult result =
+            dedup.addLines(input.data(), input.size(), output);
+        assert(result.code == ErrorCode::UNEXPECTED_TOKEN);
+        assert(result.offset == 14);
+        assert(output == "[1]\n");
+        assert(dedup.recordCount() == 2);
+    }
+
+    std::cout << "Deduplication tests passed!" << std::endl;
+}
+
+int main() {
+    test_hashing();
+    test_dedup();
+    std::cout << "All dedup tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+void test_scalars() {
+    // Test case 1: Each scalar type
+    {
+        Document doc;
+        assert(doc.parse("true").ok());
+        assert(doc.root().type() == ValueType::BOOLEAN);
+        assert(doc.root().asBool());
+
+        assert(doc.parse("null").ok());
+        assert(doc.root().isNull());
+
+        assert(doc.parse(R"("text")").ok());
+        assert(doc.root().asString() == "text");
+    }
+
+    // Test case 2: Integers stay exact, everything else becomes a double
+    {
+        Document doc;
+        assert(doc.parse("-9223372036854775808").ok());
+        assert(doc.root().type() == ValueType::INT64);
+        assert(doc.root().asInt64() == INT64_MIN);
+
+        assert(doc.parse("9223372036854775808").ok());
+        assert(doc.root().type() == ValueType::DOUBLE);
+        assert(doc.root().asDouble() == 9223372036854775808.0);
+
+        assert(doc.parse("-2.5e3").ok());
+        assert(doc.root().type() == ValueType::DOUBLE);
+        assert(doc.root().asDouble() == -2500.0);
+        assert(doc.root().asInt64() == 0);  // Wrong type
+
+        assert(doc.parse("42").ok());
+        assert(doc.root().asDouble() == 42.0);
+    }
+
+    // Test case 3: Strings are stored unescaped
+    {
+        Document doc;
+        assert(doc.parse(R"("tab\there é")").ok());
+        assert(doc.root().asString() == "tab\there \xc3\xa9");
+    }
+
+    std::cout << "Scalar document tests passed!" << std::endl;
+}
+
+void test_navigation() {
+    std::string json = R"({
+        "name": "John",
+        "age": 30,
+        "tags": ["a", "b", {"deep": [1, 2.5, null]}],
+        "empty": {},
+        "none": []
+    })";
+    Document doc;
+    assert(doc.parse(json).ok());
+    Value root = doc.root();
+
+    // Test case 1: Object lookup
+    {
+        assert(root.isObject());
+        assert(root.size() == 5);
+        assert(root["name"].asString() == "John");
+        assert(root["age"].asInt64() == 30);
+        assert(!root["missing"].exists());
+        assert(!root["name"]["nested"].exists());
+    }
+
+    // Test case 2: Array indexing and nesting
+    {
+        Value tags = root["tags"];
+        assert(tags.isArray());
+        assert(tags.size() == 3);
+        assert(tags[1].asString() == "b");
+        assert(tags[2]["deep"][1].asDouble() == 2.5);
+        assert(tags[2]["deep"][2].isNull());
+        assert(!tags[3].exists());
+    }
+
+    // Test case 3: Empty containers
+    {
+        assert(root["empty"].size() == 0);
+        assert(root["none"].size() == 0);
+        assert(root["empty"].begin() == root["empty"].end());
+        assert(root["none"].begin() == root["none"].end());
+    }
+
+    // Test case 4: Iteration
+    {
+        std::vector<std::string> keys;
+        for (Value::Iterator it = root.begin(); it != root.end(); ++it) {
+            keys.push_back(it.key().str());
+        }
+        assert(keys.size() == 5);
+        assert(keys[0] == "name" && keys[4] == "none");
+
+        int64_t sum = 0;
+        Document numbers;
+        assert(numbers.parse("[1, [2, 3], 4, {\"x\": 5}, 6]").ok());
+        for (Value element : numbers.root()) {
+            sum += element.asInt64();
+        }
+        assert(sum == 11);
+    }
+
+    std::cout << "Document navigation tests passed!" << std::endl;
+}
+
+// {"k0": 0, "k1": 1, ...}, with a second "k0" at the end when `duplicate`
+std::string wideObject(size_t members, bool duplicate) {
+    std::string json = "{";
+    for (size_t i = 0; i < members; i++) {
+        json += (i > 0 ? ", \"k" : "\"k") + std::to_string(i) +
+                "\": " + std::to_string(i);
+    }
+    if (duplicate) {
+        json += ", \"k0\": -1";
+    }
+    return json + "}";
+}
+
+void test_large_objects() {
+    // Test case 1: Every key of a large object is found through its index
+    {
+        Document doc;
+        assert(doc.parse(wideObject(5000, false)).ok());
+        Value root = doc.root();
+        assert(doc.view().objectIndex->tableCount() == 0);
+
+        for (int64_t i = 0; i < 5000; i++) {
+            assert(root["k" + std::to_string(i)].asInt64() == i);
+        }
+        assert(!root["k5000"].exists());
+        assert(!root[""].exists());
+        assert(!root["k"].exists());
+        assert(doc.view().objectIndex->tableCount() == 1);
+    }
+
+    // Test case 2: Small objects are never indexed
+    {
+        Document doc;
+        size_t threshold = ObjectIndex::kMinMembers;
+        std::string json = "[" + wideObject(threshold - 1, false) + ", " +
+                           wideObject(threshold, false) + "]";
+        assert(doc.parse(json).ok());
+        assert(doc.root()[0]["k3"].asInt64() == 3);
+        assert(doc.view().objectIndex->tableCount() == 0);
+        assert(doc.root()[1]["k3"].asInt64() == 3);
+        assert(doc.view().objectIndex->tableCount() == 1);
+    }
+
+    // Test case 3: The first of duplicate keys wins, as with a linear scan
+    {
+        Document doc;
+        assert(doc.parse(wideObject(100, true)).ok());
+        assert(doc.root()["k0"].asInt64() == 0);
+        assert(doc.root().size() == 101);
+    }
+
+    // Test case 4: Parsing again drops the indexes
+    {
+        Document doc;
+        assert(doc.parse(wideObject(100, false)).ok());
+        assert(doc.root()["k50"].asInt64() == 50);
+        size_t indexed = doc.memoryUsage();
+        assert(doc.parse(wideObject(100, false)).ok());
+        assert(doc.view().objectIndex->tableCount() == 0);
+        assert(doc.memoryUsage() <= indexed);
+        assert(doc.root()["k99"].asInt64() == 99);
+    }
+
+    // Test case 5: Threads index and read many objects at once, growing
+    // the directory of tables as they go
+    {
+        std::string json = "[";
+        for (int o = 0; o < 40; o++) {
+            json += (o > 0 ? ", " : "") + wideObject(40, false);
+        }
+        Document doc;
+        assert(doc.parse(json + "]").ok());
+        Value root = doc.root();
+
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 8; t++) {
+            readers.emplace_back([root, t]() {
+                for (int round = 0; round < 20; round++) {
+                    for (int o = 0; o < 40; o++) {
+                        int64_t k = (o + t + round) % 40;
+                        Value object = root[(o * 7 + t) % 40];
+                        assert(object["k" + std::to_string(k)].asInt64() ==
+                               k);
+                    }
+                }
+            });
+        }
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        assert(doc.view().objectIndex->tableCount() == 40);
+    }
+
+    std::cout << "Large object lookup tests passed!" << std::endl;
+}
+
+void test_errors() {
+    // Test case 1: Errors from the Lexer and the Parser are reported
+    {
+        Document doc;
+        assert(doc.parse("[1, 2,]").code == ErrorCode::TRAILING_COMMA_IN_ARRAY);
+        assert(doc.empty());
+        assert(!doc.root().exists());
+        assert(doc.parse("\"abc").code == ErrorCode::UNTERMINATED_STRING);
+
+        // Duplicate keys only fail when asked to
+        assert(doc.parse(R"({"a": 1, "a": 2})").ok());
+        assert(doc.root()["a"].asInt64() == 1);
+        doc.checkDuplicateKeys(true);
+        assert(doc.parse(R"({"a": 1, "a": 2})").code ==
+               ErrorCode::DUPLICATE_KEY);
+        assert(doc.empty());
+    }
+
+    // Test case 2: Files
+    {
+        std::ofstream testFile(getTestFilePath("document_test1.json"));
+        testFile << R"({"key": [1, 2, 3]})";
+        testFile.close();
+
+        Document doc;
+        assert(doc.parseFile(getTestFilePath("document_test1.json")).ok());
+        assert(doc.root()["key"][2].asInt64() == 3);
+        assert(doc.parseFile(getTestFilePath("missing.json")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+    }
+
+    std::cout << "Document error tests passed!" << std::endl;
+}
+
+void test_key_prediction() {
+    std::string records = "[";
+    for (int i = 0; i < 100; i++) {
+        records += (i > 0 ? ", " : "") + std::string("{\"id\": ") +
+                   std::to_string(i) + ", \"name\": \"n\\u00e9\"}";
+    }
+    records += "]";
+
+    // Test case 1: Elements of an array share their keys
+    {
+        Document doc;
+        doc.predictKeys(true);
+        assert(doc.parse(records).ok());
+        assert(doc.keyShapes().lookups() == 200);
+        assert(doc.keyShapes().hits() == 198);
+        assert(doc.root()[99]["id"].asInt64() == 99);
+        assert(doc.root()[5]["name"].asString() == "n\u00e9");
+    }
+
+    // Test case 2: Shapes carry over to later parses until cleared
+    {
+        Document doc;
+        doc.predictKeys(true);
+        assert(doc.parse(R"({"a": 1, "b": [2]})").ok());
+        assert(doc.parse(R"({"a": 3, "b": [4]})").ok());
+        assert(doc.keyShapes().hits() == 2);
+        assert(doc.root()["b"][0].asInt64() == 4);
+
+        doc.clearKeyShapes();
+        doc.predictKeys(false);
+        assert(doc.parse(R"({"a": 5})").ok());
+        assert(doc.keyShapes().lookups() == 0);
+    }
+
+    // Test case 3: A key too long for the memory limit keeps the old one
+    {
+        Document doc;
+        doc.predictKeys(true);
+        assert(doc.parse(R"({"ab": 1})").ok());
+        doc.setMemoryLimit(2048);
+        std::string longKey = R"({")" + std::string(4096, 'k') + R"(": 1})";
+        assert(doc.parse(longKey).code == ErrorCode::MEMORY_LIMIT_EXCEEDED);
+        doc.setMemoryLimit(0);
+        size_t hits = doc.keyShapes().hits();
+        assert(doc.parse(R"({"ab": 2})").ok());
+        assert(doc.keyShapes().hits() == hits + 1);
+        assert(doc.root()["ab"].asInt64() == 2);
+    }
+
+    std::cout << "Key prediction document tests passed!" << std::endl;
+}
+
+int main() {
+    test_scalars();
+    test_navigation();
+    test_large_objects();
+    test_errors();
+    test_key_prediction();
+    std::cout << "All document tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "incremental.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+// The incremental state must match lexing and parsing from scratch
+bool matchesFullParse(const IncrementalParser& incremental) {
+    const std::string& text = incremental.text();
+    Lexer lexer(text.data(), text.size());
+    TokenBuffer tokens;
+    ParseResult expected = lexer.tryTokenize(tokens);
+    bool lexed = expected.ok();
+    if (lexed) {
+        Parser parser(tokens);
+        expected = parser.tryParse();
+    }
+    const ParseResult& actual = incremental.result();
+    if (actual.code != expected.code || actual.offset != expected.offset) {
+        return false;
+    }
+    if (!lexed) {
+        return true;
+    }
+    const TokenBuffer& kept = incremental.tokens();
+    if (tokens.size() != kept.size() ||
+        tokens.endOffset() != kept.endOffset()) {
+        return false;
+    }
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens.type(i) != kept.type(i) ||
+            tokens.offset(i) != kept.offset(i) ||
+            tokens.hasEscapes(i) != kept.hasEscapes(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string largeDocument(size_t records) {
+    std::string text = "{\"records\": [\n";
+    for (size_t i = 0; i < records; i++) {
+        text += "  {\"id\": " + std::to_string(i) +
+                ", \"name\": \"item\", \"tags\": [1, 2, 3]}";
+        text += i + 1 < records ? ",\n" : "\n";
+    }
+    text += "]}";
+    return text;
+}
+
+void test_edits() {
+    // Test case 1: Editing inside a number re-lexes one token and re-parses
+    // nothing
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse(largeDocument(1000)).ok());
+        assert(incremental.lastStats().fullParse);
+
+        size_t at = incremental.text().find("\"id\": 500") + 6;
+        assert(incremental.edit(at, 3, "123456").ok());
+        assert(incremental.text().compare(at, 6, "123456") == 0);
+        assert(!incremental.lastStats().fullParse);
+        assert(incremental.lastStats().parsedTokens == 0);
+        assert(incremental.lastStats().lexedBytes < 16);
+        assert(matchesFullParse(incremental));
+    }
+
+    // Test case 2: Adding an element re-parses only the enclosing array
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse(largeDocument(1000)).ok());
+
+        size_t at = incremental.text().find("[1, 2, 3]", 20000) + 2;
+        assert(incremental.edit(at, 0, ", 7").ok());
+        assert(!incremental.lastStats().fullParse);
+        assert(incremental.lastStats().parsedTokens == 9);
+        assert(matchesFullParse(incremental));
+
+        // Replacing a whole record keeps the bracket balance
+        size_t record = incremental.text().find("{\"id\": 7,");
+        size_t end = incremental.text().find('}', record) + 1;
+        assert(incremental.edit(record, end - record, "{\"x\": null}").ok());
+        assert(!incremental.lastStats().fullParse);
+        assert(matchesFullParse(incremental));
+    }
+
+    // Test case 3: Errors are reported at the same offset as a full parse
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse(largeDocument(100)).ok());
+
+        size_t at = incremental.text().find("\"tags\"", 2000);
+        assert(incremental.edit(at, 6, "7").code ==
+               ErrorCode::EXPECTED_STRING_KEY);
+        assert(matchesFullParse(incremental));
+
+        // Fixing it re-validates everything, as the old error could be
+        // anywhere
+        assert(incremental.edit(at, 1, "\"tags\"").ok());
+        assert(incremental.lastStats().fullParse);
+        assert(matchesFullParse(incremental));
+    }
+
+    // Test case 4: Edits that change bracket balance or token boundaries
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse(R"([[1], [2]])").ok());
+
+        // "],[" becomes "," and two arrays merge into one
+        assert(incremental.edit(3, 4, ",").ok());
+        assert(incremental.text() == "[[1,2]]");
+        assert(matchesFullParse(incremental));
+
+        // Dropping a close bracket leaves the outer array unclosed
+        assert(incremental.edit(5, 1, "").code ==
+               ErrorCode::UNEXPECTED_END_OF_INPUT);
+        assert(matchesFullParse(incremental));
+
+        // Joining two tokens into one
+        assert(incremental.parse("[12, 34]").ok());
+        assert(incremental.edit(3, 2, "").ok());
+        assert(incremental.text() == "[1234]");
+        assert(incremental.tokens().size() == 3);
+        assert(matchesFullParse(incremental));
+
+        // A quote turns the rest of the document into a string
+        assert(incremental.edit(1, 0, "\"").code ==
+               ErrorCode::UNTERMINATED_STRING);
+        assert(matchesFullParse(incremental));
+        assert(incremental.edit(1, 1, "").ok());
+        assert(matchesFullParse(incremental));
+    }
+
+    std::cout << "Incremental edit tests passed!" << std::endl;
+}
+
+void test_random_edits() {
+    // Test case 1: Random edits agree with parsing from scratch
+    {
+        const char* pieces[] = {"1",   "23",    ",",     "[",    "]",
+                                "{",   "}",     ":",     "\"",   "\"k\":",
+                                " ",   "true",  "null",  "\\n",  "\"s\"",
+                                ",4",  "[5]",   "{}",    "\xc3", "\xa9",
+                                "\xc3\xa9", "-", ".5", "e"};
+        size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+        std::mt19937 random(12345);
+
+        for (int round = 0; round < 20; round++) {
+            IncrementalParser incremental;
+            incremental.parse(largeDocument(20));
+            for (int step = 0; step < 200; step++) {
+                size_t size = incremental.text().size();
+                size_t offset = random() % (size + 1);
+                size_t length = std::min<size_t>(random() % 4, size - offset);
+                std::string replacement = pieces[random() % pieceCount];
+                if (random() % 3 == 0) {
+                    replacement.clear();
+                }
+                incremental.edit(offset, length, replacement);
+                assert(matchesFullParse(incremental));
+            }
+        }
+    }
+
+    // Test case 2: Edits that keep the document valid take the incremental
+    // path
+    {
+        std::mt19937 random(678);
+        IncrementalParser incremental;
+        assert(incremental.parse(largeDocument(200)).ok());
+        size_t partial = 0;
+        for (int step = 0; step < 500; step++) {
+            const std::string& text = incremental.text();
+            size_t at = text.find("[1", random() % text.size());
+            if (at == std::string::npos) {
+                continue;
+            }
+            if (random() % 2 == 0) {
+                assert(incremental.edit(at + 1, 0, "9, ").ok());
+            } else {
+                assert(incremental.edit(at + 1, 1, "\"a\"").ok());
+            }
+            partial += !incremental.lastStats().fullParse;
+            assert(incremental.lastStats().parsedTokens < 100);
+            assert(matchesFullParse(incremental));
+        }
+        assert(partial > 0);
+    }
+
+    std::cout << "Random incremental edit tests passed!" << std::endl;
+}
+
+void test_errors() {
+    // Test case 1: Edits outside the document
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse("[1]").ok());
+        assert(incremental.edit(4, 0, "x").code ==
+               ErrorCode::EDIT_OUT_OF_RANGE);
+        assert(incremental.edit(2, 2, "").code ==
+               ErrorCode::EDIT_OUT_OF_RANGE);
+        assert(incremental.text() == "[1]");
+        assert(incremental.result().ok());
+    }
+
+    // Test case 2: Invalid UTF-8 and empty documents
+    {
+        IncrementalParser incremental;
+        assert(incremental.parse("[\"ab\"]").ok());
+        assert(incremental.edit(2, 1, "\xff").code == ErrorCode::INVALID_UTF8);
+        assert(incremental.result().offset == 2);
+        assert(incremental.edit(2, 1, "x").ok());
+        assert(incremental.edit(0, 6, "").code == ErrorCode::EMPTY_INPUT);
+    }
+
+    // Test case 3: Files
+    {
+        std::ofstream testFile(getTestFilePath("incremental_test1.json"));
+        testFile << R"({"key": [1, 2, 3]})";
+        testFile.close();
+
+        IncrementalParser incremental;
+        assert(incremental.parseFile(getTestFilePath("incremental_test1.json"))
+                   .ok());
+        assert(incremental.edit(9, 1, "{}").ok());
+        assert(incremental.text() == R"({"key": [{}, 2, 3]})");
+        assert(incremental.parseFile(getTestFilePath("missing.json")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+    }
+
+    std::cout << "Incremental error tests passed!" << std::endl;
+}
+
+int main() {
+    test_edits();
+    test_random_edits();
+    test_errors();
+    std::cout << "All incremental tests passed successfully!" << std::endl;
+    return 0;
+}
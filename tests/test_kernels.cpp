@@ -0,0 +1,205 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "kernels.h"
+
+// Deterministic pseudo-random buffer mixing every byte class the kernels care
+// about, including multi-byte and malformed UTF-8
+std::string makeBuffer(uint32_t seed, size_t size) {
+    static const char* pieces[] = {
+        " ",  "\t", "\n", "\r", "a", "Z", "0", "\"", "\\", "{", "}", "[",
+        "]",  ":",  ",",  "\x01", "\x1f",
+        "\xc3\xa9",          // é
+        "\xe2\x82\xac",      // €
+        "\xf0\x9f\x98\x80",  // U+1F600
+        "\xc0\xaf",          // Overlong '/'
+        "\xed\xa0\x80",      // Surrogate
+        "\xff", "\x80"};
+    const size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+
+    std::string buffer;
+    while (buffer.size() < size) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t r = seed >> 16;
+        // Long runs of plain bytes exercise the full-width vector loops
+        if (r % 4 == 0) {
+            buffer.append(r % 97, (r & 1) ? ' ' : 'x');
+        } else {
+            buffer += pieces[r % pieceCount];
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void test_kernels_match_scalar() {
+    const Kernels* scalar = kernelsFor("scalar");
+    assert(scalar != nullptr);
+
+    for (const std::string& name : availableKernels()) {
+        const Kernels* k = kernelsFor(name);
+        assert(k != nullptr);
+
+        for (uint32_t seed = 1; seed <= 200; seed++) {
+            std::string buffer = makeBuffer(seed, seed * 3);
+            for (size_t offset = 0; offset < 4 && offset <= buffer.size();
+                 offset++) {
+                const char* data = buffer.data() + offset;
+                size_t size = buffer.size() - offset;
+
+                assert(k->skipWhitespace(data, size) ==
+                       scalar->skipWhitespace(data, size));
+                assert(k->scanString(data, size) ==
+                       scalar->scanString(data, size));
+                assert(k->findStructural(data, size) ==
+                       scalar->findStructural(data, size));
+                assert(k->validateUtf8(data, size) ==
+                       scalar->validateUtf8(data, size));
+            }
+        }
+    }
+
+    std::cout << "Kernel equivalence tests passed!" << std::endl;
+}
+
+// Valid text of every sequence length, long enough for several 64-byte
+// blocks, with sequences straddling block boundaries
+std::string makeValidUtf8(size_t size) {
+    static const char* pieces[] = {
+        "a", "xyz ", "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf",
+        "\xee\x80\x80", "\xef\xbf\xbf", "\xf0\x90\x80\x80",
+        "\xf4\x8f\xbf\xbf", "\xf3\xa0\x80\x81"};
+    const size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+    std::string text;
+    for (size_t i = 0; text.size() < size; i++) {
+        text += pieces[(i * 7) % pieceCount];
+    }
+    return text;
+}
+
+void test_utf8_kernels() {
+    const Kernels* scalar = kernelsFor("scalar");
+    static const char* malformed[] = {
+        "\x80",          // Stray continuation
+        "\xc3",          // Truncated
+        "\xc3x",         // Lead without continuation
+        "\xc1\xbf",      // Overlong 2-byte
+        "\xe0\x9f\xbf",  // Overlong 3-byte
+        "\xf0\x8f\xbf\xbf",  // Overlong 4-byte
+        "\xed\xa0\x80",  // Surrogate
+        "\xf4\x90\x80\x80",  // Above U+10FFFF
+        "\xf5\x80\x80\x80",
+        "\xf8\x88\x80\x80\x80",  // 5-byte form
+        "\xe2\x82\x82\xac",  // One continuation too many
+        "\xff"};
+
+    for (const std::string& name : availableKernels()) {
+        const Kernels* k = kernelsFor(name);
+
+        // Test case 1: Valid text of every length passes whole
+        {
+            std::string text = makeValidUtf8(300);
+            for (size_t size = 0; size <= text.size(); size++) {
+                size_t expected = scalar->validateUtf8(text.data(), size);
+                assert(k->validateUtf8(text.data(), size) == expected);
+            }
+        }
+
+        // Test case 2: Every kind of error, at every position, is found
+        // at the same offset as the scalar kernel finds it
+        {
+            std::string text = makeValidUtf8(200);
+            for (const char* bad : malformed) {
+                for (size_t at = 0; at < 150; at++) {
+                    // Cutting a sequence can make it whole again, so only
+                    // agreement with the scalar kernel is checked
+                    std::string buffer = text.substr(0, at) + bad + text;
+                    size_t expected =
+                        scalar->validateUtf8(buffer.data(), buffer.size());
+                    assert(k->validateUtf8(buffer.data(), buffer.size()) ==
+                           expected);
+                }
+            }
+        }
+
+        // Test case 3: A sequence left open at the end of a block, followed
+        // by an all-ASCII block
+        {
+            std::string buffer(61, 'a');
+            buffer += "\xf0\x9f\x98";
+            buffer += std::string(64, 'b');
+            assert(k->validateUtf8(buffer.data(), buffer.size()) == 61);
+        }
+    }
+
+    std::cout << "UTF-8 kernel tests passed!" << std::endl;
+}
+
+void test_scalar_kernels() {
+    const Kernels* k = kernelsFor("scalar");
+
+    // Test case 1: Whitespace
+    {
+        std::string s = " \t\r\n  x";
+        assert(k->skipWhitespace(s.data(), s.size()) == 6);
+        assert(k->skipWhitespace(s.data(), 3) == 3);
+    }
+
+    // Test case 2: String bodies
+    {
+        std::string s = "hello \\\"world\"";
+        assert(k->scanString(s.data(), s.size()) == 6);
+        std::string control = "ab\x01";
+        assert(k->scanString(control.data(), control.size()) == 2);
+    }
+
+    // Test case 3: Structural characters
+    {
+        std::string s = "  123 , 4";
+        assert(k->findStructural(s.data(), s.size()) == 6);
+    }
+
+    // Test case 4: UTF-8
+    {
+        std::string valid = "caf\xc3\xa9 \xf0\x9f\x98\x80";
+        assert(k->validateUtf8(valid.data(), valid.size()) == valid.size());
+        std::string overlong = "ab\xc0\xaf";
+        assert(k->validateUtf8(overlong.data(), overlong.size()) == 2);
+        std::string surrogate = "\xed\xa0\x80";
+        assert(k->validateUtf8(surrogate.data(), surrogate.size()) == 0);
+        std::string truncated = "x\xe2\x82";
+        assert(k->validateUtf8(truncated.data(), truncated.size()) == 1);
+    }
+
+    std::cout << "Scalar kernel tests passed!" << std::endl;
+}
+
+void test_dispatch() {
+    std::vector<std::string> names = availableKernels();
+    assert(!names.empty());
+    assert(names.back() == "scalar");
+    assert(kernelsFor("no-such-kernel") == nullptr);
+
+    // Whatever was selected must be one of the available implementations
+    std::string selected = kernels().name;
+    bool found = false;
+    for (const std::string& name : names) {
+        found = found || name == selected;
+    }
+    assert(found);
+
+    std::cout << "Dispatch tests passed (selected " << selected << ")"
+              << std::endl;
+}
+
+int main() {
+    test_scalar_kernels();
+    test_kernels_match_scalar();
+    test_utf8_kernels();
+    test_dispatch();
+    std::cout << "All kernel tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -163,6 +163,37 @@ void test_number_tokenization() {
         assert(tokens[0].lexeme == "-123.456");
     }
 
+    // Test case 4: Exponents and zero
+    {
+        std::string json = "[0, -0.5, 1e10, 2E-3, 4.5e+6]";
+        Lexer lexer(json.data(), json.size());
+        auto tokens = lexer.tokenize();
+
+        assert(tokens.size() == 11);
+        assert(tokens[1].lexeme == "0");
+        assert(tokens[3].lexeme == "-0.5");
+        assert(tokens[5].lexeme == "1e10");
+        assert(tokens[7].lexeme == "2E-3");
+        assert(tokens[9].lexeme == "4.5e+6");
+    }
+
+    // Test case 5: Malformed numbers
+    {
+        const char* cases[] = {"01", "-", "1.", "1.2.3", "1e", "1e+"};
+        const ErrorCode expected[] = {ErrorCode::INVALID_NUMBER,
+                                      ErrorCode::INVALID_NUMBER,
+                                      ErrorCode::EXPECTED_FRACTION_DIGIT,
+                                      ErrorCode::MULTIPLE_DECIMAL_POINTS,
+                                      ErrorCode::EXPECTED_EXPONENT_DIGIT,
+                                      ErrorCode::EXPECTED_EXPONENT_DIGIT};
+        for (size_t i = 0; i < 6; i++) {
+            std::string json = cases[i];
+            Lexer lexer(json.data(), json.size());
+            std::vector<Token> tokens;
+            assert(lexer.tryTokenize(tokens).code == expected[i]);
+        }
+    }
+
     std::cout << "All number tokenization tests passed!" << std::endl;
 }
 
@@ -315,11 +346,323 @@ void test_structural_tokens() {
     std::cout << "All structural token tests passed!" << std::endl;
 }
 
+void test_no_throw_errors() {
+    // Test case 1: Valid input reports success
+    {
+        std::ofstream testFile(getTestFilePath("test_nothrow1.json"));
+        testFile << R"({"key": [1, true]})";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("test_nothrow1.json"));
+        std::vector<Token> tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+
+        assert(result.ok());
+        assert(tokens.size() == 9);
+    }
+
+    // Test case 2: Invalid character reports code and offset
+    {
+        std::ofstream testFile(getTestFilePath("test_nothrow2.json"));
+        testFile << "[1, @]";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("test_nothrow2.json"));
+        std::vector<Token> tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+
+        assert(result.code == ErrorCode::INVALID_CHARACTER);
+        assert(result.offset == 4);
+        assert(result.message().find("Invalid character: @") !=
+               std::string::npos);
+    }
+
+    // Test case 3: Invalid escape sequence
+    {
+        std::ofstream testFile(getTestFilePath("test_nothrow3.json"));
+        testFile << R"("Hello\a")";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("test_nothrow3.json"));
+        std::vector<Token> tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+
+        assert(result.code == ErrorCode::INVALID_ESCAPE);
+        assert(result.detail == 'a');
+    }
+
+    // Test case 4: Empty input
+    {
+        std::ofstream testFile(getTestFilePath("test_nothrow4.json"));
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("test_nothrow4.json"));
+        std::vector<Token> tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+
+        assert(result.code == ErrorCode::EMPTY_INPUT);
+    }
+
+    // Test case 5: The throwing wrapper reports the same message
+    {
+        std::ofstream testFile(getTestFilePath("test_nothrow5.json"));
+        testFile << "nulx";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("test_nothrow5.json"));
+        bool caught_exception = false;
+        try {
+            auto tokens = lexer.tokenize();
+        } catch (const std::runtime_error& e) {
+            caught_exception = true;
+            assert(std::string(e.what()).find(
+                       "Invalid literal: expected 'null'") !=
+                   std::string::npos);
+        }
+        assert(caught_exception);
+    }
+
+    std::cout << "All no-throw lexer tests passed!" << std::endl;
+}
+
+void test_token_buffer() {
+    // Test case 1: Types and offsets without lexemes
+    {
+        std::string json = R"({"a\tb": [12, true]})";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        assert(tokens.size() == 9);
+        assert(tokens.type(0) == TokenType::LEFT_BRACE);
+        assert(tokens.type(1) == TokenType::STRING);
+        assert(tokens.offset(1) == 1);
+        assert(tokens.type(4) == TokenType::NUMBER);
+        assert(tokens.offset(4) == json.find("12"));
+        assert(tokens.endOffset() == json.size());
+    }
+
+    // Test case 2: Lexemes are recovered from the input on request
+    {
+        std::string json = R"(["a\tb", -1.5e3, null, {}])";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        assert(lexer.lexeme(tokens, 1) == "a\tb");
+        assert(lexer.lexeme(tokens, 3) == "-1.5e3");
+        assert(lexer.lexeme(tokens, 5) == "null");
+        assert(lexer.lexeme(tokens, 7) == "{");
+    }
+
+    // Test case 3: The Token vector carries byte offsets
+    {
+        std::string json = "[1, 22]";
+        Lexer lexer(json.data(), json.size());
+        auto tokens = lexer.tokenize();
+
+        assert(tokens.size() == 5);
+        assert(tokens[3].lexeme == "22");
+        assert(tokens[3].offset == 4);
+    }
+
+    std::cout << "All token buffer tests passed!" << std::endl;
+}
+
+void test_lazy_strings() {
+    // Test case 1: Strings without escapes are views into the input
+    {
+        std::string json = R"({"plain": "value"})";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        assert(!tokens.hasEscapes(1));
+        std::string scratch;
+        StringRef key = lexer.string(tokens, 1, scratch);
+        assert(key == "plain");
+        assert(key.data == json.data() + 2);
+        assert(scratch.empty());
+    }
+
+    // Test case 2: Escaped strings are decoded only on request
+    {
+        std::string json = R"(["a\nb\"c", "x"])";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        assert(tokens.hasEscapes(1));
+        assert(tokens.type(1) == TokenType::STRING);
+        assert(!tokens.hasEscapes(3));
+        assert(lexer.rawString(tokens, 1) == "a\\nb\\\"c");
+
+        std::string scratch;
+        StringRef value = lexer.string(tokens, 1, scratch);
+        assert(value == "a\nb\"c");
+        assert(value.data == scratch.data());
+    }
+
+    // Test case 3: Unicode escapes, including surrogate pairs
+    {
+        std::string json =
+            R"(["caf\u00e9", "\u20AC", "\ud83d\ude00", "\ud800x"])";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        assert(lexer.lexeme(tokens, 1) == "caf\xc3\xa9");
+        assert(lexer.lexeme(tokens, 3) == "\xe2\x82\xac");
+        assert(lexer.lexeme(tokens, 5) == "\xf0\x9f\x98\x80");
+        assert(lexer.lexeme(tokens, 7) == "\xef\xbf\xbdx");  // Lone surrogate
+    }
+
+    // Test case 4: Malformed unicode escapes
+    {
+        std::string json = R"("\u12G4")";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        ParseResult result = lexer.tryTokenize(tokens);
+        assert(result.code == ErrorCode::INVALID_ESCAPE);
+        assert(result.offset == 2);
+
+        std::string truncated = R"("\u12)";
+        Lexer short_lexer(truncated.data(), truncated.size());
+        assert(short_lexer.tryTokenize(tokens).code ==
+               ErrorCode::INVALID_ESCAPE);
+    }
+
+    std::cout << "All lazy string tests passed!" << std::endl;
+}
+
+// Tokenizes `json` with and without `shapes` and checks both agree
+bool lexesAlike(const std::string& json, KeyShapes& shapes,
+                ErrorCode code = ErrorCode::NONE) {
+    Lexer plain(json.data(), json.size());
+    TokenBuffer expected;
+    assert(plain.tryTokenize(expected).code == code);
+
+    Lexer predicting(json.data(), json.size());
+    predicting.predictKeys(&shapes);
+    TokenBuffer tokens;
+    ParseResult result = predicting.tryTokenize(tokens);
+    if (result.code != code || tokens.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens.type(i) != expected.type(i) ||
+            tokens.offset(i) != expected.offset(i) ||
+            tokens.hasEscapes(i) != expected.hasEscapes(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_key_prediction() {
+    // Test case 1: Records of one shape hit after the first
+    {
+        KeyShapes shapes;
+        for (int i = 0; i < 10; i++) {
+            std::string record = R"({"id": )" + std::to_string(i) +
+                                 R"(, "user": {"name": "a\tb", "tags": [)"
+                                 R"({"k": 1}, {"k": 2}]}, "ok": true})";
+            assert(lexesAlike(record, shapes));
+        }
+        // 7 keys per record. The first record's are learned, except the
+        // second "k", whose array element shares the first one's shape.
+        assert(shapes.lookups() == 70);
+        assert(shapes.hits() == 64);
+        assert(shapes.hitRate() > 0.9);
+    }
+
+    // Test case 2: Changed, missing and extra keys fall back to a scan
+    {
+        KeyShapes shapes;
+        assert(lexesAlike(R"({"a": 1, "b": {"c": 2}})", shapes));
+        assert(lexesAlike(R"({"a": 1, "x": {"c": 2}, "d": 3})", shapes));
+        assert(lexesAlike(R"({"a": 1})", shapes));
+        assert(lexesAlike(R"({"ab": 1, "x": 2, "d": [3]})", shapes));
+        assert(lexesAlike(R"({"a\"": 1, "x": {"c": 2}})", shapes));
+        assert(lexesAlike(R"([{"a": 1}, {"a": 2}, [{"a": 3}]])", shapes));
+        assert(lexesAlike(R"({"x": {"c": {"c": {}}}, "x": []})", shapes));
+
+        // A prefix of the expected key, and the key as a value
+        assert(lexesAlike(R"({"x": "x", "xx": 1})", shapes));
+        assert(lexesAlike(R"({"x)", shapes, ErrorCode::UNTERMINATED_STRING));
+        assert(lexesAlike(R"({"x": 1, "xx"})", shapes));
+        assert(shapes.hits() > 0);
+        assert(shapes.hits() < shapes.lookups());
+    }
+
+    // Test case 3: Errors are reported where they were without prediction
+    {
+        KeyShapes shapes;
+        assert(lexesAlike(R"({"a": "b"})", shapes));
+        assert(lexesAlike(R"({"a": "b\q"})", shapes,
+                          ErrorCode::INVALID_ESCAPE));
+        assert(lexesAlike(R"({"a\q": 1})", shapes,
+                          ErrorCode::INVALID_ESCAPE));
+        assert(lexesAlike(R"({"a": @})", shapes,
+                          ErrorCode::INVALID_CHARACTER));
+        assert(lexesAlike(R"({1: "a", "a": 1})", shapes));
+    }
+
+    // Test case 4: Wide objects and changing keys stay bounded
+    {
+        KeyShapes shapes;
+        for (int round = 0; round < 3; round++) {
+            std::string json = "{";
+            for (size_t i = 0; i < KeyShapes::kMaxMembers + 10; i++) {
+                json += (i > 0 ? ", \"" : "\"") + std::to_string(i) +
+                        "\": 0";
+            }
+            assert(lexesAlike(json + "}", shapes));
+        }
+        assert(shapes.hits() == KeyShapes::kMaxMembers * 2);
+
+        // Keys that are really data outgrow kMaxKeyBytes and are relearned
+        std::string big(KeyShapes::kMaxKeyBytes / 4, 'k');
+        for (int i = 0; i < 10; i++) {
+            std::string json = R"({")" + big + std::to_string(i) +
+                               R"(": 1, "v": 2})";
+            assert(lexesAlike(json, shapes));
+        }
+
+        shapes.clear();
+        assert(shapes.lookups() == 0);
+        assert(shapes.hitRate() == 0);
+    }
+
+    // Test case 5: Input that ends inside an object leaves no prediction
+    // state for seek() and next()
+    {
+        KeyShapes shapes;
+        std::string json = R"({"a": 1, )";
+        Lexer lexer(json.data(), json.size());
+        lexer.predictKeys(&shapes);
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+
+        TokenBuffer again;
+        lexer.seek(1);
+        assert(lexer.next(again));
+        assert(again.size() == 1 && again.type(0) == TokenType::STRING);
+        assert(again.offset(0) == 1);
+    }
+
+    std::cout << "Key prediction tests passed!" << std::endl;
+}
+
 int main() {
     // test_string_tokenization();
     test_number_tokenization();
     // test_special_tokens();
     // test_structural_tokens();
+    test_no_throw_errors();
+    test_token_buffer();
+    test_lazy_strings();
+    test_key_prediction();
     std::cout << "All tests passed successfully!" << std::endl;
     return 0;
 }
@@ -0,0 +1,232 @@
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "document.h"
+#include "lexer.h"
+#include "memory.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+// An object with `count` members, one of which has escapes
+std::string makeObject(size_t count) {
+    std::string json = "{";
+    for (size_t i = 0; i < count; i++) {
+        json += (i > 0 ? ", \"key" : "\"key") + std::to_string(i) +
+                "\": [" + std::to_string(i) + ", \"v\\n\"]";
+    }
+    return json + "}";
+}
+
+void test_memory_account() {
+    // Test case 1: Counting allocations
+    {
+        MemoryAccount account;
+        void* a = account.allocate(100);
+        void* b = account.allocate(50, 16);
+        assert(account.stats().allocations == 2);
+        assert(account.stats().bytesAllocated == 150);
+        assert(account.stats().bytesInUse == 150);
+        account.deallocate(a, 100);
+        assert(account.stats().bytesInUse == 50);
+        assert(account.stats().peakBytes == 150);
+
+        account.resetStats();
+        assert(account.stats().allocations == 0);
+        assert(account.stats().bytesAllocated == 0);
+        assert(account.stats().peakBytes == 50);
+        account.deallocate(b, 50, 16);
+        assert(account.stats().bytesInUse == 0);
+    }
+
+    // Test case 2: The limit is checked before upstream is asked
+    {
+        MemoryAccount upstream;
+        MemoryAccount account(&upstream);
+        account.setLimit(100);
+        void* a = account.allocate(60);
+        bool threw = false;
+        try {
+            a = account.allocate(41);
+        } catch (const MemoryLimitExceeded&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(upstream.stats().allocations == 1);
+        void* b = account.allocate(40);
+        assert(account.stats().bytesInUse == 100);
+        account.deallocate(b, 40);
+        account.deallocate(a, 60);
+        assert(upstream.stats().bytesInUse == 0);
+    }
+
+    // Test case 3: Containers allocate through it
+    {
+        char arena[4096];
+        std::pmr::monotonic_buffer_resource buffer(arena, sizeof(arena));
+        MemoryAccount account(&buffer);
+        {
+            TokenBuffer tokens(&account);
+            assert(tokens.resource() == &account);
+            tokens.push(TokenType::NULL_TOKEN, 0);
+            assert(account.stats().allocations == 2);
+            TokenBuffer moved(std::move(tokens));
+            assert(moved.resource() == &account);
+            TokenBuffer copied(moved);
+            assert(copied.resource() != &account);
+            assert(account.stats().allocations == 2);
+        }
+        assert(account.stats().bytesInUse == 0);
+    }
+
+    std::cout << "Memory account tests passed!" << std::endl;
+}
+
+void test_parse_limits() {
+    // Test case 1: Lexer and Parser report the offset where memory ran out
+    {
+        std::string json = "[";
+        for (int i = 0; i < 2000; i++) {
+            json += i > 0 ? ",1" : "1";
+        }
+        json += "]";
+
+        MemoryAccount account;
+        account.setLimit(1000);
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens(&account);
+        ParseResult result = lexer.tryTokenize(tokens);
+        assert(result.code == ErrorCode::MEMORY_LIMIT_EXCEEDED);
+        assert(result.offset > 0 && result.offset < json.size());
+        assert(account.stats().bytesInUse <= 1000);
+
+        assert(tokens.empty());
+        account.setLimit(0);
+        assert(lexer.tryTokenize(tokens).ok());
+    }
+
+    // Test case 2: Strict mode's key sets are counted
+    {
+        std::string json = makeObject(200);
+        MemoryAccount account;
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens(&account);
+        assert(lexer.tryTokenize(tokens).ok());
+        size_t tokenBytes = account.stats().bytesInUse;
+
+        Parser parser(std::move(tokens));
+        parser.checkDuplicateKeys(&lexer);
+        account.setLimit(tokenBytes + 256);
+        ParseResult result = parser.tryParse();
+        assert(result.code == ErrorCode::MEMORY_LIMIT_EXCEEDED);
+        assert(result.offset > 0);
+        account.setLimit(0);
+        assert(parser.tryParse().ok());
+        assert(account.stats().peakBytes > tokenBytes);
+    }
+
+    // Test case 3: Escaped keys are decoded into counted memory
+    {
+        std::string json = "{\"" + std::string(4096, 'k') + "\\n\": 1}";
+        MemoryAccount account;
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens(&account);
+        assert(lexer.tryTokenize(tokens).ok());
+        size_t tokenBytes = account.stats().bytesInUse;
+
+        Parser parser(std::move(tokens));
+        parser.checkDuplicateKeys(&lexer);
+        account.setLimit(tokenBytes + 1024);
+        assert(parser.tryParse().code == ErrorCode::MEMORY_LIMIT_EXCEEDED);
+        account.setLimit(0);
+        assert(parser.tryParse().ok());
+        assert(account.stats().peakBytes > tokenBytes + 4096);
+    }
+
+    std::cout << "Parse memory limit tests passed!" << std::endl;
+}
+
+void test_document_memory() {
+    // Test case 1: Statistics of a parse
+    {
+        std::string json = makeObject(100);
+        Document document;
+        assert(document.parse(json).ok());
+        MemoryStats stats = document.memoryStats();
+        assert(stats.allocations > 0);
+        assert(stats.bytesInUse >= document.view().tapeSize * 8 +
+                                       document.view().stringsSize);
+        assert(stats.peakBytes > stats.bytesInUse);  // Tokens were freed
+        assert(stats.bytesAllocated >= stats.peakBytes);
+
+        // A new parse starts new counts; the tape's capacity is kept
+        assert(document.parse("[1]").ok());
+        assert(document.memoryStats().allocations < stats.allocations);
+        assert(document.memoryStats().bytesInUse == stats.bytesInUse);
+    }
+
+    // Test case 2: A budget fails oversize documents and leaves them empty
+    {
+        std::string json = makeObject(1000);
+        Document document;
+        document.setMemoryLimit(4096);
+        ParseResult result = document.parse(json);
+        assert(result.code == ErrorCode::MEMORY_LIMIT_EXCEEDED);
+        assert(result.offset < json.size());
+        assert(document.empty());
+        assert(!document.root().exists());
+        assert(document.memoryStats().peakBytes <= 4096);
+
+        assert(document.parse(makeObject(3)).ok());
+        assert(document.root()["key2"][0].asInt64() == 2);
+        document.setMemoryLimit(0);
+        assert(document.parse(json).ok());
+    }
+
+    // Test case 3: A user-supplied upstream resource gets every allocation
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        MemoryAccount upstream(&arena);
+        {
+            Document document(&upstream);
+            document.checkDuplicateKeys(true);
+            assert(document.parse(makeObject(50)).ok());
+            assert(document.root()["key49"][1].asString() == "v\n");
+            assert(upstream.stats().allocations ==
+                   document.memoryStats().allocations);
+            assert(upstream.stats().bytesInUse ==
+                   document.memoryStats().bytesInUse);
+        }
+        assert(upstream.stats().bytesInUse == 0);
+    }
+
+    // Test case 4: Large objects are scanned when their index doesn't fit
+    {
+        std::string json = makeObject(ObjectIndex::kMinMembers * 4);
+        Document document;
+        assert(document.parse(json).ok());
+        size_t parsed = document.memoryStats().bytesInUse;
+        document.setMemoryLimit(parsed + 16);
+        assert(document.root()["key100"][0].asInt64() == 100);
+        assert(!document.root()["missing"].exists());
+        assert(document.memoryStats().bytesInUse == parsed);
+
+        document.setMemoryLimit(0);
+        size_t before = document.memoryStats().allocations;
+        assert(document.root()["key7"][0].asInt64() == 7);
+        assert(document.memoryStats().allocations > before);  // Indexed now
+    }
+
+    std::cout << "Document memory tests passed!" << std::endl;
+}
+
+int main() {
+    test_memory_account();
+    test_parse_limits();
+    test_document_memory();
+    std::cout << "All memory tests passed successfully!" << std::endl;
+    return 0;
+}
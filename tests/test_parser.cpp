@@ -143,11 +143,221 @@ void test_simple_arrays() {
     std::cout << "Simple array tests passed!" << std::endl;
 }
 
+void test_no_throw_parse() {
+    // Test case 1: Valid document
+    {
+        std::ofstream testFile(getTestFilePath("parser_nothrow1.json"));
+        testFile << R"({"a": [1, {"b": null}]})";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("parser_nothrow1.json"));
+        Parser parser(lexer.tokenize());
+
+        assert(parser.tryParse().ok());
+    }
+
+    // Test case 2: Trailing comma reports code and byte offset
+    {
+        std::ofstream testFile(getTestFilePath("parser_nothrow2.json"));
+        testFile << R"([1, 2,])";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("parser_nothrow2.json"));
+        Parser parser(lexer.tokenize());
+        ParseResult result = parser.tryParse();
+
+        assert(result.code == ErrorCode::TRAILING_COMMA_IN_ARRAY);
+        assert(result.offset == 6);
+    }
+
+    // Test case 3: Missing value at end of input
+    {
+        std::ofstream testFile(getTestFilePath("parser_nothrow3.json"));
+        testFile << R"({"key":)";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("parser_nothrow3.json"));
+        Parser parser(lexer.tokenize());
+
+        assert(parser.tryParse().code == ErrorCode::UNEXPECTED_END_OF_INPUT);
+    }
+
+    // Test case 4: The throwing wrapper still throws
+    {
+        std::ofstream testFile(getTestFilePath("parser_nothrow4.json"));
+        testFile << R"({"key" "value"})";
+        testFile.close();
+
+        Lexer lexer(getTestFilePath("parser_nothrow4.json"));
+        Parser parser(lexer.tokenize());
+        bool caught_exception = false;
+        try {
+            parser.parse();
+        } catch (const std::runtime_error& e) {
+            caught_exception = true;
+        }
+        assert(caught_exception);
+    }
+
+    std::cout << "No-throw parser tests passed!" << std::endl;
+}
+
+void test_token_buffer_parse() {
+    // Test case 1: Long scalar arrays take the vectorized fast path
+    {
+        std::string json = "[";
+        for (int i = 0; i < 100; i++) {
+            json += (i % 2 ? "\"s\", " : "1, ");
+        }
+        json += "null, [true, false], {\"a\": [1, 2, 3]}]";
+
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        assert(parser.tryParse().ok());
+    }
+
+    // Test case 2: Trailing comma after a long run of scalars
+    {
+        std::string json = "[";
+        for (int i = 0; i < 40; i++) {
+            json += "1,";
+        }
+        json += "]";
+
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        ParseResult result = parser.tryParse();
+        assert(result.code == ErrorCode::TRAILING_COMMA_IN_ARRAY);
+        assert(result.offset == json.size() - 1);
+    }
+
+    // Test case 3: Missing comma inside a run of scalars
+    {
+        std::string json = "[1, 2, 3, 4, 5, 6, 7, 8, 9 10, 11, 12, 13]";
+
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        ParseResult result = parser.tryParse();
+        assert(result.code == ErrorCode::EXPECTED_DIFFERENT_TOKEN);
+        assert(result.offset == json.find("10"));
+    }
+
+    // Test case 4: Unexpected end of input reports the input length
+    {
+        std::string json = R"({"key": [1, 2)";
+
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        ParseResult result = parser.tryParse();
+        assert(result.code == ErrorCode::UNEXPECTED_END_OF_INPUT);
+        assert(result.offset == json.size());
+    }
+
+    std::cout << "TokenBuffer parser tests passed!" << std::endl;
+}
+
+// Parses `json` with duplicate keys rejected
+ParseResult parseStrict(const std::string& json) {
+    Lexer lexer(json.data(), json.size());
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    assert(result.ok());
+    Parser parser(std::move(tokens));
+    parser.checkDuplicateKeys(&lexer);
+    return parser.tryParse();
+}
+
+// An object with keys "k0".."k<count - 1>", then `extra` members
+std::string objectWithKeys(size_t count, const std::string& extra) {
+    std::string json = "{";
+    for (size_t i = 0; i < count; i++) {
+        json += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+    }
+    return json + extra + "}";
+}
+
+void test_duplicate_keys() {
+    // Test case 1: Off by default, reported at the second key in strict mode
+    {
+        std::string json = R"({"a": 1, "b": 2, "a": 3})";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(tokens);
+        assert(parser.tryParse().ok());
+
+        ParseResult result = parseStrict(json);
+        assert(result.code == ErrorCode::DUPLICATE_KEY);
+        assert(result.offset == json.rfind("\"a\""));
+    }
+
+    // Test case 2: Keys are compared decoded and per object
+    {
+        assert(parseStrict(R"({"a": 1, "\u0061": 2})").code ==
+               ErrorCode::DUPLICATE_KEY);
+        assert(parseStrict(R"({"\n": 1, "\u000a": 2})").code ==
+               ErrorCode::DUPLICATE_KEY);
+        assert(parseStrict(R"({"a": 1, "A": 2, "a ": 3, "": 4})").ok());
+        assert(parseStrict(R"({"a": {"a": {"a": 1}}, "b": [{"a": 2}]})").ok());
+        assert(parseStrict(R"([{"a": 1}, {"a": 2}])").ok());
+        assert(parseStrict(R"({"a": {"b": 1}, "b": {"a": 2, "a": 3}})").code ==
+               ErrorCode::DUPLICATE_KEY);
+    }
+
+    // Test case 3: Objects past the inline limit switch to a hash set
+    {
+        assert(parseStrict(objectWithKeys(1000, "\"x\": 0")).ok());
+        for (size_t count : {3, 15, 16, 17, 40, 1000}) {
+            std::string json = objectWithKeys(count, "\"k2\": 0");
+            ParseResult result = parseStrict(json);
+            assert(result.code == ErrorCode::DUPLICATE_KEY);
+            assert(result.offset == json.rfind("\"k2\""));
+        }
+    }
+
+    // Test case 4: Nested large objects each get their own set
+    {
+        std::string inner = objectWithKeys(100, "\"z\": 1");
+        std::string json = objectWithKeys(50, "\"inner\": " + inner + ", " +
+                                                  "\"other\": " + inner);
+        assert(parseStrict(json).ok());
+        json = objectWithKeys(50, "\"inner\": " + inner + ", \"k49\": 1");
+        assert(parseStrict(json).code == ErrorCode::DUPLICATE_KEY);
+    }
+
+    // Test case 5: The parser can be reused after a failure
+    {
+        std::string json = objectWithKeys(40, "\"k1\": 0");
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        parser.checkDuplicateKeys(&lexer);
+        assert(parser.tryParse().code == ErrorCode::DUPLICATE_KEY);
+        assert(parser.tryParse().code == ErrorCode::DUPLICATE_KEY);
+        parser.checkDuplicateKeys(nullptr);
+        assert(parser.tryParse().ok());
+    }
+
+    std::cout << "Duplicate key tests passed!" << std::endl;
+}
+
 int main() {
     test_empty_json();
     test_simple_values();
     test_simple_objects();
     test_simple_arrays();
+    test_no_throw_parse();
+    test_token_buffer_parse();
+    test_duplicate_keys();
     std::cout << "All parser tests passed successfully!" << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "projection.h"
+
+Projection makeProjection(const std::vector<std::string>& paths) {
+    Projection projection;
+    for (const std::string& path : paths) {
+        assert(projection.addPath(path).ok());
+    }
+    return projection;
+}
+
+void test_paths() {
+    // Test case 1: Valid pointers, including escapes and the whole document
+    {
+        Projection projection;
+        assert(projection.addPath("/a/b").ok());
+        assert(projection.addPath("/a~1b/c~0d").ok());
+        assert(projection.addPath("").ok());
+        assert(projection.addPath("/a/b").ok());  // Duplicates are allowed
+        assert(projection.fieldCount() == 4);
+        assert(projection.path(1) == "/a~1b/c~0d");
+    }
+
+    // Test case 2: Malformed pointers
+    {
+        Projection projection;
+        ParseResult result = projection.addPath("a/b");
+        assert(result.code == ErrorCode::INVALID_JSON_POINTER);
+        result = projection.addPath("/a~2");
+        assert(result.code == ErrorCode::INVALID_JSON_POINTER);
+        assert(result.offset == 2);
+        assert(projection.fieldCount() == 0);
+    }
+
+    std::cout << "Path tests passed!" << std::endl;
+}
+
+void test_project_record() {
+    Projection projection = makeProjection(
+        {"/id", "/user/name", "/tags/1", "/missing", "/user", "/a~1b"});
+    std::vector<StringRef> values;
+
+    // Test case 1: Raw values are returned unchanged
+    {
+        std::string record =
+            R"({"id": 7, "skip": {"x": ["]", "}"]}, "user": {"name": "A\"B",)"
+            R"( "age": 3}, "tags": ["x", [1, 2], true], "a/b": 1.5e3})";
+        assert(projection.project(record.data(), record.size(), values).ok());
+        assert(values.size() == 6);
+        assert(values[0] == "7");
+        assert(values[1] == "\"A\\\"B\"");
+        assert(values[2] == "[1, 2]");
+        assert(values[3].data == nullptr);
+        assert(values[4] == R"({"name": "A\"B", "age": 3})");
+        assert(values[5] == "1.5e3");
+    }
+
+    // Test case 2: Escaped keys match their unescaped path
+    {
+        Projection escaped = makeProjection({"/tab\tkey"});
+        std::string record = R"({"tab\tkey": null})";
+        assert(escaped.project(record.data(), record.size(), values).ok());
+        assert(values[0] == "null");
+    }
+
+    // Test case 3: Scanning stops once every field is found
+    {
+        Projection first = makeProjection({"/id"});
+        std::string record = R"({"id": 1, "rest": [unparsed garbage)";
+        assert(first.project(record.data(), record.size(), values).ok());
+        assert(values[0] == "1");
+    }
+
+    // Test case 4: Malformed records
+    {
+        std::string record = R"({"id": 1, "user": {"name": "x")";
+        ParseResult result =
+            projection.project(record.data(), record.size(), values);
+        assert(result.code == ErrorCode::UNEXPECTED_END_OF_INPUT);
+
+        record = R"({"id": 1, "other": "unterminated})";
+        result = projection.project(record.data(), record.size(), values);
+        assert(result.code == ErrorCode::UNTERMINATED_STRING);
+
+        record = R"({"id": 1,})";
+        result = projection.project(record.data(), record.size(), values);
+        assert(result.code == ErrorCode::TRAILING_COMMA_IN_OBJECT);
+        assert(result.offset == 9);
+
+        record = R"({"user": {}} extra)";
+        result = projection.project(record.data(), record.size(), values);
+        assert(result.code == ErrorCode::EXPECTED_END_OF_INPUT);
+    }
+
+    std::cout << "Record projection tests passed!" << std::endl;
+}
+
+void test_project_lines() {
+    Projection projection = makeProjection({"/id", "/name"});
+    ProjectionOptions options;
+
+    // Test case 1: NDJSON output, blank lines skipped
+    {
+        std::string input =
+            "{\"id\": 1, \"name\": \"a\"}\n\n  \r\n{\"id\": 2}\n";
+        std::string output;
+        assert(projection.projectLines(input.data(), input.size(), options,
+                                       output)
+                   .ok());
+        assert(output ==
+               "{\"/id\":1,\"/name\":\"a\"}\n{\"/id\":2,\"/name\":null}\n");
+    }
+
+    // Test case 2: TSV output
+    {
+        options.format = ProjectionFormat::TSV;
+        std::string input = "{\"name\": [1,\t2], \"id\": 1}\n{\"id\": 2}";
+        std::string output;
+        assert(projection.projectLines(input.data(), input.size(), options,
+                                       output)
+                   .ok());
+        assert(output == "1\t[1, 2]\n2\t\n");
+    }
+
+    // Test case 3: Threads produce the same output and error as one thread
+    {
+        std::string input;
+        for (int i = 0; i < 20000; i++) {
+            input += "{\"id\": " + std::to_string(i) +
+                     ", \"pad\": [\"........................\"], \"name\": "
+                     "\"n" + std::to_string(i) + "\"}\n";
+        }
+        ProjectionOptions single;
+        single.threads = 1;
+        ProjectionOptions parallel;
+        parallel.threads = 4;
+
+        std::string expected;
+        std::string output;
+        assert(projection.projectLines(input.data(), input.size(), single,
+                                       expected)
+                   .ok());
+        assert(projection.projectLines(input.data(), input.size(), parallel,
+                                       output)
+                   .ok());
+        assert(output == expected);
+
+        size_t bad = input.size() * 3 / 4;
+        bad = input.find("\"name\"", bad);
+        input[bad] = '?';
+        expected.clear();
+        output.clear();
+        ParseResult one =
+            projection.projectLines(input.data(), input.size(), single,
+                                    expected);
+        ParseResult many =
+            projection.projectLines(input.data(), input.size(), parallel,
+                                    output);
+        assert(one.code == ErrorCode::EXPECTED_STRING_KEY);
+        assert(one.offset == bad);
+        assert(many.code == one.code && many.offset == one.offset);
+        assert(output == expected);
+    }
+
+    std::cout << "Line projection tests passed!" << std::endl;
+}
+
+void test_project_stream() {
+    Projection projection = makeProjection({"/v"});
+
+    // Test case 1: Records spanning block boundaries
+    {
+        std::string input;
+        std::string expected;
+        for (int i = 0; i < 300; i++) {
+            input += "{\"v\": " + std::to_string(i) + "}\n";
+            expected += "{\"/v\":" + std::to_string(i) + "}\n";
+        }
+        input.pop_back();  // No newline after the last record
+
+        ProjectionOptions options;
+        options.blockSize = 7;
+        std::istringstream in(input);
+        std::ostringstream out;
+        assert(projection.projectStream(in, out, options).ok());
+        assert(out.str() == expected);
+    }
+
+    // Test case 2: Error offsets are relative to the whole stream
+    {
+        std::string input = "{\"v\": 1}\n{\"v\": 2}\n{\"v\": x}\n";
+        ProjectionOptions options;
+        options.blockSize = 10;
+        std::istringstream in(input);
+        std::ostringstream out;
+        ParseResult result = projection.projectStream(in, out, options);
+        assert(result.code == ErrorCode::INVALID_CHARACTER);
+        assert(result.offset == input.find('x'));
+        assert(out.str() == "{\"/v\":1}\n{\"/v\":2}\n");
+    }
+
+    std::cout << "Stream projection tests passed!" << std::endl;
+}
+
+int main() {
+    test_paths();
+    test_project_record();
+    test_project_lines();
+    test_project_stream();
+    std::cout << "All projection tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "document.h"
+#include "lexer.h"
+#include "parser.h"
+#include "schema.h"
+#include "token_buffer.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+// Compiles `schemaJson`, which must be valid, and parses `json` against it
+ParseResult check(const std::string& schemaJson, const std::string& json) {
+    Schema schema;
+    assert(schema.compile(schemaJson).ok());
+    Lexer lexer(json.data(), json.size());
+    TokenBuffer tokens;
+    ParseResult result = lexer.tryTokenize(tokens);
+    assert(result.ok());
+    Parser parser(std::move(tokens));
+    parser.checkSchema(&schema, &lexer);
+    return parser.tryParse();
+}
+
+void test_compile() {
+    // Test case 1: Trivial schemas accept anything without nodes
+    {
+        Schema schema;
+        assert(schema.root() == Schema::kAny);
+        assert(schema.compile("true").ok());
+        assert(schema.root() == Schema::kAny);
+        assert(schema.compile("{}").ok());
+        assert(schema.root() == Schema::kAny);
+        assert(schema.nodeCount() == 2);
+        assert(schema.compile(R"({"title": "t", "examples": [{"a": 1}]})")
+                   .ok());
+        assert(schema.root() == Schema::kAny);
+        assert(schema.compile("false").ok());
+        assert(schema.root() == Schema::kNever);
+    }
+
+    // Test case 2: Keywords land in the node
+    {
+        Schema schema;
+        assert(schema.compile(R"({
+            "type": ["integer", "null"],
+            "minimum": 0, "exclusiveMinimum": 0, "maximum": 10
+        })").ok());
+        const SchemaNode& node = schema.node(schema.root());
+        assert(node.types == (ST_INTEGER | ST_NULL));
+        assert(node.checksNumber);
+        assert(node.minimum == 0 && node.exclusiveMinimum);
+        assert(node.maximum == 10 && !node.exclusiveMaximum);
+        assert(!node.checksLength);
+    }
+
+    // Test case 3: Required keys join the listed properties
+    {
+        Schema schema;
+        assert(schema.compile(R"({
+            "properties": {"a": {"type": "string"}, "b": true},
+            "required": ["c", "a"]
+        })").ok());
+        uint32_t root = schema.root();
+        assert(schema.node(root).propertyCount == 3);
+        assert(schema.node(root).requiredCount == 2);
+        uint32_t a = schema.findProperty(root, StringRef("a"));
+        uint32_t c = schema.findProperty(root, StringRef("c"));
+        assert(schema.property(a).required == 1);
+        assert(schema.property(c).required == 0);
+        assert(schema.property(c).node == Schema::kAny);
+        assert(schema.property(schema.findProperty(root, StringRef("b")))
+                   .required == Schema::kNotRequired);
+        assert(schema.findProperty(root, StringRef("d")) ==
+               Schema::kNoProperty);
+    }
+
+    // Test case 4: Unsupported keywords and values are rejected where they
+    // are
+    {
+        Schema schema;
+        ParseResult result = schema.compile(R"({"pattern": "^a"})");
+        assert(result.code == ErrorCode::INVALID_SCHEMA);
+        assert(result.offset == 1);
+        assert(schema.root() == Schema::kAny);
+
+        result = schema.compile(R"({"type": "text"})");
+        assert(result.code == ErrorCode::INVALID_SCHEMA);
+        assert(result.offset == 9);
+        assert(schema.compile(R"({"type": []})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"enum": [[1]]})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"items": [{}]})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"minLength": -1})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"maxLength": 1.5})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"minimum": "1"})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile(R"({"required": [1]})").code ==
+               ErrorCode::INVALID_SCHEMA);
+        assert(schema.compile("3").code == ErrorCode::INVALID_SCHEMA);
+    }
+
+    // Test case 5: Bad JSON, repeated keywords and missing files
+    {
+        Schema schema;
+        assert(schema.compile(R"({"type": "string",})").code ==
+               ErrorCode::TRAILING_COMMA_IN_OBJECT);
+        assert(schema.compile(R"({"type": "string", "type": "null"})")
+                   .code == ErrorCode::DUPLICATE_KEY);
+        assert(schema.compileFile(getTestFilePath("no_schema.json")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+
+        std::ofstream file(getTestFilePath("schema_test1.json"));
+        file << R"({"type": "array", "items": {"type": "number"}})";
+        file.close();
+        assert(schema.compileFile(getTestFilePath("schema_test1.json")).ok());
+        assert(schema.node(schema.root()).types == ST_ARRAY);
+    }
+
+    std::cout << "Compile tests passed!" << std::endl;
+}
+
+void test_scalars() {
+    // Test case 1: Types
+    {
+        assert(check(R"({"type": "string"})", R"("a")").ok());
+        ParseResult result = check(R"({"type": "string"})", "[1]");
+        assert(result.code == ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(result.offset == 0);
+        assert(check(R"({"type": ["boolean", "null"]})", "false").ok());
+        assert(check(R"({"type": ["boolean", "null"]})", "null").ok());
+        assert(check(R"({"type": ["boolean", "null"]})", "{}").code ==
+               ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(check("false", "null").code ==
+               ErrorCode::SCHEMA_TYPE_MISMATCH);
+    }
+
+    // Test case 2: Integers are numbers without a fractional part
+    {
+        std::string schema = R"({"type": "integer"})";
+        assert(check(schema, "12").ok());
+        assert(check(schema, "1.0").ok());
+        assert(check(schema, "-2e3").ok());
+        assert(check(schema, "1.5").code == ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(check(schema, "\"1\"").code ==
+               ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(check(R"({"type": "number"})", "1.5").ok());
+    }
+
+    // Test case 3: Enums compare decoded strings and number values
+    {
+        std::string schema = R"({"enum": ["red", "gréen", 1, true]})";
+        assert(check(schema, R"("red")").ok());
+        assert(check(schema, R"("gréen")").ok());
+        assert(check(schema, R"("gr\u00e9en")").ok());
+        assert(check(schema, "1.0").ok());
+        assert(check(schema, "true").ok());
+        ParseResult result = check(schema, R"(["red"])");
+        assert(result.code == ErrorCode::SCHEMA_ENUM_MISMATCH);
+        assert(result.offset == 0);
+        result = check(R"({"items": )" + schema + "}", R"(["red", "blue"])");
+        assert(result.code == ErrorCode::SCHEMA_ENUM_MISMATCH);
+        assert(result.offset == 8);
+        assert(check(schema, "false").code ==
+               ErrorCode::SCHEMA_ENUM_MISMATCH);
+        assert(check(schema, "null").code == ErrorCode::SCHEMA_ENUM_MISMATCH);
+        assert(check(R"({"enum": []})", "1").code ==
+               ErrorCode::SCHEMA_ENUM_MISMATCH);
+    }
+
+    // Test case 4: Bounds, inclusive and exclusive
+    {
+        std::string schema = R"({"minimum": 0, "exclusiveMaximum": 10})";
+        assert(check(schema, "0").ok());
+        assert(check(schema, "9.99").ok());
+        assert(check(schema, "10").code == ErrorCode::SCHEMA_OUT_OF_RANGE);
+        assert(check(schema, "-1e-9").code ==
+               ErrorCode::SCHEMA_OUT_OF_RANGE);
+        assert(check(schema, "\"x\"").ok());  // Bounds only apply to numbers
+        assert(check(R"({"maximum": 5, "exclusiveMaximum": 5})", "5").code ==
+               ErrorCode::SCHEMA_OUT_OF_RANGE);
+    }
+
+    // Test case 5: String lengths count code points, after unescaping
+    {
+        std::string schema = R"({"minLength": 2, "maxLength": 3})";
+        assert(check(schema, R"("ab")").ok());
+        assert(check(schema, "\"\xc3\xa9\xe2\x82\xac\"").ok());
+        assert(check(schema, R"("é€😀")").ok());
+        assert(check(schema, R"("\n")").code ==
+               ErrorCode::SCHEMA_LENGTH_OUT_OF_RANGE);
+        assert(check(schema, R"("abcd")").code ==
+               ErrorCode::SCHEMA_LENGTH_OUT_OF_RANGE);
+        assert(check(schema, "7").ok());
+    }
+
+    std::cout << "Scalar tests passed!" << std::endl;
+}
+
+void test_containers() {
+    std::string schema = R"({
+        "type": "object",
+        "properties": {
+            "id": {"type": "integer", "minimum": 1},
+            "tags": {"type": "array", "items": {"type": "string"}},
+            "owner": {
+                "type": "object",
+                "properties": {"name": {"type": "string"}},
+                "required": ["name"]
+            }
+        },
+        "required": ["id", "tags"],
+        "additionalProperties": false
+    })";
+
+    // Test case 1: Valid documents
+    {
+        assert(check(schema, R"({"id": 1, "tags": []})").ok());
+        assert(check(schema, R"({"tags": ["a", "b"], "id": 7,
+                                 "owner": {"name": "x", "extra": [1]}})")
+                   .ok());
+    }
+
+    // Test case 2: Missing properties fail at the closing brace
+    {
+        std::string json = R"({"id": 1})";
+        ParseResult result = check(schema, json);
+        assert(result.code == ErrorCode::SCHEMA_MISSING_PROPERTY);
+        assert(result.offset == json.size() - 1);
+        assert(check(schema, "{}").code ==
+               ErrorCode::SCHEMA_MISSING_PROPERTY);
+
+        json = R"({"id": 1, "tags": [], "owner": {}})";
+        result = check(schema, json);
+        assert(result.code == ErrorCode::SCHEMA_MISSING_PROPERTY);
+        assert(result.offset == json.size() - 2);
+
+        // Repeating a required key doesn't count twice
+        assert(check(schema, R"({"id": 1, "id": 2})").code ==
+               ErrorCode::SCHEMA_MISSING_PROPERTY);
+    }
+
+    // Test case 3: Properties not listed fail at their key
+    {
+        std::string json = R"({"id": 1, "tags": [], "size": 3})";
+        ParseResult result = check(schema, json);
+        assert(result.code == ErrorCode::SCHEMA_ADDITIONAL_PROPERTY);
+        assert(result.offset == json.find("\"size\""));
+
+        std::string typed = R"({"additionalProperties": {"type": "number"}})";
+        assert(check(typed, R"({"a": 1, "b": 2})").ok());
+        assert(check(typed, R"({"a": 1, "b": "2"})").code ==
+               ErrorCode::SCHEMA_TYPE_MISMATCH);
+    }
+
+    // Test case 4: Nested values are checked against their own schemas
+    {
+        std::string json = R"({"id": 1, "tags": ["a", 2, "c"]})";
+        ParseResult result = check(schema, json);
+        assert(result.code == ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(result.offset == json.find('2'));
+        assert(check(schema, R"({"id": 0, "tags": []})").code ==
+               ErrorCode::SCHEMA_OUT_OF_RANGE);
+        assert(check(schema, R"([{"id": 1, "tags": []}])").code ==
+               ErrorCode::SCHEMA_TYPE_MISMATCH);
+    }
+
+    // Test case 5: Long runs of scalar elements are still checked one by one
+    {
+        std::string json = "[";
+        for (int i = 0; i < 100; i++) {
+            json += std::to_string(i) + ", ";
+        }
+        json += "\"x\", 1]";
+        ParseResult result = check(R"({"items": {"type": "integer"}})", json);
+        assert(result.code == ErrorCode::SCHEMA_TYPE_MISMATCH);
+        assert(result.offset == json.find('"'));
+        assert(check(R"({"items": {"maximum": 99}})", json).ok());
+        assert(check(R"({"type": "array"})", json).ok());
+    }
+
+    // Test case 6: More than 64 required properties
+    {
+        std::string many = R"({"required": [)";
+        std::string json = "{";
+        for (int i = 0; i < 70; i++) {
+            many += (i > 0 ? ", \"k" : "\"k") + std::to_string(i) + "\"";
+            json += (i > 0 ? ", \"k" : "\"k") + std::to_string(i) + "\": {}";
+        }
+        many += "]}";
+        assert(check(many, json + "}").ok());
+        assert(check(many, json.substr(0, json.rfind(',')) + "}").code ==
+               ErrorCode::SCHEMA_MISSING_PROPERTY);
+    }
+
+    std::cout << "Container tests passed!" << std::endl;
+}
+
+void test_document() {
+    Schema schema;
+    assert(schema.compile(R"({"type": "object", "required": ["a"]})").ok());
+
+    // Test case 1: A document that breaks the schema is left empty
+    {
+        Document doc;
+        doc.checkSchema(&schema);
+        assert(doc.parse(R"({"a": [1, 2]})").ok());
+        assert(doc.root()["a"][1].asDouble() == 2);
+        assert(doc.parse(R"({"b": 1})").code ==
+               ErrorCode::SCHEMA_MISSING_PROPERTY);
+        assert(doc.empty());
+    }
+
+    // Test case 2: Turning the check off
+    {
+        Document doc;
+        doc.checkSchema(&schema);
+        assert(!doc.parse("[]").ok());
+        doc.checkSchema(nullptr);
+        assert(doc.parse("[]").ok());
+    }
+
+    // Test case 3: One parser, reused after a failure
+    {
+        std::string json = R"({"b": 1})";
+        Lexer lexer(json.data(), json.size());
+        TokenBuffer tokens;
+        assert(lexer.tryTokenize(tokens).ok());
+        Parser parser(std::move(tokens));
+        parser.checkSchema(&schema, &lexer);
+        assert(parser.tryParse().code == ErrorCode::SCHEMA_MISSING_PROPERTY);
+        assert(parser.tryParse().code == ErrorCode::SCHEMA_MISSING_PROPERTY);
+        parser.checkSchema(nullptr, nullptr);
+        assert(parser.tryParse().ok());
+    }
+
+    std::cout << "Document tests passed!" << std::endl;
+}
+
+int main() {
+    test_compile();
+    test_scalars();
+    test_containers();
+    test_document();
+    std::cout << "All schema tests passed successfully!" << std::endl;
+    return 0;
+}
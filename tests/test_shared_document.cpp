@@ -0,0 +1,294 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shared_document.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+SharedValue parsed(const std::string& json) {
+    SharedValue value;
+    assert(SharedValue::parse(json, value).ok());
+    return value;
+}
+
+void test_reading() {
+    // Test case 1: Parsed values read like Document values
+    {
+        SharedValue root = parsed(
+            R"({"name": "svc", "port": 8080, "ratio": 0.5, "debug": false,
+                "hosts": ["a", "b"], "limits": {"cpu": 2}, "none": null})");
+        assert(root.isObject());
+        assert(root.size() == 7);
+        assert(root["name"].asString() == "svc");
+        assert(root["port"].asInt64() == 8080);
+        assert(root["ratio"].asDouble() == 0.5);
+        assert(root["debug"].type() == ValueType::BOOLEAN);
+        assert(!root["debug"].asBool());
+        assert(root["hosts"][1].asString() == "b");
+        assert(root["none"].isNull());
+        assert(!root["missing"].exists());
+        assert(!root["hosts"][2].exists());
+        assert(root.at("/limits/cpu").asInt64() == 2);
+        assert(root.at("/hosts/0").asString() == "a");
+        assert(root.at("").identical(root));
+        assert(!root.at("/hosts/x").exists());
+        assert(!root.at("hosts").exists());
+    }
+
+    // Test case 2: Iteration
+    {
+        SharedValue root = parsed(R"({"a": 1, "b": [2, 3]})");
+        std::string keys;
+        for (SharedValue::Iterator it = root.begin(); it != root.end(); ++it) {
+            keys += it.key().str();
+        }
+        assert(keys == "ab");
+        int64_t sum = 0;
+        SharedValue b = root["b"];  // Iterators point into their value
+        for (SharedValue::Iterator it = b.begin(); it != b.end(); ++it) {
+            sum += (*it).asInt64();
+            assert(it.key().empty());
+        }
+        assert(sum == 5);
+    }
+
+    // Test case 3: Values outlive the handle they were parsed into
+    {
+        SharedValue inner;
+        {
+            SharedValue root = parsed(R"({"deep": {"list": [1, 2, 3]}})");
+            inner = root["deep"]["list"];
+        }
+        assert(inner.size() == 3);
+        assert(inner[2].asInt64() == 3);
+    }
+
+    // Test case 4: Parse errors
+    {
+        SharedValue value = SharedValue::makeInt64(1);
+        assert(SharedValue::parse("[1, 2", value).code ==
+               ErrorCode::UNEXPECTED_END_OF_INPUT);
+        assert(value.asInt64() == 1);
+    }
+
+    std::cout << "Shared document reading tests passed!" << std::endl;
+}
+
+void test_updates() {
+    // Test case 1: Updates leave the old version alone
+    {
+        SharedValue v1 = parsed(R"({"a": {"b": 1, "c": [1, 2]}, "d": "x"})");
+        SharedValue v2;
+        assert(v1.set("/a/b", SharedValue::makeInt64(5), v2).ok());
+        assert(v1.at("/a/b").asInt64() == 1);
+        assert(v2.at("/a/b").asInt64() == 5);
+        assert(v2["d"].asString() == "x");
+        assert(v2.size() == 2);
+    }
+
+    // Test case 2: Only the containers on the path are copied
+    {
+        SharedValue v1 = parsed(
+            R"({"left": {"x": [1, 2, 3]}, "right": {"y": {"z": 1}, "w": 2}})");
+        SharedValue v2;
+        assert(v1.set("/right/y/z", SharedValue::makeBool(true), v2).ok());
+        assert(v2["left"].identical(v1["left"]));
+        assert(v2["right"]["w"].identical(v1["right"]["w"]));
+        assert(!v2["right"].identical(v1["right"]));
+        assert(!v2.at("/right/y").identical(v1.at("/right/y")));
+        assert(v2.at("/right/y/z").asBool());
+
+        // A second edit shares with the first edited version
+        SharedValue v3;
+        assert(v2.set("/left/x/0", SharedValue::makeNull(), v3).ok());
+        assert(v3["right"].identical(v2["right"]));
+        assert(v3.at("/left/x/0").isNull());
+        assert(v3.at("/left/x/1").identical(v1.at("/left/x/1")));
+    }
+
+    // Test case 3: Adding and removing members and elements
+    {
+        SharedValue v1 = parsed(R"({"list": [1, 2], "a/b": {"~": 0}})");
+        SharedValue v2;
+        assert(v1.set("/list/-", SharedValue::makeInt64(3), v2).ok());
+        assert(v2.set("/list/3", SharedValue::makeInt64(4), v2).ok());
+        assert(v2["list"].size() == 4);
+        assert(v2.at("/list/3").asInt64() == 4);
+        assert(v2.remove("/list/0", v2).ok());
+        assert(v2.at("/list/0").asInt64() == 2);
+        assert(v2["list"].size() == 3);
+
+        assert(v2.set("/a~1b/~0", SharedValue::makeString("t"), v2).ok());
+        assert(v2.at("/a~1b/~0").asString() == "t");
+        assert(v2.set("/new", SharedValue::makeArray(), v2).ok());
+        assert(v2.set("/new/0", SharedValue::makeObject(), v2).ok());
+        assert(v2.set("/new/0/k", SharedValue::makeDouble(1.5), v2).ok());
+        assert(v2.at("/new/0/k").asDouble() == 1.5);
+        assert(v2.remove("/a~1b", v2).ok());
+        assert(!v2["a/b"].exists());
+        assert(v2.size() == 2);
+
+        std::string keys;
+        for (SharedValue::Iterator it = v2.begin(); it != v2.end(); ++it) {
+            keys += it.key().str() + ",";
+        }
+        assert(keys == "list,new,");
+        assert(v1["list"].size() == 2);
+        assert(v1["a/b"]["~"].asInt64() == 0);
+
+        SharedValue replaced;
+        assert(v1.set("", SharedValue::makeInt64(7), replaced).ok());
+        assert(replaced.asInt64() == 7);
+        assert(v1.remove("", replaced).ok());
+        assert(!replaced.exists());
+    }
+
+    // Test case 4: Paths that lead nowhere
+    {
+        SharedValue v1 = parsed(R"({"a": {"b": [1]}, "s": "x"})");
+        SharedValue v2 = SharedValue::makeNull();
+        ParseResult result =
+            v1.set("/a/missing/c", SharedValue::makeNull(), v2);
+        assert(result.code == ErrorCode::PATH_NOT_FOUND);
+        assert(result.offset == 2);
+        assert(v1.set("/a/b/2", SharedValue::makeNull(), v2).code ==
+               ErrorCode::PATH_NOT_FOUND);
+        assert(v1.set("/a/b/01", SharedValue::makeNull(), v2).code ==
+               ErrorCode::PATH_NOT_FOUND);
+        assert(v1.set("/s/0", SharedValue::makeNull(), v2).code ==
+               ErrorCode::PATH_NOT_FOUND);
+        assert(v1.remove("/a/x", v2).code == ErrorCode::PATH_NOT_FOUND);
+        assert(v1.remove("/a/b/-", v2).code == ErrorCode::PATH_NOT_FOUND);
+        assert(v1.set("a", SharedValue::makeNull(), v2).code ==
+               ErrorCode::INVALID_JSON_POINTER);
+        result = v1.set("/a/~2", SharedValue::makeNull(), v2);
+        assert(result.code == ErrorCode::INVALID_JSON_POINTER);
+        assert(result.offset == 3);
+        assert(v2.isNull());
+    }
+
+    std::cout << "Shared document update tests passed!" << std::endl;
+}
+
+void test_shared_document() {
+    // Test case 1: Publishing versions
+    {
+        SharedDocument document;
+        assert(!document.current().exists());
+        assert(document.parse(R"({"version": 1, "workers": 4})").ok());
+        SharedValue before = document.current();
+        assert(document.set("/version", SharedValue::makeInt64(2)).ok());
+        assert(before["version"].asInt64() == 1);
+        assert(document.current()["version"].asInt64() == 2);
+        assert(document.current()["workers"].identical(before["workers"]));
+        assert(document.remove("/workers").ok());
+        assert(document.current().size() == 1);
+
+        assert(document.parse("{").code == ErrorCode::UNEXPECTED_END_OF_INPUT);
+        assert(document.current()["version"].asInt64() == 2);
+        assert(document.set("/a/b", SharedValue::makeNull()).code ==
+               ErrorCode::PATH_NOT_FOUND);
+    }
+
+    // Test case 2: Files
+    {
+        std::ofstream testFile(getTestFilePath("shared_test1.json"));
+        testFile << R"({"key": [1, 2, 3]})";
+        testFile.close();
+
+        SharedDocument document;
+        assert(document.parseFile(getTestFilePath("shared_test1.json")).ok());
+        assert(document.current().at("/key/2").asInt64() == 3);
+        assert(document.parseFile(getTestFilePath("missing.json")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+        assert(document.current().at("/key/2").asInt64() == 3);
+    }
+
+    // Test case 3: Readers always see a whole version while writers update
+    {
+        std::string json = R"({"a": 0, "b": 0, "big": [)";
+        for (int i = 0; i < 1000; i++) {
+            json += (i > 0 ? "," : "") + std::to_string(i);
+        }
+        json += "]}";
+        SharedDocument document;
+        assert(document.parse(json).ok());
+        SharedValue big = document.current()["big"];
+
+        const int kUpdates = 2000;
+        std::atomic<bool> done(false);
+        std::atomic<int> consistent(0);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([&]() {
+                int64_t last = 0;
+                do {
+                    SharedValue root = document.current();
+                    int64_t a = root["a"].asInt64();
+                    assert(root["b"].asInt64() == a);
+                    assert(a >= last);
+                    assert(root["big"].identical(big));
+                    last = a;
+                    consistent++;
+                } while (!done.load());
+            });
+        }
+
+        // Each update moves both fields together
+        for (int64_t i = 1; i <= kUpdates; i++) {
+            SharedValue updated;
+            SharedValue value = SharedValue::makeInt64(i);
+            assert(document.current().set("/a", value, updated).ok());
+            assert(updated.set("/b", value, updated).ok());
+            document.publish(updated);
+        }
+        done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        assert(consistent.load() > 0);
+        assert(document.current()["big"].identical(big));
+    }
+
+    // Test case 4: Concurrent set() calls are not lost
+    {
+        SharedDocument document;
+        assert(document.parse(R"({"counts": {}})").ok());
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++) {
+            writers.emplace_back([&document, t]() {
+                for (int i = 0; i < 100; i++) {
+                    std::string key = std::to_string(t) + "-" +
+                                      std::to_string(i);
+                    assert(document.set("/counts/" + key,
+                                        SharedValue::makeInt64(i))
+                               .ok());
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        assert(document.current()["counts"].size() == 400);
+        assert(document.current().at("/counts/3-99").asInt64() == 99);
+    }
+
+    std::cout << "Shared document publishing tests passed!" << std::endl;
+}
+
+int main() {
+    test_reading();
+    test_updates();
+    test_shared_document();
+    std::cout << "All shared document tests passed successfully!"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "shredder.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+void test_shred_records() {
+    std::string input =
+        "{\"id\": 1, \"name\": \"a\", \"user\": {\"age\": 30, \"ok\": true}}\n"
+        "\n"
+        "{\"id\": 2, \"user\": {\"age\": null}, \"tags\": [1, \"x\"]}\n"
+        "{\"id\": 3, \"name\": \"c\\td\", \"a/b\": false}\n";
+    Shredder shredder;
+    assert(shredder.addLines(input.data(), input.size()).ok());
+    assert(shredder.rowCount() == 3);
+
+    // Test case 1: Typed columns per leaf path
+    {
+        const Column* id = shredder.find("/id");
+        assert(id != nullptr);
+        assert(id->type() == ColumnType::INT64);
+        assert(id->size() == 3);
+        assert(id->int64At(2) == 3);
+        assert(id->nullCount() == 0);
+
+        const Column* ok = shredder.find("/user/ok");
+        assert(ok->type() == ColumnType::BOOL);
+        assert(ok->boolAt(0));
+        assert(ok->isNull(1) && ok->isNull(2));
+    }
+
+    // Test case 2: Missing fields and explicit nulls become nulls
+    {
+        const Column* name = shredder.find("/name");
+        assert(name->type() == ColumnType::STRING);
+        assert(name->stringAt(0) == "a");
+        assert(name->isNull(1));
+        assert(name->stringAt(1).empty());
+        assert(name->stringAt(2) == "c\td");
+
+        const Column* age = shredder.find("/user/age");
+        assert(age->type() == ColumnType::INT64);
+        assert(age->isNull(1) && age->isNull(2));
+        assert(age->nullCount() == 2);
+    }
+
+    // Test case 3: Arrays are kept as JSON text, keys escaped as pointers
+    {
+        const Column* tags = shredder.find("/tags");
+        assert(tags->type() == ColumnType::JSON);
+        assert(tags->isNull(0));
+        assert(tags->stringAt(1) == "[1, \"x\"]");
+
+        const Column* escaped = shredder.find("/a~1b");
+        assert(escaped != nullptr);
+        assert(!escaped->isNull(2) && !escaped->boolAt(2));
+    }
+
+    // Test case 4: Keys are predicted where records agree ("/id")
+    {
+        assert(shredder.keyShapes().lookups() == 12);
+        assert(shredder.keyShapes().hits() == 2);
+        shredder.clear();
+        assert(shredder.keyShapes().lookups() == 0);
+    }
+
+    std::cout << "Shredding tests passed!" << std::endl;
+}
+
+void test_widening() {
+    // Test case 1: Columns that start null take the first type
+    {
+        Shredder shredder;
+        std::string input = "{\"v\": null}\n{\"v\": null}\n{\"v\": 1.5}\n";
+        assert(shredder.addLines(input.data(), input.size()).ok());
+        const Column* v = shredder.find("/v");
+        assert(v->type() == ColumnType::DOUBLE);
+        assert(v->nullCount() == 2);
+        assert(v->doubleAt(2) == 1.5);
+    }
+
+    // Test case 2: INT64 widens to DOUBLE
+    {
+        Shredder shredder;
+        std::string input = "{\"v\": 1}\n{\"v\": 2.5}\n{\"v\": 3}\n";
+        assert(shredder.addLines(input.data(), input.size()).ok());
+        const Column* v = shredder.find("/v");
+        assert(v->type() == ColumnType::DOUBLE);
+        assert(v->doubleAt(0) == 1.0);
+        assert(v->doubleAt(1) == 2.5);
+        assert(v->doubleAt(2) == 3.0);
+    }
+
+    // Test case 3: Mixed types fall back to JSON text
+    {
+        Shredder shredder;
+        std::string input =
+            "{\"v\": true}\n{}\n{\"v\": 12}\n{\"v\": \"s\"}\n{\"v\": 1e2}\n";
+        assert(shredder.addLines(input.data(), input.size()).ok());
+        const Column* v = shredder.find("/v");
+        assert(v->type() == ColumnType::JSON);
+        assert(v->stringAt(0) == "true");
+        assert(v->isNull(1));
+        assert(v->stringAt(2) == "12");
+        assert(v->stringAt(3) == "\"s\"");
+        assert(v->stringAt(4) == "1e2");
+    }
+
+    // Test case 4: Strings and numbers stay apart in JSON columns. Values
+    // added after widening keep their text; earlier rows are written out
+    // again.
+    {
+        Shredder shredder;
+        std::string input =
+            "{\"v\": \"42\"}\n{\"v\": \"a\\\"b\\u00e9\"}\n{\"v\": 42}\n"
+            "{\"v\": \"42\"}\n{\"v\": 1.50}\n{\"v\": \"\\u0041\"}\n";
+        assert(shredder.addLines(input.data(), input.size()).ok());
+        const Column* v = shredder.find("/v");
+        assert(v->type() == ColumnType::JSON);
+        assert(v->stringAt(0) == "\"42\"");
+        assert(v->stringAt(1) == "\"a\\\"b\xc3\xa9\"");
+        assert(v->stringAt(2) == "42");
+        assert(v->stringAt(3) == "\"42\"");
+        assert(v->stringAt(4) == "1.50");
+        assert(v->stringAt(5) == "\"\\u0041\"");
+
+        Shredder doubles;
+        input = "{\"v\": 0.1}\n{\"v\": 1e400}\n{\"v\": 2.5e-3}\n{\"v\": []}\n";
+        assert(doubles.addLines(input.data(), input.size()).ok());
+        v = doubles.find("/v");
+        assert(v->type() == ColumnType::JSON);
+        assert(v->stringAt(0) == "0.1");
+        assert(v->stringAt(1) == "1e999");
+        assert(v->stringAt(2) == "0.0025");
+        assert(v->stringAt(3) == "[]");
+    }
+
+    // Test case 5: Duplicate keys keep the first value
+    {
+        Shredder shredder;
+        std::string input = "{\"v\": 1, \"v\": 2}";
+        assert(shredder.addLines(input.data(), input.size()).ok());
+        assert(shredder.find("/v")->size() == 1);
+        assert(shredder.find("/v")->int64At(0) == 1);
+    }
+
+    std::cout << "Widening tests passed!" << std::endl;
+}
+
+void test_invalid_records() {
+    // Test case 1: Invalid records add nothing; offsets cover the input
+    {
+        Shredder shredder;
+        std::string input = "{\"v\": 1}\n{\"v\": 2,}\n{\"v\": 3}\n";
+        ParseResult result = shredder.addLines(input.data(), input.size());
+        assert(result.code == ErrorCode::TRAILING_COMMA_IN_OBJECT);
+        assert(result.offset == input.find(",}") + 1);
+        assert(shredder.rowCount() == 1);
+        assert(shredder.find("/v")->size() == 1);
+    }
+
+    std::cout << "Invalid record tests passed!" << std::endl;
+}
+
+void test_columnar_file() {
+    std::string input =
+        "{\"i\": 1, \"d\": 0.5, \"b\": true, \"s\": \"x\"}\n"
+        "{\"i\": null, \"d\": 2, \"n\": null}\n"
+        "{\"i\": 3, \"b\": false, \"s\": \"yz\", \"j\": [1]}\n";
+    Shredder shredder;
+    assert(shredder.addLines(input.data(), input.size()).ok());
+    std::string path = getTestFilePath("shredder_test1.cols");
+
+    // Test case 1: Round trip
+    {
+        assert(shredder.write(path).ok());
+        Shredder loaded;
+        assert(loaded.read(path).ok());
+        assert(loaded.rowCount() == 3);
+        assert(loaded.columnCount() == shredder.columnCount());
+        assert(loaded.find("/i")->int64At(2) == 3);
+        assert(loaded.find("/i")->isNull(1));
+        assert(loaded.find("/i")->nullCount() == 1);
+        assert(loaded.find("/d")->doubleAt(1) == 2.0);
+        assert(loaded.find("/b")->boolAt(0) && !loaded.find("/b")->boolAt(2));
+        assert(loaded.find("/s")->stringAt(2) == "yz");
+        assert(loaded.find("/j")->type() == ColumnType::JSON);
+        assert(loaded.find("/j")->stringAt(2) == "[1]");
+        assert(loaded.find("/n")->type() == ColumnType::NULL_ONLY);
+        assert(loaded.find("/n")->nullCount() == 3);
+    }
+
+    // Test case 2: Damaged files are rejected
+    {
+        std::string bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in),
+                         std::istreambuf_iterator<char>());
+        }
+        std::string damaged = getTestFilePath("shredder_damaged.cols");
+        {
+            std::ofstream out(damaged, std::ios::binary);
+            out << bytes.substr(0, bytes.size() - 1);
+        }
+        Shredder loaded;
+        assert(loaded.read(damaged).code == ErrorCode::INVALID_COLUMN_FILE);
+        assert(loaded.columnCount() == 0);
+        assert(loaded.read(getTestFilePath("missing.cols")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+    }
+
+    std::cout << "Columnar file tests passed!" << std::endl;
+}
+
+int main() {
+    test_shred_records();
+    test_widening();
+    test_invalid_records();
+    test_columnar_file();
+    std::cout << "All shredder tests passed successfully!" << std::endl;
+    return 0;
+}
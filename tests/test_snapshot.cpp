@@ -0,0 +1,179 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "document.h"
+#include "snapshot.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+void test_round_trip() {
+    std::string json = R"({
+        "name": "catalog",
+        "version": 3,
+        "ratio": 0.75,
+        "items": [{"id": 1, "label": "café"}, {"id": 2, "label": null}],
+        "enabled": true
+    })";
+    Document doc;
+    assert(doc.parse(json).ok());
+    std::string path = getTestFilePath("snapshot_test1.snap");
+
+    // Test case 1: Write and map back
+    {
+        assert(Snapshot::write(doc.view(), path).ok());
+
+        Snapshot snapshot;
+        assert(snapshot.open(path).ok());
+        assert(snapshot.verify());
+        assert(snapshot.view().tapeSize == doc.view().tapeSize);
+
+        Value root = snapshot.root();
+        assert(root["name"].asString() == "catalog");
+        assert(root["version"].asInt64() == 3);
+        assert(root["ratio"].asDouble() == 0.75);
+        assert(root["items"].size() == 2);
+        assert(root["items"][0]["label"].asString() == "caf\xc3\xa9");
+        assert(root["items"][1]["label"].isNull());
+        assert(root["enabled"].asBool());
+    }
+
+    // Test case 2: Reopening replaces the previous mapping
+    {
+        Document other;
+        assert(other.parse("[1, 2, 3]").ok());
+        std::string otherPath = getTestFilePath("snapshot_test2.snap");
+        assert(Snapshot::write(other.view(), otherPath).ok());
+
+        Snapshot snapshot;
+        assert(snapshot.open(path).ok());
+        assert(snapshot.open(otherPath).ok());
+        assert(snapshot.root().size() == 3);
+        snapshot.close();
+        assert(snapshot.empty());
+        assert(!snapshot.root().exists());
+    }
+
+    // Test case 3: Large objects of a mapped snapshot are indexed in memory
+    {
+        std::string wide = "{";
+        for (int i = 0; i < 200; i++) {
+            wide += (i > 0 ? ", \"" : "\"") + std::to_string(i) +
+                    "\": " + std::to_string(i * 2);
+        }
+        wide += "}";
+        Document other;
+        assert(other.parse(wide).ok());
+        std::string widePath = getTestFilePath("snapshot_test3.snap");
+        assert(Snapshot::write(other.view(), widePath).ok());
+
+        Snapshot snapshot;
+        assert(snapshot.open(widePath).ok());
+        assert(snapshot.root()["150"].asInt64() == 300);
+        assert(!snapshot.root()["200"].exists());
+        assert(snapshot.view().objectIndex->tableCount() == 1);
+        assert(snapshot.verify());
+    }
+
+    std::cout << "Snapshot round trip tests passed!" << std::endl;
+}
+
+void test_damaged_snapshots() {
+    Document doc;
+    assert(doc.parse(R"({"key": "value"})").ok());
+    std::string path = getTestFilePath("snapshot_test3.snap");
+    assert(Snapshot::write(doc.view(), path).ok());
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    }
+    std::string damagedPath = getTestFilePath("snapshot_damaged.snap");
+    auto writeDamaged = [&](const std::string& contents) {
+        std::ofstream out(damagedPath, std::ios::binary);
+        out << contents;
+    };
+
+    // Test case 1: Missing file and not a snapshot
+    {
+        Snapshot snapshot;
+        assert(snapshot.open(getTestFilePath("missing.snap")).code ==
+               ErrorCode::CANNOT_OPEN_FILE);
+        writeDamaged("{\"key\": \"value\"}");
+        assert(snapshot.open(damagedPath).code == ErrorCode::INVALID_SNAPSHOT);
+    }
+
+    // Test case 2: Other format version
+    {
+        std::string copy = bytes;
+        copy[8] = 99;  // Version follows the 8-byte magic
+        writeDamaged(copy);
+        Snapshot snapshot;
+        assert(snapshot.open(damagedPath).code ==
+               ErrorCode::SNAPSHOT_VERSION_MISMATCH);
+    }
+
+    // Test case 3: Truncated file
+    {
+        writeDamaged(bytes.substr(0, bytes.size() - 3));
+        Snapshot snapshot;
+        assert(snapshot.open(damagedPath).code == ErrorCode::INVALID_SNAPSHOT);
+    }
+
+    // Test case 4: Flipped byte is caught by the checksum
+    {
+        std::string copy = bytes;
+        copy[copy.size() - 2] ^= 0x20;
+        writeDamaged(copy);
+        Snapshot snapshot;
+        assert(snapshot.open(damagedPath).ok());
+        assert(!snapshot.verify());
+    }
+
+    // Test case 5: Broken tape links fail verify(). The tape of
+    // {"key": "value"} follows the 48-byte header: the object start, two
+    // strings and the object end.
+    {
+        const size_t tape = 48;
+        auto rejected = [&](size_t at, char byte) {
+            std::string copy = bytes;
+            copy[at] = byte;
+            writeDamaged(copy);
+            Snapshot snapshot;
+            return snapshot.open(damagedPath).ok() && !snapshot.verify();
+        };
+        assert(rejected(tape, 7));           // End index past the tape
+        assert(rejected(tape, 2));           // End index at a string
+        assert(rejected(tape + 4, 5));       // Member count
+        assert(rejected(tape + 15, 'x'));    // Unknown tag
+        assert(rejected(tape + 16, 0x70));   // String offset
+        assert(rejected(tape + 15, 'n'));    // Key that is not a string
+        assert(rejected(tape + 24, 1));      // End linked to another start
+        assert(rejected(bytes.size() - 1, 'x'));  // String not terminated
+
+        // Fewer tape words in a header that still adds up. The checksum
+        // runs over both sections as one, so only the tape check catches it.
+        std::string copy = bytes;
+        copy[16] = 2;
+        copy[24] += 16;
+        writeDamaged(copy);
+        Snapshot snapshot;
+        assert(snapshot.open(damagedPath).ok());
+        assert(!snapshot.verify());
+    }
+
+    std::cout << "Damaged snapshot tests passed!" << std::endl;
+}
+
+int main() {
+    test_round_trip();
+    test_damaged_snapshots();
+    std::cout << "All snapshot tests passed successfully!" << std::endl;
+    return 0;
+}
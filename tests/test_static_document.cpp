@@ -0,0 +1,205 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "number.h"
+#include "static_document.h"
+
+STATIC_JSON_DOCUMENT(kConfig, R"({
+    "name": "service",
+    "port": 8080,
+    "ratio": 0.75,
+    "tls": true,
+    "hosts": ["a.example", "b.example"],
+    "limits": {"cpu": 2, "memory": null}
+})");
+
+// Parsed and laid out at compile time
+static_assert(kConfigLayout.result.ok(), "");
+static_assert(kConfigLayout.tapeSize == 25, "");
+static_assert(staticLayout("[1, 2,]", 7).result.code ==
+                  ErrorCode::TRAILING_COMMA_IN_ARRAY,
+              "");
+static_assert(staticLayout("{\"a\" 1}", 7).result.offset == 5, "");
+
+// Parses `json` both ways and compares the tapes and string areas
+bool matchesDocument(const std::string& json) {
+    StaticLayout layout = staticLayout(json.data(), json.size());
+    Document document;
+    ParseResult expected = document.parse(json);
+    if (layout.result.code != expected.code ||
+        layout.result.offset != expected.offset) {
+        return false;
+    }
+    if (!expected.ok()) {
+        return true;
+    }
+
+    std::vector<uint64_t> tape(layout.tapeSize);
+    std::vector<char> strings(layout.stringsSize);
+    StaticParser parser(json.data(), json.size(), tape.data(), tape.size(),
+                        strings.data(), strings.size());
+    const DocumentView& view = document.view();
+    return parser.run().ok() && view.tapeSize == tape.size() &&
+           view.stringsSize == strings.size() &&
+           memcmp(view.tape, tape.data(), tape.size() * 8) == 0 &&
+           memcmp(view.strings, strings.data(), strings.size()) == 0;
+}
+
+uint64_t strtodBits(const std::string& text) {
+    double value = parseDouble(text.data(), text.data() + text.size());
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool convertsLikeStrtod(const std::string& text) {
+    uint64_t bits = 0;
+    return parseDoubleBits(text.data(), text.data() + text.size(), bits) &&
+           bits == strtodBits(text);
+}
+
+void test_static_document() {
+    // Test case 1: Reading a document parsed at compile time
+    {
+        Value root = kConfig.root();
+        assert(root.isObject());
+        assert(root.size() == 6);
+        assert(root["name"].asString() == "service");
+        assert(root["port"].asInt64() == 8080);
+        assert(root["ratio"].asDouble() == 0.75);
+        assert(root["tls"].asBool());
+        assert(root["hosts"][1].asString() == "b.example");
+        assert(root["limits"]["cpu"].asInt64() == 2);
+        assert(root["limits"]["memory"].isNull());
+        assert(!root["missing"].exists());
+        assert(kConfig.view().objectIndex == nullptr);
+    }
+
+    // Test case 2: The tape matches Document's word for word
+    {
+        assert(matchesDocument(
+            R"({"esc": "tab\there \"q\" \\ \/ \b\f\n\r",
+                "uni": "\u00e9\u4e2d\ud83d\ude00 \ud800 x\udc00",
+                "raw": "é中😀", "empty": "", "": {},
+                "ints": [0, -0, 1, -1, 9223372036854775807,
+                         -9223372036854775808, 9223372036854775808],
+                "doubles": [0.5, -0.0, 1e2, 1E-2, 2.5e+3, 123.456e-7,
+                            1e400, -1e400, 5e-324, 1e-400],
+                "nested": [[[]], [{}], {"a": [true, false, null]}]})"));
+        assert(matchesDocument("  \"just a string\"  "));
+        assert(matchesDocument("-12.5e3"));
+        assert(matchesDocument("[]"));
+
+        std::string wide = "[";
+        for (int i = 0; i < 300; i++) {
+            wide += (i > 0 ? ",{\"k" : "{\"k") + std::to_string(i) +
+                    "\": " + std::to_string(i * 0.37) + "}";
+        }
+        wide += "]";
+        assert(matchesDocument(wide));
+    }
+
+    // Test case 3: Errors match Document::parse()
+    {
+        const char* inputs[] = {
+            "",           "   ",          "[1, 2",      "[1, 2,]",
+            "{\"a\": 1,}", "{\"a\" 1}",    "{1: 2}",     "[1] 2",
+            "[1 2]",      "{\"a\": 1]",   "]",          ":",
+            "[\"abc",     "[\"a\\x\"]",   "[\"\\u12g4\"]", "[\"a\\",
+            "[tru]",      "[nul",         "[truex]",    "[01]",
+            "[1.]",       "[1e+]",        "[1.2.3]",    "[-]",
+            "@",          "[\"\x01\"]",   "[\"\xff\"]", "[\"\xc3\"]",
+            "{\"a\": [1, {\"b\": }]}",    "[1,,2]",     "{,}",
+            "[1] ]",      "{\"a\":1 \"b\":2}", "[\"\xed\xa0\x80\"]",
+        };
+        for (const char* input : inputs) {
+            assert(matchesDocument(input));
+        }
+        // Lexical errors win over earlier grammar errors
+        StaticLayout layout = staticLayout("[1,] @", 6);
+        assert(layout.result.code == ErrorCode::INVALID_CHARACTER);
+        assert(layout.result.offset == 5);
+    }
+
+    std::cout << "Static document tests passed!" << std::endl;
+}
+
+void test_double_conversion() {
+    // Test case 1: Hard cases
+    {
+        const char* cases[] = {
+            "0.1",
+            "0.3",
+            "1e23",
+            "9007199254740993",
+            "9007199254740995",
+            "1.7976931348623157e308",
+            "1.7976931348623158e308",
+            "1.7976931348623159e308",
+            "2.2250738585072011e-308",
+            "2.2250738585072014e-308",
+            "4.9406564584124654e-324",
+            "2.4703282292062327e-324",
+            "2.4703282292062328e-324",
+            "7.4109846876186982e-324",
+            "-0.0",
+            "0e999999",
+            "1e-999999",
+            "123456789012345678901234567890",
+            "0.000000000000000000000000000001234",
+            "3.14159265358979323846264338327950288419716939937510",
+            "179769313486231580793728971405303415079934132710037826936173778"
+            "980444968292764750946649017977587207096330286416692887910946555"
+            "547851940402630657488671505820681908902000708383676273854845817"
+            "711531764475730270069855571366959622842914819860834936475292719"
+            "074168444365510704342711559699508093042880177904174497792",
+        };
+        for (const char* text : cases) {
+            assert(convertsLikeStrtod(text));
+        }
+        uint64_t bits = 0;
+        std::string tooLong(701, '1');
+        assert(!parseDoubleBits(tooLong.data(), tooLong.data() + 701, bits));
+    }
+
+    // Test case 2: Random numbers agree with strtod
+    {
+        std::mt19937_64 random(2024);
+        for (int i = 0; i < 20000; i++) {
+            std::string text = random() % 2 ? "-" : "";
+            size_t digits = 1 + random() % 25;
+            text += std::to_string(1 + random() % 9);
+            for (size_t d = 1; d < digits; d++) {
+                text += static_cast<char>('0' + random() % 10);
+            }
+            if (random() % 2) {
+                text.insert(text.size() - random() % digits, ".");
+                if (text.back() == '.' || text[text.size() - 1] == '-') {
+                    text += "0";
+                }
+                if (text[0] == '.' || (text[0] == '-' && text[1] == '.')) {
+                    text.insert(text[0] == '-' ? 1 : 0, "0");
+                }
+            }
+            int exponent = static_cast<int>(random() % 700) - 350;
+            text += "e" + std::to_string(exponent);
+            assert(convertsLikeStrtod(text));
+        }
+    }
+
+    std::cout << "Compile-time number conversion tests passed!" << std::endl;
+}
+
+int main() {
+    test_static_document();
+    test_double_conversion();
+    std::cout << "All static document tests passed successfully!"
+              << std::endl;
+    return 0;
+}
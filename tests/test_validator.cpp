@@ -0,0 +1,112 @@
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "validator.h"
+
+std::string getTestFilePath(const std::string& filename) {
+    return "tests/temp/" + filename;
+}
+
+void test_valid_documents() {
+    // Test case 1: Scalars and empty containers
+    {
+        assert(Validator::validate("{}").ok());
+        assert(Validator::validate("[]").ok());
+        assert(Validator::validate(R"("text")").ok());
+        assert(Validator::validate("-0.5e+10").ok());
+        assert(Validator::validate(" true ").ok());
+        assert(Validator::validate("null").ok());
+    }
+
+    // Test case 2: Nested containers
+    {
+        std::string json = R"({
+            "name": "John",
+            "tags": ["a", "b", {"deep": [1, 2.5, -3e2, false, null]}],
+            "escaped": "quote \" slash \/ unicode é"
+        })";
+        assert(Validator::validate(json).ok());
+    }
+
+    // Test case 3: Files
+    {
+        std::ofstream testFile(getTestFilePath("validator_test1.json"));
+        testFile << R"({"key": [1, 2, 3]})";
+        testFile.close();
+
+        assert(Validator::validateFile(getTestFilePath("validator_test1.json"))
+                   .ok());
+    }
+
+    std::cout << "Valid document tests passed!" << std::endl;
+}
+
+void test_invalid_documents() {
+    // Test case 1: Empty input
+    {
+        assert(Validator::validate("").code == ErrorCode::EMPTY_INPUT);
+        assert(Validator::validate("  \n").code == ErrorCode::EMPTY_INPUT);
+    }
+
+    // Test case 2: Trailing commas
+    {
+        ParseResult result = Validator::validate(R"({"a": 1,})");
+        assert(result.code == ErrorCode::TRAILING_COMMA_IN_OBJECT);
+        assert(result.offset == 8);
+        assert(Validator::validate("[1,]").code ==
+               ErrorCode::TRAILING_COMMA_IN_ARRAY);
+    }
+
+    // Test case 3: Structure errors
+    {
+        assert(Validator::validate(R"({1: 2})").code ==
+               ErrorCode::EXPECTED_STRING_KEY);
+        assert(Validator::validate(R"({"a" 1})").code ==
+               ErrorCode::EXPECTED_DIFFERENT_TOKEN);
+        assert(Validator::validate("[1}").code ==
+               ErrorCode::EXPECTED_DIFFERENT_TOKEN);
+        assert(Validator::validate("[1, 2").code ==
+               ErrorCode::UNEXPECTED_END_OF_INPUT);
+        assert(Validator::validate("{} {}").code ==
+               ErrorCode::EXPECTED_END_OF_INPUT);
+    }
+
+    // Test case 4: Lexical errors
+    {
+        assert(Validator::validate(R"("abc)").code ==
+               ErrorCode::UNTERMINATED_STRING);
+        assert(Validator::validate(R"("\a")").code ==
+               ErrorCode::INVALID_ESCAPE);
+        assert(Validator::validate(R"("\u12G4")").code ==
+               ErrorCode::INVALID_ESCAPE);
+        assert(Validator::validate("\"tab\there\"").code ==
+               ErrorCode::CONTROL_CHARACTER_IN_STRING);
+        assert(Validator::validate("012").code == ErrorCode::INVALID_NUMBER);
+        assert(Validator::validate("1.").code ==
+               ErrorCode::EXPECTED_FRACTION_DIGIT);
+        assert(Validator::validate("1e+").code ==
+               ErrorCode::EXPECTED_EXPONENT_DIGIT);
+        assert(Validator::validate("tru").code ==
+               ErrorCode::UNEXPECTED_EOF_IN_LITERAL);
+        assert(Validator::validate("nul1").code == ErrorCode::INVALID_LITERAL);
+        assert(Validator::validate("[1, @]").code ==
+               ErrorCode::INVALID_CHARACTER);
+    }
+
+    // Test case 5: Missing file
+    {
+        assert(Validator::validateFile(getTestFilePath("does_not_exist.json"))
+                   .code == ErrorCode::CANNOT_OPEN_FILE);
+    }
+
+    std::cout << "Invalid document tests passed!" << std::endl;
+}
+
+int main() {
+    test_valid_documents();
+    test_invalid_documents();
+    std::cout << "All validator tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -1,6 +1,10 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     // Literals
     STRING,
     NUMBER,
@@ -22,6 +26,8 @@ enum class TokenType {
 struct Token {
     TokenType type;
     std::string lexeme;
+    size_t offset;  // Byte offset of the token in the input
 
-    Token(TokenType t, std::string l) : type(t), lexeme(std::move(l)) {}
-};
\ No newline at end of file
+    Token(TokenType t, std::string l, size_t o = 0)
+        : type(t), lexeme(std::move(l)), offset(o) {}
+};
@@ -0,0 +1,87 @@
+#include "token_buffer.h"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define TOKEN_BUFFER_SSE2 1
+#endif
+
+static inline bool isScalar(uint8_t type) {
+    type &= ~TokenBuffer::kEscapesFlag;
+    return type <= static_cast<uint8_t>(TokenType::NULL_TOKEN);
+}
+
+constexpr uint8_t TokenBuffer::kEscapesFlag;
+constexpr size_t TokenBuffer::kBytesPerToken;
+
+void TokenBuffer::clear() {
+    tokenTypes.clear();
+    tokenOffsets.clear();
+    inputSize = 0;
+}
+
+void TokenBuffer::reserve(size_t count) {
+    tokenTypes.reserve(count);
+    tokenOffsets.reserve(count);
+}
+
+void TokenBuffer::splice(size_t first, size_t last,
+                         const TokenBuffer& replacement, int64_t shift) {
+    tokenTypes.erase(tokenTypes.begin() + first, tokenTypes.begin() + last);
+    tokenTypes.insert(tokenTypes.begin() + first,
+                      replacement.tokenTypes.begin(),
+                      replacement.tokenTypes.end());
+    tokenOffsets.erase(tokenOffsets.begin() + first,
+                       tokenOffsets.begin() + last);
+    tokenOffsets.insert(tokenOffsets.begin() + first,
+                        replacement.tokenOffsets.begin(),
+                        replacement.tokenOffsets.end());
+
+    uint32_t delta = static_cast<uint32_t>(shift);  // Wraps for negative shifts
+    for (size_t i = first + replacement.size(); i < tokenOffsets.size(); i++) {
+        tokenOffsets[i] += delta;
+    }
+}
+
+size_t TokenBuffer::scalarCommaPairs(size_t index) const {
+    const uint8_t* types = tokenTypes.data();
+    const uint8_t comma = static_cast<uint8_t>(TokenType::COMMA);
+    size_t size = tokenTypes.size();
+    size_t i = index;
+
+#if TOKEN_BUFFER_SSE2
+    const __m128i scalarLimit =
+        _mm_set1_epi8(static_cast<char>(TokenType::NULL_TOKEN) + 1);
+    const __m128i commas = _mm_set1_epi8(static_cast<char>(comma));
+    const __m128i evenLanes = _mm_set1_epi16(0x00FF);
+    while (i + 16 <= size) {
+        __m128i t =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(types + i));
+        // Even lanes must hold a scalar, odd lanes a comma. The signed
+        // compare also counts strings carrying kEscapesFlag as scalars.
+        __m128i scalars = _mm_and_si128(_mm_cmplt_epi8(t, scalarLimit),
+                                        evenLanes);
+        __m128i separators =
+            _mm_andnot_si128(evenLanes, _mm_cmpeq_epi8(t, commas));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_or_si128(scalars, separators)));
+        if (mask != 0xFFFF) {
+            i += __builtin_ctz(~mask) & ~1u;  // Whole pairs only
+            return (i - index) / 2;
+        }
+        i += 16;
+    }
+#endif
+
+    while (i + 1 < size && isScalar(types[i]) && types[i + 1] == comma) {
+        i += 2;
+    }
+    return (i - index) / 2;
+}
+
+size_t TokenBuffer::memoryUsage() const {
+    return tokenTypes.capacity() * sizeof(uint8_t) +
+           tokenOffsets.capacity() * sizeof(uint32_t);
+}
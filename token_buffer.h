@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "token.h"
+
+// Compact token stream produced by the Lexer. Each token is one type byte
+// plus a 32-bit offset into the input, stored in separate arrays so a scan
+// over the types touches only one byte per token. Lexemes are not stored;
+// they can be recovered from the input at the recorded offset. String
+// tokens carry a flag in the type byte saying whether the body contains
+// any backslash escapes.
+//
+// The arrays are allocated from the memory resource given at construction
+// (see MemoryAccount). A copy uses the default resource; a move keeps it.
+class TokenBuffer {
+   public:
+    explicit TokenBuffer(std::pmr::memory_resource* memory =
+                             std::pmr::get_default_resource())
+        : tokenTypes(memory), tokenOffsets(memory), inputSize(0) {}
+
+    void push(TokenType type, uint32_t offset, bool hasEscapes = false) {
+        tokenTypes.push_back(static_cast<uint8_t>(type) |
+                             (hasEscapes ? kEscapesFlag : 0));
+        tokenOffsets.push_back(offset);
+    }
+
+    void pop() {
+        tokenTypes.pop_back();
+        tokenOffsets.pop_back();
+    }
+
+    size_t size() const { return tokenTypes.size(); }
+    bool empty() const { return tokenTypes.empty(); }
+    void clear();
+    void reserve(size_t count);
+
+    TokenType type(size_t index) const {
+        return static_cast<TokenType>(tokenTypes[index] & ~kEscapesFlag);
+    }
+    bool hasEscapes(size_t index) const {
+        return (tokenTypes[index] & kEscapesFlag) != 0;
+    }
+    uint32_t offset(size_t index) const { return tokenOffsets[index]; }
+
+    const uint8_t* typeData() const { return tokenTypes.data(); }
+    const uint32_t* offsetData() const { return tokenOffsets.data(); }
+
+    // Length of the tokenized input, used to report errors at end of input
+    uint32_t endOffset() const { return inputSize; }
+    void setEndOffset(uint32_t size) { inputSize = size; }
+
+    // Replaces tokens [first, last) with those of `replacement` and moves the
+    // offsets of the tokens after them by `shift` bytes. Linear in the number
+    // of tokens after `last`.
+    void splice(size_t first, size_t last, const TokenBuffer& replacement,
+                int64_t shift);
+
+    // Number of consecutive "scalar ," pairs starting at `index`, where a
+    // scalar is a string, number or literal. Compares 16 type bytes at a
+    // time where SSE2 is available.
+    size_t scalarCommaPairs(size_t index) const;
+
+    // Heap bytes reserved for the token arrays
+    size_t memoryUsage() const;
+
+    std::pmr::memory_resource* resource() const {
+        return tokenTypes.get_allocator().resource();
+    }
+
+    // Set in the raw type byte of strings containing a backslash
+    static constexpr uint8_t kEscapesFlag = 0x80;
+    static constexpr size_t kBytesPerToken = sizeof(uint8_t) + sizeof(uint32_t);
+
+   private:
+    std::pmr::vector<uint8_t> tokenTypes;
+    std::pmr::vector<uint32_t> tokenOffsets;
+    uint32_t inputSize;
+};
@@ -0,0 +1,296 @@
+#include "validator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "char_class.h"
+#include "input.h"
+#include "kernels.h"
+
+namespace {
+
+// Where we are in the grammar, i.e. what the next significant byte may be
+enum State : uint8_t {
+    S_VALUE,         // Top level or after ':'
+    S_ARRAY_FIRST,   // After '['
+    S_ARRAY_NEXT,    // After ',' inside an array
+    S_OBJECT_FIRST,  // After '{'
+    S_OBJECT_NEXT,   // After ',' inside an object
+    S_COLON,         // After an object key
+    S_AFTER_VALUE,   // After a complete value
+    S_COUNT,
+};
+
+enum Action : uint8_t {
+    A_SKIP,
+    A_OPEN_OBJECT,
+    A_OPEN_ARRAY,
+    A_CLOSE_OBJECT,
+    A_CLOSE_ARRAY,
+    A_STRING,
+    A_KEY,
+    A_NUMBER,
+    A_TRUE,
+    A_FALSE,
+    A_NULL,
+    A_COLON,
+    A_COMMA,
+
+    // Rejections
+    E_INVALID_CHARACTER,
+    E_UNEXPECTED_TOKEN,
+    E_EXPECTED_KEY,
+    E_TRAILING_COMMA_OBJECT,
+    E_TRAILING_COMMA_ARRAY,
+    E_EXPECTED_TOKEN,
+};
+
+// Transition table indexed by [State][CharClass]. Column order follows the
+// CharClass enum: other, ws, { } [ ] : , " number t f n
+const uint8_t kTransitions[S_COUNT][CC_COUNT] = {
+    // S_VALUE
+    {E_INVALID_CHARACTER, A_SKIP, A_OPEN_OBJECT, E_UNEXPECTED_TOKEN,
+     A_OPEN_ARRAY, E_UNEXPECTED_TOKEN, E_UNEXPECTED_TOKEN, E_UNEXPECTED_TOKEN,
+     A_STRING, A_NUMBER, A_TRUE, A_FALSE, A_NULL},
+    // S_ARRAY_FIRST
+    {E_INVALID_CHARACTER, A_SKIP, A_OPEN_OBJECT, E_UNEXPECTED_TOKEN,
+     A_OPEN_ARRAY, A_CLOSE_ARRAY, E_UNEXPECTED_TOKEN, E_UNEXPECTED_TOKEN,
+     A_STRING, A_NUMBER, A_TRUE, A_FALSE, A_NULL},
+    // S_ARRAY_NEXT
+    {E_INVALID_CHARACTER, A_SKIP, A_OPEN_OBJECT, E_UNEXPECTED_TOKEN,
+     A_OPEN_ARRAY, E_TRAILING_COMMA_ARRAY, E_UNEXPECTED_TOKEN,
+     E_UNEXPECTED_TOKEN, A_STRING, A_NUMBER, A_TRUE, A_FALSE, A_NULL},
+    // S_OBJECT_FIRST
+    {E_INVALID_CHARACTER, A_SKIP, E_EXPECTED_KEY, A_CLOSE_OBJECT,
+     E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, A_KEY,
+     E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY},
+    // S_OBJECT_NEXT
+    {E_INVALID_CHARACTER, A_SKIP, E_EXPECTED_KEY, E_TRAILING_COMMA_OBJECT,
+     E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, A_KEY,
+     E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY, E_EXPECTED_KEY},
+    // S_COLON
+    {E_INVALID_CHARACTER, A_SKIP, E_EXPECTED_TOKEN, E_EXPECTED_TOKEN,
+     E_EXPECTED_TOKEN, E_EXPECTED_TOKEN, A_COLON, E_EXPECTED_TOKEN,
+     E_EXPECTED_TOKEN, E_EXPECTED_TOKEN, E_EXPECTED_TOKEN, E_EXPECTED_TOKEN,
+     E_EXPECTED_TOKEN},
+    // S_AFTER_VALUE
+    {E_INVALID_CHARACTER, A_SKIP, E_EXPECTED_TOKEN, A_CLOSE_OBJECT,
+     E_EXPECTED_TOKEN, A_CLOSE_ARRAY, E_EXPECTED_TOKEN, A_COMMA,
+     E_EXPECTED_TOKEN, E_EXPECTED_TOKEN, E_EXPECTED_TOKEN, E_EXPECTED_TOKEN,
+     E_EXPECTED_TOKEN},
+};
+
+// Cursor over the input that records the first failure
+struct Scanner {
+    const char* begin;
+    const char* p;
+    const char* end;
+    const Kernels& scan;
+    ParseResult error;
+
+    bool fail(ErrorCode code, const char* at, char detail = '\0') {
+        error = ParseResult(code, at - begin, detail);
+        return false;
+    }
+
+    // p points just past the opening quote
+    bool scanString() {
+        while (true) {
+            p += scan.scanString(p, end - p);
+            if (p == end) {
+                return fail(ErrorCode::UNTERMINATED_STRING, p);
+            }
+
+            switch (stringCharClass(*p)) {
+                case SC_PLAIN:
+                    break;  // scanString never stops here
+                case SC_QUOTE:
+                    p++;
+                    return true;
+                case SC_CONTROL:
+                    return fail(ErrorCode::CONTROL_CHARACTER_IN_STRING, p);
+                case SC_BACKSLASH:
+                    if (!scanEscape()) {
+                        return false;
+                    }
+                    break;
+            }
+        }
+    }
+
+    bool scanEscape() {
+        if (++p == end) {
+            return fail(ErrorCode::UNTERMINATED_STRING, p);
+        }
+        switch (*p) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                p++;
+                return true;
+            case 'u':
+                for (int i = 1; i <= 4; i++) {
+                    if (p + i == end || !isHexDigit(p[i])) {
+                        return fail(ErrorCode::INVALID_ESCAPE, p, 'u');
+                    }
+                }
+                p += 5;
+                return true;
+            default:
+                return fail(ErrorCode::INVALID_ESCAPE, p, *p);
+        }
+    }
+
+    bool scanNumber() {
+        NumberState state = matchNumber(p, end);
+        if (state != NS_DONE) {
+            return fail(numberError(state), p);
+        }
+        return true;
+    }
+
+    bool scanLiteral(const char* literal, size_t length) {
+        size_t remaining = end - p;
+        if (remaining >= length && memcmp(p, literal, length) == 0) {
+            p += length;
+            return true;
+        }
+        if (remaining < length && memcmp(p, literal, remaining) == 0) {
+            return fail(ErrorCode::UNEXPECTED_EOF_IN_LITERAL, end, literal[0]);
+        }
+        return fail(ErrorCode::INVALID_LITERAL, p, literal[0]);
+    }
+};
+
+}  // namespace
+
+ParseResult Validator::validate(const char* data, size_t size) {
+    Scanner scanner = {data, data, data + size, kernels(), ParseResult()};
+
+    size_t invalid = scanner.scan.validateUtf8(data, size);
+    if (invalid != size) {
+        return ParseResult(ErrorCode::INVALID_UTF8, invalid);
+    }
+
+    std::vector<uint8_t> stack;  // CC_LEFT_BRACE / CC_LEFT_BRACKET
+    uint8_t state = S_VALUE;
+    bool ok = true;
+
+    while (ok && scanner.p < scanner.end) {
+        const char* at = scanner.p;
+        uint8_t action = kTransitions[state][kCharClass[(uint8_t)*at]];
+
+        // Only whitespace may follow the top-level value
+        if (state == S_AFTER_VALUE && stack.empty() && action != A_SKIP) {
+            return ParseResult(ErrorCode::EXPECTED_END_OF_INPUT, at - data);
+        }
+
+        switch (action) {
+            case A_SKIP:
+                scanner.p += scanner.scan.skipWhitespace(at, scanner.end - at);
+                break;
+            case A_OPEN_OBJECT:
+                stack.push_back(CC_LEFT_BRACE);
+                scanner.p++;
+                state = S_OBJECT_FIRST;
+                break;
+            case A_OPEN_ARRAY:
+                stack.push_back(CC_LEFT_BRACKET);
+                scanner.p++;
+                state = S_ARRAY_FIRST;
+                break;
+            case A_CLOSE_OBJECT:
+            case A_CLOSE_ARRAY: {
+                uint8_t open = action == A_CLOSE_OBJECT ? CC_LEFT_BRACE
+                                                        : CC_LEFT_BRACKET;
+                if (stack.back() != open) {
+                    ok = scanner.fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN, at);
+                    break;
+                }
+                stack.pop_back();
+                scanner.p++;
+                state = S_AFTER_VALUE;
+                break;
+            }
+            case A_STRING:
+            case A_KEY:
+                scanner.p++;
+                ok = scanner.scanString();
+                state = action == A_KEY ? S_COLON : S_AFTER_VALUE;
+                break;
+            case A_NUMBER:
+                ok = scanner.scanNumber();
+                state = S_AFTER_VALUE;
+                break;
+            case A_TRUE:
+                ok = scanner.scanLiteral("true", 4);
+                state = S_AFTER_VALUE;
+                break;
+            case A_FALSE:
+                ok = scanner.scanLiteral("false", 5);
+                state = S_AFTER_VALUE;
+                break;
+            case A_NULL:
+                ok = scanner.scanLiteral("null", 4);
+                state = S_AFTER_VALUE;
+                break;
+            case A_COLON:
+                scanner.p++;
+                state = S_VALUE;
+                break;
+            case A_COMMA:
+                scanner.p++;
+                state = stack.back() == CC_LEFT_BRACE ? S_OBJECT_NEXT
+                                                      : S_ARRAY_NEXT;
+                break;
+            case E_INVALID_CHARACTER:
+                ok = scanner.fail(ErrorCode::INVALID_CHARACTER, at, *at);
+                break;
+            case E_UNEXPECTED_TOKEN:
+                ok = scanner.fail(ErrorCode::UNEXPECTED_TOKEN, at);
+                break;
+            case E_EXPECTED_KEY:
+                ok = scanner.fail(ErrorCode::EXPECTED_STRING_KEY, at);
+                break;
+            case E_TRAILING_COMMA_OBJECT:
+                ok = scanner.fail(ErrorCode::TRAILING_COMMA_IN_OBJECT, at);
+                break;
+            case E_TRAILING_COMMA_ARRAY:
+                ok = scanner.fail(ErrorCode::TRAILING_COMMA_IN_ARRAY, at);
+                break;
+            default:
+                ok = scanner.fail(ErrorCode::EXPECTED_DIFFERENT_TOKEN, at);
+                break;
+        }
+    }
+
+    if (!ok) {
+        return scanner.error;
+    }
+    if (state == S_AFTER_VALUE && stack.empty()) {
+        return ParseResult();
+    }
+    if (state == S_VALUE && stack.empty()) {
+        return ParseResult(ErrorCode::EMPTY_INPUT, size);
+    }
+    return ParseResult(ErrorCode::UNEXPECTED_END_OF_INPUT, size);
+}
+
+ParseResult Validator::validate(const std::string& json) {
+    return validate(json.data(), json.size());
+}
+
+ParseResult Validator::validateFile(const std::string& filePath) {
+    std::string contents;
+    if (!readFile(filePath, contents)) {
+        return ParseResult(ErrorCode::CANNOT_OPEN_FILE, 0);
+    }
+    return validate(contents);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "error.h"
+
+// Answers "is this valid JSON?" in a single pass without producing tokens.
+// Character classification and the grammar state machine are fused into one
+// table-driven loop; the only memory used is a stack of open containers.
+class Validator {
+   public:
+    static ParseResult validate(const char* data, size_t size);
+    static ParseResult validate(const std::string& json);
+    static ParseResult validateFile(const std::string& filePath);
+};